@@ -1,16 +1,31 @@
 #include <SFML/Graphics.hpp>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <string>
 #include <vector>
-#include <regex>
+#include <map>
+#include <optional>
+#include "src/calendar.h"
 #include "src/get_data.h"
+#include "src/neo_fetcher.h"
+#include "src/response_cache.h"
+#include "src/neo_client.h"
+#include "src/feed_crawler.h"
+#include "src/prefetcher.h"
+#include "src/neo_details.h"
+#include "src/approach_history.h"
+#include "src/feed_benchmark.h"
+#include "src/feed_ingest.h"
+#include "src/catalog_index.h"
+#include "src/catalog_segments.h"
+#include "src/mapped_file.h"
 #include "src/planets.h"
 #include <cstdlib>
 #include <fstream>
 #include <exception>
+#include <filesystem>
 #include <iomanip>
-#include <sstream>
 
 using namespace std;
 
@@ -64,41 +79,27 @@ private:
 // Function to validate date input (3 tries allowed)
 string validateDateInput() {
     string date;
-    regex datePattern(R"(\d{4}-\d{2}-\d{2})");
 
     for (int attempts = 1; attempts <= 3; ++attempts) {
         cin >> date;
-        if (regex_match(date, datePattern)) {
-            // Further validation to check if the date is logical
-            stringstream ss(date);
-            string token;
-            vector<int> dateParts;
-
-            while (getline(ss, token, '-')) {
-                dateParts.push_back(stoi(token));
-            }
-
-            int year = dateParts[0];
-            int month = dateParts[1];
-            int day = dateParts[2];
-
-            if (year < 1900 || year > 2100) {
-                cerr << "Year must be between 1900 and 2100. Please enter again. (" << attempts << "/3 tries)" << endl;
-            } else if (month < 1 || month > 12) {
-                cerr << "Month must be between 1 and 12. Please enter again. (" << attempts << "/3 tries)" << endl;
-            } else if (day < 1 || day > 31) {
-                cerr << "Day must be between 1 and 31. Please enter again. (" << attempts << "/3 tries)" << endl;
-            } else if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) {
-                cerr << "The entered month has only 30 days. Please enter again. (" << attempts << "/3 tries)" << endl;
-            } else if (month == 2 && day > 29) {
-                cerr << "February cannot have more than 29 days. Please enter again. (" << attempts << "/3 tries)" << endl;
-            } else if (month == 2 && day == 29 && !((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0))) {
-                cerr << "Entered year is not a leap year, February has only 28 days. Please enter again. (" << attempts << "/3 tries)" << endl;
-            } else {
-                return date; // Valid date
-            }
-        } else {
+        CivilDate civil;
+        DateCheck check = check_date(date, civil);
+        if (check == DateCheck::BAD_FORMAT) {
             cerr << "Invalid date format. Please enter a date in the format YYYY-MM-DD. (" << attempts << "/3 tries)" << endl;
+        } else if (civil.year < 1900 || civil.year > 2100) {
+            cerr << "Year must be between 1900 and 2100. Please enter again. (" << attempts << "/3 tries)" << endl;
+        } else if (check == DateCheck::BAD_MONTH) {
+            cerr << "Month must be between 1 and 12. Please enter again. (" << attempts << "/3 tries)" << endl;
+        } else if (check == DateCheck::BAD_DAY) {
+            cerr << "Day must be between 1 and 31. Please enter again. (" << attempts << "/3 tries)" << endl;
+        } else if (check == DateCheck::PAST_MONTH_END && civil.month != 2) {
+            cerr << "The entered month has only 30 days. Please enter again. (" << attempts << "/3 tries)" << endl;
+        } else if (check == DateCheck::PAST_MONTH_END && civil.day > 29) {
+            cerr << "February cannot have more than 29 days. Please enter again. (" << attempts << "/3 tries)" << endl;
+        } else if (check == DateCheck::PAST_MONTH_END) {
+            cerr << "Entered year is not a leap year, February has only 28 days. Please enter again. (" << attempts << "/3 tries)" << endl;
+        } else {
+            return date; // Valid date
         }
         if (attempts == 3) {
             throw runtime_error("Exceeded the maximum number of attempts for date input.");
@@ -107,6 +108,15 @@ string validateDateInput() {
     return ""; // Default return to prevent compilation issues (logic will always return before this line)
 }
 
+// Function to report whether a feed came from the local cache or the network
+void printFetchSource(const FetchResult& response) {
+    if (response.from_cache) {
+        cout << "Loaded NEO data from local cache." << endl;
+    } else {
+        cout << "Request timing: " << describe_timing(response.timing) << endl;
+    }
+}
+
 // Function to create and manage the slider
 void drawSlider(sf::RenderWindow& window, sf::RectangleShape& slider, sf::RectangleShape& handle, float& timeElapsed) {
     // Event handling for dragging the slider
@@ -202,28 +212,17 @@ public:
         cout << "Asteroid " << name << " copied." << endl;
     }
 
-    Asteroid(const json& asteroidData)
-        : SpaceBody(
-            asteroidData["name"],
-            asteroidData["estimated_diameter"]["kilometers"]["estimated_diameter_min"].get<double>(),
-            calculateMass(asteroidData)
-          ),
-          id(asteroidData["id"]),
-          nasa_jpl_url(asteroidData["nasa_jpl_url"]),
-          absolute_magnitude(asteroidData["absolute_magnitude_h"]),
-          isDangerous(asteroidData["is_potentially_hazardous_asteroid"]) {
-        auto diameter = asteroidData["estimated_diameter"];
-        minDiameterKm = diameter["kilometers"]["estimated_diameter_min"].get<double>();
-        maxDiameterKm = diameter["kilometers"]["estimated_diameter_max"].get<double>();
-
-        auto close_approach = asteroidData["close_approach_data"][0];
-        closeApproachDate = close_approach["close_approach_date"];
-        relativeVelocityKmPerS = stod(close_approach["relative_velocity"]["kilometers_per_second"].get<string>());
-        missDistanceKm = stod(close_approach["miss_distance"]["kilometers"].get<string>());
-
-        missDistanceKm = std::max(missDistanceKm / 2.0, EARTH_RADIUS * 2);
-        mass = calculateMass(asteroidData);
-    }
+    Asteroid(const NeoRecord& record)
+        : SpaceBody(record.name, record.diameter_km_min, calculateMass(record.diameter_km_min, record.diameter_km_max)),
+          id(record.id),
+          nasa_jpl_url(record.nasa_jpl_url),
+          absolute_magnitude(record.absolute_magnitude_h),
+          minDiameterKm(record.diameter_km_min),
+          maxDiameterKm(record.diameter_km_max),
+          isDangerous(record.is_potentially_hazardous),
+          closeApproachDate(record.approach.date),
+          relativeVelocityKmPerS(record.approach.velocity_km_s),
+          missDistanceKm(std::max(record.approach.miss_km / 2.0, EARTH_RADIUS * 2)) {}
 
     void printInfo() const {
         cout << "Asteroid ID: " << id << endl;
@@ -232,7 +231,7 @@ public:
         cout << "Absolute Magnitude (H): " << absolute_magnitude << endl;
         cout << "Diameter (Min): " << minDiameterKm << " km, Max: " << maxDiameterKm << " km" << endl;
         cout << "Is Potentially Hazardous: " << (isDangerous ? "Yes" : "No") << endl;
-        cout << "Close Approach Date: " << closeApproachDate << endl;
+        cout << "Close Approach Date: " << format_date(closeApproachDate) << endl;
         cout << "Relative Velocity: " << relativeVelocityKmPerS << " km/s" << endl;
         cout << "Miss Distance: " << missDistanceKm << " km" << endl;
         cout << "Mass: " << mass << " kg" << endl;
@@ -244,7 +243,7 @@ public:
         // Write asteroid information to the CSV file using FileHandler
         string data = id + "," + name + "," + nasa_jpl_url + "," + to_string(absolute_magnitude) + "," +
                       to_string(minDiameterKm) + "," + to_string(maxDiameterKm) + "," +
-                      (isDangerous ? "Yes" : "No") + "," + closeApproachDate + "," +
+                      (isDangerous ? "Yes" : "No") + "," + format_date(closeApproachDate) + "," +
                       to_string(relativeVelocityKmPerS) + "," + to_string(missDistanceKm) + "," +
                       to_string(mass) + "," + to_string(calculateSurfaceGravity()) + "," +
                       to_string(calculateImpactEnergy()) + "\n";
@@ -283,14 +282,14 @@ private:
     double minDiameterKm;
     double maxDiameterKm;
     bool isDangerous;
-    string closeApproachDate;
+    Date closeApproachDate;
     double relativeVelocityKmPerS;
     double missDistanceKm;
 
-    static double calculateMass(const json& asteroidData) {
+    static double calculateMass(double minDiameterKm, double maxDiameterKm) {
         const double density = 3000.0;
-        double diameterMin_m = asteroidData["estimated_diameter"]["kilometers"]["estimated_diameter_min"].get<double>() * 1000.0;
-        double diameterMax_m = asteroidData["estimated_diameter"]["kilometers"]["estimated_diameter_max"].get<double>() * 1000.0;
+        double diameterMin_m = minDiameterKm * 1000.0;
+        double diameterMax_m = maxDiameterKm * 1000.0;
 
         double radiusMin = diameterMin_m / 2.0;
         double radiusMax = diameterMax_m / 2.0;
@@ -419,9 +418,434 @@ void handlePlanetOptions(Asteroid& asteroid, FileHandler& fileHandler) {
     }
 }
 
-int main() {
+// Function to print the command-line usage
+void printUsage() {
+    cout << "Usage:\n"
+         << "  NEOAnalyzer                               Interactive NEO analysis\n"
+         << "  NEOAnalyzer --crawl START_DATE [END_DATE]  Crawl the feed into the local cache\n"
+         << "  NEOAnalyzer --crawl-browse                 Crawl the whole catalog via the browse endpoint\n"
+         << "  NEOAnalyzer --details START_DATE [END_DATE] Look up orbits of every NEO in a date range\n"
+         << "  NEOAnalyzer --approaches [MAX_AU] [FIRST_YEAR] [LAST_YEAR]\n"
+         << "                                            Close approaches in the local detail store (0.05, 2000-2100)\n"
+         << "  NEOAnalyzer --hazardous START_DATE [END_DATE] List potentially hazardous NEOs in a date range\n"
+         << "  NEOAnalyzer --lookup ID [SNAPSHOT]         Every feed record of one NEO in a snapshot (data.neosnap)\n"
+         << "  NEOAnalyzer --ingest DIR|PATTERN [THREADS] [--project[=FIELDS]] [--snapshot=FILE]\n"
+         << "                                            Decode archived feed files in parallel into one catalog\n"
+         << "  NEOAnalyzer --merge STORE DIR|PATTERN [--project=FIELDS]\n"
+         << "                                            Append feed files to a segmented catalog in STORE\n"
+         << "  NEOAnalyzer --bench-decode [FILE] [SCALE]   Benchmark feed decoding (default data.json, x1000)\n"
+         << "  NEOAnalyzer --bench-numbers [FILE]          Check and benchmark number conversion\n"
+         << "  NEOAnalyzer --bench-projection [FILE] [SCALE] Check projected catalogs and their memory (x100)\n"
+         << "  NEOAnalyzer --bench-errors [FILE] [SCALE]   Decode a feed with 5% malformed records (x100)\n"
+         << "  NEOAnalyzer --bench-snapshot [FILE] [SCALE] Check a catalog snapshot and time opening it (x1000)\n"
+         << "  NEOAnalyzer --bench-index [FILE] [SCALE]    Check the snapshot id and epoch indexes and time lookups (x1000)\n"
+         << "  NEOAnalyzer --bench-segments [FILE] [FEEDS] Append weekly feeds to a segmented catalog (500)\n"
+         << "  NEOAnalyzer --bench-approaches [OBJECTS] [APPROACHES] Query approach histories (5000 x 200)\n"
+         << "  NEOAnalyzer --bench-compression [OBJECTS] [APPROACHES] Compress approach histories (5000 x 200)\n";
+}
+
+// Function to print bytes on the wire and on disk for the fetched days, with totals
+void printTransferStats(const map<string, DayTransferStats>& days) {
+    if (days.empty()) {
+        return;
+    }
+    DayTransferStats total;
+    bool perDay = getenv("NEO_PRINT_METRICS") != nullptr;
+    if (perDay) {
+        cout << left << setw(12) << "Date" << right << setw(12) << "Wire" << setw(12) << "Body" << setw(12) << "Disk" << endl;
+    }
+    for (const auto& [date, day] : days) {
+        if (perDay) {
+            cout << left << setw(12) << date << right << setw(12) << day.wire_bytes << setw(12) << day.body_bytes
+                 << setw(12) << day.disk_bytes << endl;
+        }
+        total.wire_bytes += day.wire_bytes;
+        total.body_bytes += day.body_bytes;
+        total.disk_bytes += day.disk_bytes;
+    }
+    double body = static_cast<double>(max<uint64_t>(total.body_bytes, 1));
+    cout << fixed << setprecision(1) << "Transferred " << total.wire_bytes << " bytes for " << total.body_bytes
+         << " bytes of JSON (" << 100.0 * total.wire_bytes / body << "%), stored " << total.disk_bytes << " bytes on disk ("
+         << 100.0 * total.disk_bytes / body << "%)." << endl;
+}
+
+// Function to tell whether a command requests data from the NASA API and so needs an API key
+bool commandUsesApi(const string& command) {
+    return command == "--crawl" || command == "--crawl-browse" || command == "--hazardous" || command == "--details";
+}
+
+// Function to run a non-interactive command given on the command line
+int runCommand(const vector<string>& args, NeoClient& neoClient) {
+    const string& command = args[0];
+    if (command == "--crawl" || command == "--crawl-browse") {
+        CrawlOptions options;
+        string startUrl;
+        if (command == "--crawl") {
+            if (args.size() < 2) {
+                printUsage();
+                return 1;
+            }
+            startUrl = feed_crawl_start_url(args[1], neoClient.api_key());
+            // Without an end date the crawl stops at today's page; links.next runs on forever
+            options.stop_date = args.size() > 2 ? args[2] : today_utc();
+        } else {
+            startUrl = browse_crawl_start_url(neoClient.api_key());
+            options.checkpoint_path = "crawl_browse_checkpoint.json";
+        }
+
+        // Browse pages carry the full per-object record, so they go straight into the detail store
+        DetailStore detailStore(default_detail_store_path(neoClient.cache().options()));
+        FeedCrawler crawler(neoClient.scheduler(), neoClient.api_key(), options);
+        CrawlProgress progress = crawler.crawl(startUrl, [&](const FetchResult& page) {
+            size_t objects = 0;
+            if (command == "--crawl") {
+                objects = neoClient.store_page(page);
+            } else {
+                for (const auto& object : json::parse(page.body)["near_earth_objects"]) {
+                    detailStore.put(parse_neo_detail(object));
+                    ++objects;
+                }
+            }
+            cout << "." << flush;
+            return objects;
+        });
+        cout << "\nCrawled " << progress.pages << " pages, " << progress.objects << " objects"
+             << (progress.finished ? "." : " (unfinished, run again to resume).") << endl;
+        printTransferStats(neoClient.transfer_stats());
+        return 0;
+    }
+
+    if (command == "--bench-decode") {
+        string path = args.size() > 1 ? args[1] : "data.json";
+        size_t scale = args.size() > 2 ? stoul(args[2]) : 1000;
+        cout << format_decode_benchmark(run_decode_benchmark(path, scale));
+        return 0;
+    }
+
+    if (command == "--bench-numbers") {
+        NumberBenchmark result = run_number_benchmark(args.size() > 1 ? args[1] : "data.json");
+        cout << format_number_benchmark(result);
+        return result.mismatches == 0 ? 0 : 1;
+    }
+
+    if (command == "--bench-errors") {
+        size_t scale = args.size() > 2 ? stoul(args[2]) : 100;
+        ErrorBenchmark result = run_error_benchmark(args.size() > 1 ? args[1] : "data.json", scale, 5);
+        cout << format_error_benchmark(result);
+        return result.consistent ? 0 : 1;
+    }
+
+    if (command == "--bench-projection") {
+        size_t scale = args.size() > 2 ? stoul(args[2]) : 100;
+        ProjectionBenchmark result = run_projection_benchmark(args.size() > 1 ? args[1] : "data.json", scale);
+        cout << format_projection_benchmark(result);
+        return result.output_mismatches == 0 && result.record_mismatches == 0 ? 0 : 1;
+    }
+
+    if (command == "--bench-snapshot") {
+        size_t scale = args.size() > 2 ? stoul(args[2]) : 1000;
+        string snapshotPath = (filesystem::temp_directory_path() / "neo_bench.neosnap").string();
+        SnapshotBenchmark result = run_snapshot_benchmark(args.size() > 1 ? args[1] : "data.json", scale, snapshotPath);
+        filesystem::remove(snapshotPath);
+        cout << format_snapshot_benchmark(result);
+        return result.verified && result.mismatches == 0 ? 0 : 1;
+    }
+
+    if (command == "--bench-index") {
+        size_t scale = args.size() > 2 ? stoul(args[2]) : 1000;
+        string snapshotPath = (filesystem::temp_directory_path() / "neo_bench_index.neosnap").string();
+        IndexBenchmark result = run_index_benchmark(args.size() > 1 ? args[1] : "data.json", scale, snapshotPath);
+        filesystem::remove(snapshotPath);
+        cout << format_index_benchmark(result);
+        return result.verified && result.stale_rejected && result.mismatches == 0 ? 0 : 1;
+    }
+
+    if (command == "--lookup") {
+        if (args.size() < 2) {
+            printUsage();
+            return 1;
+        }
+        string snapshotPath = args.size() > 2 ? args[2] : "data.neosnap";
+        CatalogSnapshot snapshot;
+        if (!snapshot.open(snapshotPath)) {
+            cout << "Could not open " << snapshotPath << "; write one with --ingest DIR --snapshot=FILE." << endl;
+            return 1;
+        }
+        // The index is built once and kept next to the snapshot; a stale or damaged one is rebuilt
+        string indexPath = catalog_index_path(snapshotPath);
+        CatalogIndex index;
+        bool opened = false;
+        try {
+            opened = index.open(indexPath, snapshot);
+        } catch (const SnapshotError& e) {
+            cout << e.what() << "; rebuilding the index." << endl;
+        }
+        if (!opened) {
+            write_catalog_index(snapshot, indexPath);
+            index.open(indexPath, snapshot);
+        }
+        vector<size_t> objects = index.find(args[1]);
+        for (size_t i : objects) {
+            cout << "\n" << format_date(snapshot.date_of(i)) << endl;
+            output_neo_data(snapshot, i);
+        }
+        cout << "\n" << objects.size() << " records of NEO " << args[1] << " in " << snapshotPath << "." << endl;
+        return objects.empty() ? 1 : 0;
+    }
+
+    if (command == "--bench-segments") {
+        size_t feeds = args.size() > 2 ? stoul(args[2]) : 500;
+        string directory = (filesystem::temp_directory_path() / "neo_bench_segments").string();
+        SegmentBenchmark result = run_segment_benchmark(args.size() > 1 ? args[1] : "data.json", feeds, directory);
+        cout << format_segment_benchmark(result);
+        return result.inconsistent_views == 0 && result.mismatches == 0 && result.reopened_mismatches == 0 ? 0 : 1;
+    }
+
+    if (command == "--merge") {
+        if (args.size() < 3) {
+            printUsage();
+            return 1;
+        }
+        vector<string> paths = expand_feed_paths(args[2]);
+        if (paths.empty()) {
+            cout << "No feed files match " << args[2] << endl;
+            return 1;
+        }
+        ProjectionOptions projection;
+        for (size_t i = 3; i < args.size(); ++i) {
+            if (args[i].rfind("--project=", 0) == 0) {
+                projection.fields = parse_projected_fields(args[i].substr(10));
+            }
+        }
+        SegmentedCatalog store(args[1], projection);
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        size_t failures = 0, malformed = 0;
+        for (const auto& path : paths) {
+            MappedFile file;
+            try {
+                if (!file.open(path)) {
+                    throw runtime_error("Could not open file");
+                }
+                malformed += store.add_feed(file.contents()).size();
+            } catch (const exception& e) {
+                cout << "Skipped " << path << ": " << e.what() << endl;
+                ++failures;
+            }
+        }
+        store.flush();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        shared_ptr<const CatalogView> view = store.view();
+        cout << "Merged " << paths.size() - failures << " files in " << fixed << setprecision(1) << ms << " ms ("
+             << malformed << " malformed records skipped)." << endl;
+        if (view->day_count() > 0) {
+            cout << "Catalog holds " << view->size() << " objects from " << format_date(view->day(0)) << " to "
+                 << format_date(view->day(view->day_count() - 1)) << "." << endl;
+        }
+        store.compact();
+        cout << format_segment_stats(store.stats()) << endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    if (command == "--ingest") {
+        if (args.size() < 2) {
+            printUsage();
+            return 1;
+        }
+        vector<string> paths = expand_feed_paths(args[1]);
+        if (paths.empty()) {
+            cout << "No feed files match " << args[1] << endl;
+            return 1;
+        }
+        IngestOptions options;
+        optional<ProjectionOptions> projection;
+        string snapshotPath;
+        for (size_t i = 2; i < args.size(); ++i) {
+            if (args[i].rfind("--snapshot=", 0) == 0) {
+                // A snapshot is written from the projected catalog
+                snapshotPath = args[i].substr(11);
+                if (!projection) projection = ProjectionOptions();
+            } else if (args[i].rfind("--project", 0) == 0) {
+                projection = ProjectionOptions();
+                if (args[i].size() > 9 && args[i][9] == '=') {
+                    projection->fields = parse_projected_fields(args[i].substr(10));
+                }
+            } else {
+                options.threads = stoul(args[i]);
+            }
+        }
+        IngestReport report;
+        if (projection) {
+            ProjectedCatalog catalog = ingest_projected_files(paths, options, *projection, report);
+            cout << format_ingest_report(report);
+            if (!catalog.dates().empty()) {
+                cout << "Catalog spans " << catalog.dates().front() << " to " << catalog.dates().back() << ", "
+                     << fixed << setprecision(1) << catalog.memory_bytes() / double(max<size_t>(1, catalog.size()))
+                     << " bytes per object (" << catalog.rule_exceptions() << " values stored explicitly)." << endl;
+            }
+            if (!snapshotPath.empty()) {
+                write_catalog_snapshot(catalog, snapshotPath);
+                cout << "Wrote snapshot " << snapshotPath << " (" << filesystem::file_size(snapshotPath) << " bytes)." << endl;
+                // The id and epoch indexes go next to it, so lookups do not build them at startup
+                CatalogSnapshot snapshot;
+                if (snapshot.open(snapshotPath)) {
+                    write_catalog_index(snapshot, catalog_index_path(snapshotPath));
+                }
+            }
+            return report.failures.empty() ? 0 : 1;
+        }
+        DecodedFeed catalog = ingest_feed_files(paths, options, report);
+        cout << format_ingest_report(report);
+        if (!catalog.dates.empty()) {
+            cout << "Catalog spans " << catalog.dates.front() << " to " << catalog.dates.back() << "." << endl;
+        }
+        return report.failures.empty() ? 0 : 1;
+    }
+
+    if (command == "--hazardous") {
+        if (args.size() < 2) {
+            printUsage();
+            return 1;
+        }
+        string startDate = args[1];
+        string endDate = args.size() > 2 ? args[2] : startDate;
+        neoClient.backfill(startDate, endDate);
+
+        // Only the hazard flag, id and name of every object are read
+        FieldExtractor fields({"is_potentially_hazardous_asteroid", "id", "name"});
+        vector<string_view> values;
+        size_t objects = 0;
+        size_t hazardous = 0;
+        for (Date day : DateRange(parse_date(startDate), parse_date(endDate))) {
+            string date = format_date(day);
+            string body = neoClient.get_feed_day(date, RequestPriority::Background).body;
+            FeedIndex index(body);
+            for (const NeoCursor& neo : index.objects(date)) {
+                ++objects;
+                fields.extract(neo, values);
+                if (decode_flag(values[0])) {
+                    cout << date << "  " << decode_text(values[1]) << "  " << decode_text(values[2]) << endl;
+                    ++hazardous;
+                }
+            }
+        }
+        cout << hazardous << " of " << objects << " NEOs between " << startDate << " and " << endDate
+             << " are potentially hazardous." << endl;
+        return 0;
+    }
+
+    if (command == "--bench-approaches") {
+        size_t objects = args.size() > 1 ? stoul(args[1]) : 5000;
+        size_t approaches = args.size() > 2 ? stoul(args[2]) : 200;
+        ApproachBenchmark result = run_approach_benchmark(objects, approaches);
+        cout << format_approach_benchmark(result);
+        return result.consistent ? 0 : 1;
+    }
+
+    if (command == "--bench-compression") {
+        size_t objects = args.size() > 1 ? stoul(args[1]) : 5000;
+        size_t approaches = args.size() > 2 ? stoul(args[2]) : 200;
+        CompressionBenchmark result = run_compression_benchmark(objects, approaches);
+        cout << format_compression_benchmark(result);
+        bool exact = true;
+        for (const auto& column : result.columns) exact = exact && column.exact;
+        return exact && result.consistent ? 0 : 1;
+    }
+
+    if (command == "--approaches") {
+        ApproachQuery query;
+        query.max_miss_au = args.size() > 1 ? stod(args[1]) : 0.05;
+        set_year_range(query, args.size() > 2 ? stoi(args[2]) : 2000, args.size() > 3 ? stoi(args[3]) : 2100);
+        DetailStore detailStore(default_detail_store_path(neoClient.cache().options()));
+        ApproachHistory history;
+        detailStore.for_each([&history](const NeoDetail& detail) { history.add(detail); });
+        query.body = history.body_code("Earth");
+        if (query.body < 0) {
+            cout << "The local detail store has no approaches to Earth; run --details or --crawl-browse first." << endl;
+            return 1;
+        }
+        vector<size_t> rows = find_approaches(history, query);
+        cout << left << setw(12) << "ID" << setw(20) << "Approach (UTC)" << right << setw(12) << "Miss (AU)"
+             << setw(14) << "Speed (km/s)" << endl;
+        for (size_t row : rows) {
+            CloseApproach approach = history.approach(row);
+            cout << left << setw(12) << history.id(history.object_of(row)) << setw(20) << approach.date_full << right
+                 << fixed << setprecision(6) << setw(12) << approach.miss_au << setprecision(3) << setw(14)
+                 << approach.velocity_km_s << endl;
+        }
+        cout << rows.size() << " of " << history.size() << " approaches by " << history.object_count()
+             << " objects are within " << setprecision(3) << query.max_miss_au << " AU of Earth." << endl;
+        return 0;
+    }
+
+    if (command == "--details") {
+        if (args.size() < 2) {
+            printUsage();
+            return 1;
+        }
+        string startDate = args[1];
+        string endDate = args.size() > 2 ? args[2] : startDate;
+        neoClient.backfill(startDate, endDate);
+
+        // Every id in the range, in feed order; the same object can approach on several days
+        vector<string> ids;
+        for (Date day : DateRange(parse_date(startDate), parse_date(endDate))) {
+            string date = format_date(day);
+            string body = neoClient.get_feed_day(date, RequestPriority::Background).body;
+            FeedIndex index(body);
+            for (const NeoCursor& neo : index.objects(date)) {
+                ids.push_back(neo.id());
+            }
+        }
+
+        DetailStore detailStore(default_detail_store_path(neoClient.cache().options()));
+        DetailLookup detailLookup(neoClient, detailStore);
+        auto started = chrono::steady_clock::now();
+        map<string, NeoDetail> details = detailLookup.lookup(ids, RequestPriority::Background);
+        double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+
+        cout << left << setw(12) << "ID" << setw(28) << "Name" << setw(7) << "Class" << right << setw(9) << "a (AU)"
+             << setw(8) << "e" << setw(9) << "i (deg)" << setw(12) << "Period (d)" << setw(11) << "Approaches" << endl;
+        for (const auto& [id, detail] : details) {
+            cout << left << setw(12) << id << setw(28) << detail.name.substr(0, 27) << setw(7) << detail.orbit.orbit_class
+                 << right << fixed << setprecision(3) << setw(9) << detail.orbit.semi_major_axis_au << setw(8)
+                 << detail.orbit.eccentricity << setw(9) << detail.orbit.inclination_deg << setprecision(1) << setw(12)
+                 << detail.orbit.orbital_period_days << setw(11) << detail.approaches.size() << endl;
+        }
+        DetailLookupStats stats = detailLookup.stats();
+        cout << setprecision(1) << stats.requested << " ids (" << stats.duplicates << " duplicates): " << stats.from_store
+             << " from the local store, " << stats.fetched << " fetched, " << stats.failed << " failed in "
+             << elapsedMs << " ms." << endl;
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
     try {
-        loadEnvFile(".env");
+        // Commands that only read local files run without a .env file or an API key
+        bool usesApi = argc < 2 || commandUsesApi(argv[1]);
+        if (usesApi || filesystem::exists(".env")) {
+            loadEnvFile(".env");
+        }
+        ResponseCache responseCache(cache_options_from_env());
+
+        const char* apiKeyEnv = getenv("API_KEY");
+        string apiKey = apiKeyEnv ? apiKeyEnv : "";
+
+        if (usesApi && apiKey.empty()) {
+            throw DataProcessingException("API key is missing. Please set the API_KEY environment variable.");
+        }
+
+        RequestScheduler scheduler(shared_fetcher(), scheduler_options_from_env());
+        NeoClient neoClient(scheduler, responseCache, apiKey, latency_options_from_env());
+
+        if (argc > 1) {
+            return runCommand(vector<string>(argv + 1, argv + argc), neoClient);
+        }
+
+        Prefetcher prefetcher(neoClient);
         FileHandler fileHandler("../user_discovered.csv");
 
         // Write the column headers to the file
@@ -433,35 +857,36 @@ int main() {
             cout << "Enter a date (YYYY-MM-DD) to search for NEOs: ";
             string selectedDate = validateDateInput();
 
-            const char* apiKeyEnv = getenv("API_KEY");
-            string apiKey = apiKeyEnv ? apiKeyEnv : "";
-
-            if (apiKey.empty()) {
-                throw DataProcessingException("API key is missing. Please set the API_KEY environment variable.");
-            }
-
-            json jsonData;
-            json selectedNeoJson;
-            string neo_data = fetch_neo_data(selectedDate, apiKey);
-
-            if (neo_data.empty()) {
-                cout << "Failed to fetch data from NASA API. Loading data from file..." << endl;
-                if (!load_from_file(jsonData, "data.json")) {
+            optional<NeoRecord> selectedNeo;
+            prefetcher.record_lookup(selectedDate);
+            shared_ptr<const FeedDay> day = neoClient.get_feed_records(selectedDate);
+            printFetchSource(day->response);
+            prefetcher.prefetch_around(selectedDate);
+
+            if (day->response.status != 200) {
+                cout << "Failed to fetch data from NASA API (HTTP " << day->response.status
+                     << "). Loading data from file..." << endl;
+                // A catalog snapshot opens without parsing; the feed text is the fallback
+                CatalogSnapshot catalog;
+                MappedFeed snapshot;
+                if (catalog.open("data.neosnap")) {
+                    selectedNeo = select_neo_record(catalog, selectedDate);
+                } else if (snapshot.load("data.json")) {
+                    selectedNeo = select_neo_record(snapshot.feed(), selectedDate);
+                } else {
                     throw DataProcessingException("Failed to load data from file.");
                 }
-                selectedNeoJson = process_neo_data(jsonData, selectedDate);
             } else {
                 try {
-                    jsonData = json::parse(neo_data);
-                    selectedNeoJson = process_neo_data(jsonData, selectedDate);
+                    selectedNeo = select_neo_record(day->feed, selectedDate);
                 } catch (const std::runtime_error& e) {
                     throw runtime_error(std::string(e.what()));
                 }
             }
 
-            if (!selectedNeoJson.empty()) {
+            if (selectedNeo) {
                 try {
-                    Asteroid asteroid1(selectedNeoJson);
+                    Asteroid asteroid1(*selectedNeo);
                     asteroid1.printInfoToFile(fileHandler);
 
                     bool asteroidMenu = true;
@@ -492,14 +917,16 @@ int main() {
                                 asteroid1.printInfo();
                                 cout << "\nEnter a second date (YYYY-MM-DD) to search for NEOs: ";
                                 string selectedDate2 = validateDateInput();
-                                string neo_data2 = fetch_neo_data(selectedDate2, apiKey);
+                                prefetcher.record_lookup(selectedDate2);
+                                shared_ptr<const FeedDay> day2 = neoClient.get_feed_records(selectedDate2);
+                                printFetchSource(day2->response);
+                                prefetcher.prefetch_around(selectedDate2);
 
-                                if (!neo_data2.empty()) {
-                                    jsonData = json::parse(neo_data2);
-                                    json selectedNeoJson2 = process_neo_data(jsonData, selectedDate2);
+                                if (day2->response.status == 200) {
+                                    optional<NeoRecord> selectedNeo2 = select_neo_record(day2->feed, selectedDate2);
 
-                                    if (!selectedNeoJson2.empty()) {
-                                        Asteroid asteroid2(selectedNeoJson2);
+                                    if (selectedNeo2) {
+                                        Asteroid asteroid2(*selectedNeo2);
                                         asteroid2.printInfo();
                                         asteroid2.printInfoToFile(fileHandler);
 
@@ -546,6 +973,18 @@ int main() {
             cin >> mainChoice;
             if (mainChoice == 'n' || mainChoice == 'N') {
                 continueAnalyzing = false;
+                CacheStats stats = responseCache.stats();
+                cout << "Cache: " << stats.memory_hits + stats.disk_hits << " hits (" << stats.memory_hits << " memory, "
+                     << stats.disk_hits << " disk, " << stats.negative_hits << " empty dates), " << stats.misses
+                     << " misses, " << neoClient.coalesced_requests() << " coalesced requests." << endl;
+                LookupStats lookups = neoClient.lookup_stats();
+                cout << fixed << setprecision(1) << "Date lookups: " << lookups.lookups << ", p50 " << lookups.p50_ms
+                     << " ms, p99 " << lookups.p99_ms << " ms (" << lookups.hedged << " hedged, " << lookups.hedge_wins
+                     << " answered by the hedge, " << lookups.local_wins << " answered locally while refreshing)." << endl;
+                cout << format_prefetch_report(prefetcher.stats(), prefetcher.history(), getenv("NEO_PRINT_METRICS") != nullptr);
+                if (getenv("NEO_PRINT_METRICS")) {
+                    cout << format_metrics(scheduler.metrics());
+                }
                 cout << "Exiting the NEO Analyzer. Goodbye!" << endl;
             }
         }
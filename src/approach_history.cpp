@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <stdexcept>
+#include "approach_history.h"
+#include "calendar.h"
+
+using namespace std;
+
+namespace {
+
+// The columns a query reads, held in locals so the scan loops vectorize
+struct QueryScan {
+    const int64_t* epochs;
+    const double* missAu;
+    const uint8_t* bodies;
+    int64_t from;
+    int64_t to;
+    double maxMiss;
+    bool anyBody;
+    uint8_t body;
+
+    QueryScan(const int64_t* epochColumn, const double* missColumn, const uint8_t* bodyColumn, const ApproachQuery& query)
+        : epochs(epochColumn), missAu(missColumn), bodies(bodyColumn), from(query.from_ms), to(query.to_ms),
+          maxMiss(query.max_miss_au), anyBody(query.body < 0), body(static_cast<uint8_t>(query.body)) {}
+
+    QueryScan(const ApproachHistory& history, const ApproachQuery& query)
+        : QueryScan(history.epochs(), history.miss_au(), history.bodies(), query) {}
+
+    // 1 when the row matches, else 0, from comparisons only
+    size_t matches(size_t row) const {
+        return static_cast<size_t>((epochs[row] >= from) & (epochs[row] < to) & (missAu[row] <= maxMiss) &
+                                   (anyBody | (bodies[row] == body)));
+    }
+
+    // Rows of [0, count) whose epoch is in range, ignoring the other conditions
+    size_t in_range(size_t count) const {
+        size_t found = 0;
+        for (size_t row = 0; row < count; ++row) {
+            found += static_cast<size_t>((epochs[row] >= from) & (epochs[row] < to));
+        }
+        return found;
+    }
+};
+
+// Function to decode each block of a compressed history and hand its scan to visit(scan, count,
+// firstRow); blocks without an epoch in range are skipped before their miss distances are decoded
+template <typename Visit>
+void scan_blocks(const CompressedApproachHistory& history, const ApproachQuery& query, Visit visit) {
+    int64_t epochs[SERIES_BLOCK];
+    double missAu[SERIES_BLOCK];
+    for (size_t block = 0; block < history.block_count(); ++block) {
+        size_t firstRow = block * SERIES_BLOCK;
+        size_t count = decode_timestamp_block(history.epochs(), block, epochs);
+        QueryScan scan(epochs, missAu, history.bodies() + firstRow, query);
+        if (scan.in_range(count) == 0) continue;
+        decode_double_block(history.miss_au(), block, missAu);
+        visit(scan, count, firstRow);
+    }
+}
+
+} // namespace
+
+void ApproachHistory::add(const NeoDetail& detail) {
+    add(detail.id, detail.approaches);
+}
+
+void ApproachHistory::add(const string& id, const vector<CloseApproach>& approaches) {
+    // Every body code is resolved before a row is appended, so a failure leaves the columns and
+    // the object ranges as they were
+    vector<uint8_t> codes;
+    codes.reserve(approaches.size());
+    size_t knownBodies = bodyNames_.size();
+    for (const auto& approach : approaches) {
+        size_t code = 0;
+        while (code < bodyNames_.size() && bodyNames_[code] != approach.orbiting_body) ++code;
+        if (code == bodyNames_.size()) {
+            if (code > UINT8_MAX) {
+                bodyNames_.resize(knownBodies);
+                throw invalid_argument("Too many orbiting bodies");
+            }
+            bodyNames_.push_back(approach.orbiting_body);
+        }
+        codes.push_back(static_cast<uint8_t>(code));
+    }
+
+    for (size_t i = 0; i < approaches.size(); ++i) {
+        epochs_.push_back(approaches[i].epoch_ms);
+        velocities_.push_back(approaches[i].velocity_km_s);
+        missAu_.push_back(approaches[i].miss_au);
+        bodies_.push_back(codes[i]);
+    }
+    objectOf_[id] = ids_.size();
+    ids_.push_back(id);
+    offsets_.push_back(epochs_.size());
+}
+
+size_t ApproachHistory::object_of(size_t row) const {
+    // The last object that begins at or before row; objects without approaches begin where the
+    // next one does, and upper_bound steps past them
+    return static_cast<size_t>(upper_bound(offsets_.begin(), offsets_.end(), row) - offsets_.begin()) - 1;
+}
+
+size_t ApproachHistory::find(const string& id) const {
+    auto found = objectOf_.find(id);
+    return found == objectOf_.end() ? ids_.size() : found->second;
+}
+
+int ApproachHistory::body_code(string_view name) const {
+    for (size_t code = 0; code < bodyNames_.size(); ++code) {
+        if (bodyNames_[code] == name) return static_cast<int>(code);
+    }
+    return -1;
+}
+
+CloseApproach ApproachHistory::approach(size_t row) const {
+    CloseApproach approach;
+    approach.epoch_ms = epochs_[row];
+    approach.date = date_of_epoch_ms(epochs_[row]);
+    approach.date_full = format_approach_time(epochs_[row]);
+    approach.velocity_km_s = velocities_[row];
+    approach.miss_au = missAu_[row];
+    approach.orbiting_body = bodyNames_[bodies_[row]];
+    return approach;
+}
+
+size_t ApproachHistory::memory_bytes() const {
+    // Rough per-node cost of the id map: node, hash bucket and the key
+    const size_t HASH_NODE_BYTES = 48;
+    size_t bytes = sizeof(*this);
+    for (const auto& id : ids_) bytes += sizeof(string) + id.capacity() + HASH_NODE_BYTES + id.capacity();
+    bytes += offsets_.capacity() * sizeof(size_t);
+    bytes += epochs_.capacity() * sizeof(int64_t) + velocities_.capacity() * sizeof(double);
+    bytes += missAu_.capacity() * sizeof(double) + bodies_.capacity();
+    for (const auto& body : bodyNames_) bytes += sizeof(string) + body.capacity();
+    return bytes;
+}
+
+void set_year_range(ApproachQuery& query, int firstYear, int lastYear) {
+    query.from_ms = epoch_ms_of(date_from_civil(firstYear, 1, 1));
+    query.to_ms = epoch_ms_of(date_from_civil(lastYear + 1, 1, 1));
+}
+
+vector<size_t> find_approaches(const ApproachHistory& history, const ApproachQuery& query) {
+    // Every row is written and the cursor advances only past matches, so the loop has no branch
+    QueryScan scan(history, query);
+    vector<size_t> rows(history.size() + 1);
+    size_t found = 0;
+    for (size_t row = 0; row < history.size(); ++row) {
+        rows[found] = row;
+        found += scan.matches(row);
+    }
+    rows.resize(found);
+    return rows;
+}
+
+size_t count_approaches(const ApproachHistory& history, const ApproachQuery& query) {
+    QueryScan scan(history, query);
+    size_t found = 0;
+    for (size_t row = 0, rows = history.size(); row < rows; ++row) {
+        found += scan.matches(row);
+    }
+    return found;
+}
+
+CompressedApproachHistory::CompressedApproachHistory(const ApproachHistory& history)
+    : epochs_(encode_timestamps(history.epochs(), history.size())),
+      velocities_(encode_doubles(history.velocities_km_s(), history.size())),
+      missAu_(encode_doubles(history.miss_au(), history.size())),
+      bodies_(history.bodies(), history.bodies() + history.size()) {}
+
+size_t CompressedApproachHistory::bytes() const {
+    return epochs_.bytes() + velocities_.bytes() + missAu_.bytes() + bodies_.size();
+}
+
+vector<size_t> find_approaches(const CompressedApproachHistory& history, const ApproachQuery& query) {
+    vector<size_t> rows;
+    size_t block[SERIES_BLOCK + 1];
+    scan_blocks(history, query, [&](const QueryScan& scan, size_t count, size_t firstRow) {
+        size_t found = 0;
+        for (size_t row = 0; row < count; ++row) {
+            block[found] = firstRow + row;
+            found += scan.matches(row);
+        }
+        rows.insert(rows.end(), block, block + found);
+    });
+    return rows;
+}
+
+size_t count_approaches(const CompressedApproachHistory& history, const ApproachQuery& query) {
+    size_t found = 0;
+    scan_blocks(history, query, [&found](const QueryScan& scan, size_t count, size_t) {
+        for (size_t row = 0; row < count; ++row) {
+            found += scan.matches(row);
+        }
+    });
+    return found;
+}
@@ -0,0 +1,116 @@
+#ifndef APPROACH_HISTORY_H
+#define APPROACH_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "neo_details.h"
+#include "neo_record.h"
+#include "series_codec.h"
+
+// Close-approach histories of many objects with one contiguous array per column: epoch, velocity
+// (km/s), miss distance (AU) and a one-byte orbiting-body code. The approaches of object k are
+// rows [begin(k), end(k)) in the order /neo/{id} lists them, so an object's history is a slice of
+// every column and a query over all approaches is a plain loop over the arrays.
+class ApproachHistory {
+public:
+    // Appends an object and its whole history; the last object added under an id is the one
+    // find() returns. std::invalid_argument past 256 orbiting bodies.
+    void add(const NeoDetail& detail);
+    void add(const std::string& id, const std::vector<CloseApproach>& approaches);
+
+    size_t object_count() const { return ids_.size(); }
+    size_t size() const { return epochs_.size(); }
+
+    const std::string& id(size_t object) const { return ids_[object]; }
+    size_t begin(size_t object) const { return offsets_[object]; }
+    size_t end(size_t object) const { return offsets_[object + 1]; }
+
+    // Object whose rows hold row
+    size_t object_of(size_t row) const;
+
+    // Object added last under an id, or object_count() when there is none
+    size_t find(const std::string& id) const;
+
+    // Whole columns, size() entries each
+    const int64_t* epochs() const { return epochs_.data(); }
+    const double* velocities_km_s() const { return velocities_.data(); }
+    const double* miss_au() const { return missAu_.data(); }
+    const uint8_t* bodies() const { return bodies_.data(); }
+
+    const std::string& body_name(uint8_t code) const { return bodyNames_[code]; }
+    // Code of an orbiting body, or -1 when no approach has it
+    int body_code(std::string_view name) const;
+
+    // The columns of one row as a CloseApproach; date and date_full follow from the epoch and
+    // the fields the history does not keep are 0
+    CloseApproach approach(size_t row) const;
+
+    // Heap and inline bytes held by the history
+    size_t memory_bytes() const;
+
+private:
+    std::vector<std::string> ids_;
+    std::vector<size_t> offsets_{0};           // one more entry than ids_
+    std::unordered_map<std::string, size_t> objectOf_;
+    std::vector<int64_t> epochs_;
+    std::vector<double> velocities_;
+    std::vector<double> missAu_;
+    std::vector<uint8_t> bodies_;
+    std::vector<std::string> bodyNames_;
+};
+
+// Approaches with epoch in [from_ms, to_ms), at most max_miss_au from the body and, unless body
+// is -1, around that orbiting-body code
+struct ApproachQuery {
+    int64_t from_ms = std::numeric_limits<int64_t>::min();
+    int64_t to_ms = std::numeric_limits<int64_t>::max();
+    double max_miss_au = std::numeric_limits<double>::infinity();
+    int body = -1;
+};
+
+// Epoch range of the calendar years firstYear to lastYear, both included
+void set_year_range(ApproachQuery& query, int firstYear, int lastYear);
+
+// Rows matching the query, in row order. The scan evaluates every condition for every row
+// without branching, so the compiler can vectorize it.
+std::vector<size_t> find_approaches(const ApproachHistory& history, const ApproachQuery& query);
+
+// Number of rows matching the query
+size_t count_approaches(const ApproachHistory& history, const ApproachQuery& query);
+
+// The columns of an ApproachHistory compressed for storage and long scans: epochs with
+// delta-of-delta, velocities and miss distances with XOR coding, body codes as they are. Rows
+// keep their numbers, so object ranges and ids still come from the history.
+class CompressedApproachHistory {
+public:
+    explicit CompressedApproachHistory(const ApproachHistory& history);
+
+    size_t size() const { return epochs_.count; }
+    size_t block_count() const { return epochs_.block_count(); }
+
+    const EncodedSeries& epochs() const { return epochs_; }
+    const EncodedSeries& velocities_km_s() const { return velocities_; }
+    const EncodedSeries& miss_au() const { return missAu_; }
+    const uint8_t* bodies() const { return bodies_.data(); }
+
+    // Bytes of the encoded columns and the body codes
+    size_t bytes() const;
+
+private:
+    EncodedSeries epochs_;
+    EncodedSeries velocities_;
+    EncodedSeries missAu_;
+    std::vector<uint8_t> bodies_;
+};
+
+// As above, decoding one block at a time; a block with no epoch in range skips decoding the
+// miss distances
+std::vector<size_t> find_approaches(const CompressedApproachHistory& history, const ApproachQuery& query);
+size_t count_approaches(const CompressedApproachHistory& history, const ApproachQuery& query);
+
+#endif // APPROACH_HISTORY_H
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "calendar.h"
+
+using namespace std;
+
+namespace {
+
+const char* const MONTH_ABBREVIATIONS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                           "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+const int64_t MS_PER_DAY = 86400000;
+
+// Value of text[begin, begin + count) when every character is a digit
+bool digits(string_view text, size_t begin, size_t count, unsigned& value) {
+    value = 0;
+    for (size_t i = begin; i < begin + count; ++i) {
+        unsigned digit = static_cast<unsigned>(text[i] - '0');
+        if (digit > 9) return false;
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+} // namespace
+
+// Days since 1970-01-01 for a civil date (Howard Hinnant's days_from_civil)
+Date date_from_civil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return Date(era * 146097 + static_cast<int32_t>(dayOfEra) - 719468);
+}
+
+CivilDate civil_from_date(Date date) {
+    const int32_t days = date.days + 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+    CivilDate civil;
+    civil.day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    civil.month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    civil.year = static_cast<int>(yearOfEra) + era * 400 + (civil.month <= 2 ? 1 : 0);
+    return civil;
+}
+
+DateCheck check_date(string_view text, CivilDate& civil) {
+    unsigned year, month, day;
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-' || !digits(text, 0, 4, year) ||
+        !digits(text, 5, 2, month) || !digits(text, 8, 2, day)) {
+        return DateCheck::BAD_FORMAT;
+    }
+    civil.year = static_cast<int>(year);
+    civil.month = month;
+    civil.day = day;
+    if (month < 1 || month > 12) return DateCheck::BAD_MONTH;
+    if (day < 1 || day > 31) return DateCheck::BAD_DAY;
+    if (day > days_in_month(civil.year, month)) return DateCheck::PAST_MONTH_END;
+    return DateCheck::VALID;
+}
+
+bool parse_date(string_view text, Date& date) {
+    CivilDate civil;
+    if (check_date(text, civil) != DateCheck::VALID) return false;
+    date = date_from_civil(civil.year, civil.month, civil.day);
+    return true;
+}
+
+Date parse_date(string_view text) {
+    Date date;
+    if (!parse_date(text, date)) {
+        throw invalid_argument("Invalid date (expected YYYY-MM-DD): " + string(text));
+    }
+    return date;
+}
+
+string format_date(Date date) {
+    CivilDate civil = civil_from_date(date);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", civil.year, civil.month, civil.day);
+    return buffer;
+}
+
+Date date_of_epoch_ms(int64_t epochMs) {
+    int64_t days = epochMs >= 0 ? epochMs / MS_PER_DAY : -((-epochMs + MS_PER_DAY - 1) / MS_PER_DAY);
+    return Date(static_cast<int32_t>(days));
+}
+
+int64_t epoch_ms_of(Date date) {
+    return static_cast<int64_t>(date.days) * MS_PER_DAY;
+}
+
+string format_approach_time(int64_t epochMs) {
+    Date date = date_of_epoch_ms(epochMs);
+    int64_t msOfDay = epochMs - epoch_ms_of(date);
+    CivilDate civil = civil_from_date(date);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%s-%02u %02d:%02d", civil.year, MONTH_ABBREVIATIONS[civil.month - 1],
+             civil.day, static_cast<int>(msOfDay / 3600000), static_cast<int>(msOfDay / 60000 % 60));
+    return buffer;
+}
+
+string add_days(const string& date, long days) {
+    return format_date(parse_date(date) + static_cast<int32_t>(days));
+}
+
+string today_utc() {
+    auto sinceEpoch = chrono::system_clock::now().time_since_epoch();
+    return format_date(date_of_epoch_ms(chrono::duration_cast<chrono::milliseconds>(sinceEpoch).count()));
+}
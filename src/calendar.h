@@ -0,0 +1,114 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// A calendar day (UTC, proleptic Gregorian) as the number of days since 1970-01-01. Dates are
+// kept and compared in this form; text is parsed once on the way in and formatted only for
+// output, so ordering, range checks and stepping are integer operations.
+struct Date {
+    int32_t days = 0;
+
+    constexpr Date() = default;
+    constexpr explicit Date(int32_t daysSinceEpoch) : days(daysSinceEpoch) {}
+
+    constexpr Date& operator++() { ++days; return *this; }
+    constexpr Date& operator+=(int32_t count) { days += count; return *this; }
+
+    friend constexpr Date operator+(Date date, int32_t count) { return Date(date.days + count); }
+    friend constexpr Date operator-(Date date, int32_t count) { return Date(date.days - count); }
+    friend constexpr int32_t operator-(Date a, Date b) { return a.days - b.days; }
+    friend constexpr bool operator==(Date a, Date b) { return a.days == b.days; }
+    friend constexpr bool operator!=(Date a, Date b) { return a.days != b.days; }
+    friend constexpr bool operator<(Date a, Date b) { return a.days < b.days; }
+    friend constexpr bool operator<=(Date a, Date b) { return a.days <= b.days; }
+    friend constexpr bool operator>(Date a, Date b) { return a.days > b.days; }
+    friend constexpr bool operator>=(Date a, Date b) { return a.days >= b.days; }
+};
+
+// Year, month (1-12) and day of month (1-31) of a Date
+struct CivilDate {
+    int year = 1970;
+    unsigned month = 1;
+    unsigned day = 1;
+};
+
+constexpr bool is_leap_year(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+constexpr unsigned days_in_month(int year, unsigned month) {
+    return month == 2 ? (is_leap_year(year) ? 29 : 28) : (month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31;
+}
+
+// Conversions between Date and year/month/day; date_from_civil does not validate its input
+Date date_from_civil(int year, unsigned month, unsigned day);
+CivilDate civil_from_date(Date date);
+
+// Why check_date rejected a text, from the first rule it breaks
+enum class DateCheck {
+    VALID,
+    BAD_FORMAT,        // not YYYY-MM-DD with digits only
+    BAD_MONTH,         // month outside 1-12
+    BAD_DAY,           // day outside 1-31
+    PAST_MONTH_END,    // day past the end of its month, e.g. 2023-02-29 or 2024-04-31
+};
+
+// Validates a YYYY-MM-DD date; civil holds the fields read, valid or not, unless the format was bad
+DateCheck check_date(std::string_view text, CivilDate& civil);
+
+// Reads a YYYY-MM-DD date; false, leaving date untouched, when check_date rejects the text
+bool parse_date(std::string_view text, Date& date);
+
+// As above, but throws std::invalid_argument
+Date parse_date(std::string_view text);
+
+// YYYY-MM-DD
+std::string format_date(Date date);
+
+// Day of an epoch time in milliseconds, rounding down so times before 1970 land on their own day
+Date date_of_epoch_ms(int64_t epochMs);
+
+// Midnight UTC at the start of a day, in epoch milliseconds
+int64_t epoch_ms_of(Date date);
+
+// "YYYY-Mon-DD hh:mm", the form of close_approach_date_full, for an epoch time in milliseconds
+std::string format_approach_time(int64_t epochMs);
+
+// Adds days to a YYYY-MM-DD date; throws std::invalid_argument on a bad date
+std::string add_days(const std::string& date, long days);
+
+// Today's date in UTC, as YYYY-MM-DD
+std::string today_utc();
+
+// The days of [first, last] in order, for range-based for loops; empty when last < first
+class DateRange {
+public:
+    class iterator {
+    public:
+        constexpr explicit iterator(Date date) : date_(date) {}
+        constexpr Date operator*() const { return date_; }
+        constexpr iterator& operator++() { ++date_; return *this; }
+        constexpr bool operator==(const iterator& other) const { return date_ == other.date_; }
+        constexpr bool operator!=(const iterator& other) const { return date_ != other.date_; }
+
+    private:
+        Date date_;
+    };
+
+    constexpr DateRange(Date first, Date last) : first_(first), end_(last < first ? first : last + 1) {}
+
+    constexpr iterator begin() const { return iterator(first_); }
+    constexpr iterator end() const { return iterator(end_); }
+    constexpr size_t size() const { return static_cast<size_t>(end_ - first_); }
+    constexpr bool contains(Date date) const { return first_ <= date && date < end_; }
+
+private:
+    Date first_;
+    Date end_;
+};
+
+#endif // CALENDAR_H
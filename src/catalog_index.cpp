@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "catalog_index.h"
+#include "neo_projection.h"
+
+using namespace std;
+using namespace catalog_index;
+namespace fs = std::filesystem;
+
+namespace {
+
+const size_t SECTION_ALIGNMENT = 8;
+
+// Fibonacci hashing: the top bits of id * 2^64 / phi pick the slot
+size_t slot_of(uint32_t id, unsigned shift) {
+    return static_cast<size_t>((uint64_t(id) * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+// Sections of an index as raw bytes, in Section order
+struct IndexSections {
+    string bytes[SECTION_COUNT];
+    uint32_t slotCount = 0;
+};
+
+template <typename T>
+void assign(string& section, const vector<T>& values) {
+    section.assign(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+// Function to build the id hash table, its postings and the list of text ids
+void build_id_index(const CatalogSnapshot& snapshot, IndexSections& out) {
+    vector<pair<uint32_t, uint32_t>> numeric;      // id, object offset
+    vector<uint32_t> textIds;
+    numeric.reserve(snapshot.size());
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        uint32_t id = snapshot.ids()[i];
+        // 0 is also what a text id stores, so only "0" itself is read back
+        if (id != 0 || is_numeric_id(snapshot.id(i), id)) {
+            numeric.push_back({id, static_cast<uint32_t>(i)});
+        } else {
+            textIds.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    sort(numeric.begin(), numeric.end());
+
+    size_t distinct = 0;
+    for (size_t k = 0; k < numeric.size(); ++k) {
+        distinct += k == 0 || numeric[k].first != numeric[k - 1].first;
+    }
+    size_t slotCount = 2;
+    while (slotCount < 2 * distinct) slotCount *= 2;
+    if (slotCount > UINT32_MAX) throw SnapshotError("Too many ids to index");
+    unsigned shift = 64;
+    for (size_t n = slotCount; n > 1; n /= 2) --shift;
+
+    vector<Slot> slots(slotCount, Slot{0, 0, 0});
+    vector<uint32_t> postings(numeric.size());
+    for (size_t k = 0; k < numeric.size();) {
+        uint32_t id = numeric[k].first;
+        size_t first = k;
+        for (; k < numeric.size() && numeric[k].first == id; ++k) postings[k] = numeric[k].second;
+        size_t slot = slot_of(id, shift);
+        while (slots[slot].count != 0) slot = (slot + 1) & (slotCount - 1);
+        slots[slot] = {id, static_cast<uint32_t>(first), static_cast<uint32_t>(k - first)};
+    }
+    assign(out.bytes[ID_SLOTS], slots);
+    assign(out.bytes[ID_POSTINGS], postings);
+    assign(out.bytes[TEXT_ID_OBJECTS], textIds);
+    out.slotCount = static_cast<uint32_t>(slotCount);
+}
+
+// Function to sort the object offsets by approach epoch; ties keep offset order
+void build_epoch_index(const CatalogSnapshot& snapshot, IndexSections& out) {
+    const int64_t* epochs = snapshot.epochs();
+    if (!epochs) return;
+    vector<uint32_t> objects(snapshot.size());
+    for (size_t i = 0; i < objects.size(); ++i) objects[i] = static_cast<uint32_t>(i);
+    stable_sort(objects.begin(), objects.end(), [epochs](uint32_t a, uint32_t b) { return epochs[a] < epochs[b]; });
+    vector<int64_t> keys(objects.size());
+    for (size_t k = 0; k < objects.size(); ++k) keys[k] = epochs[objects[k]];
+    assign(out.bytes[EPOCH_KEYS], keys);
+    assign(out.bytes[EPOCH_OBJECTS], objects);
+}
+
+} // namespace
+
+string catalog_index_path(const string& snapshotPath) {
+    return snapshotPath + ".idx";
+}
+
+void write_catalog_index(const CatalogSnapshot& snapshot, const string& path) {
+    IndexSections sections;
+    build_id_index(snapshot, sections);
+    build_epoch_index(snapshot, sections);
+
+    // Every section has a directory entry, empty ones included, so open() finds them by number
+    vector<snapshot::DirectoryEntry> directory;
+    uint64_t offset = sizeof(Header) + SECTION_COUNT * sizeof(snapshot::DirectoryEntry);
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        const string& bytes = sections.bytes[s];
+        directory.push_back({s, snapshot::checksum(bytes.data(), bytes.size()), offset, bytes.size()});
+        offset += bytes.size();
+    }
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byte_order = snapshot::BYTE_ORDER_MARK;
+    header.snapshot_crc = snapshot.header_crc();
+    header.slot_count = sections.slotCount;
+    header.snapshot_objects = snapshot.size();
+    header.snapshot_bytes = snapshot.file_bytes();
+    header.file_bytes = offset;
+    header.directory_crc =
+        snapshot::checksum(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(snapshot::DirectoryEntry));
+    header.header_crc = snapshot::checksum(reinterpret_cast<const char*>(&header), offsetof(Header, header_crc));
+
+    string temporary = path + ".tmp";
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(snapshot::DirectoryEntry));
+        uint64_t written = sizeof(header) + directory.size() * sizeof(snapshot::DirectoryEntry);
+        const char padding[SECTION_ALIGNMENT] = {};
+        for (const auto& entry : directory) {
+            out.write(padding, static_cast<streamsize>(entry.offset - written));
+            out.write(sections.bytes[entry.section].data(), static_cast<streamsize>(entry.bytes));
+            written = entry.offset + entry.bytes;
+        }
+        if (!out.flush()) {
+            error_code ec;
+            fs::remove(temporary, ec);
+            throw SnapshotError("Could not write " + temporary);
+        }
+    }
+    error_code ec;
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        throw SnapshotError("Could not replace " + path + ": " + ec.message());
+    }
+}
+
+bool CatalogIndex::open(const string& path, const CatalogSnapshot& snapshot) {
+    close();
+    if (!snapshot.is_open() || !file_.open(path)) {
+        return false;
+    }
+    auto fail = [&](const string& message) {
+        close();
+        throw SnapshotError(path + ": " + message);
+    };
+    string_view data = file_.contents();
+    Header header;
+    if (data.size() < sizeof(header)) fail("Too short to be a catalog index");
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) fail("Not a catalog index");
+    if (header.byte_order != snapshot::BYTE_ORDER_MARK) fail("Index was written with another byte order");
+    if (header.version != FORMAT_VERSION) fail("Unsupported index version " + to_string(header.version));
+    if (snapshot::checksum(data.data(), offsetof(Header, header_crc)) != header.header_crc) fail("Header checksum mismatch");
+    if (header.file_bytes != data.size()) fail("Index is truncated or has trailing data");
+    size_t directoryBytes = SECTION_COUNT * sizeof(snapshot::DirectoryEntry);
+    if (sizeof(header) + directoryBytes > data.size()) fail("Damaged section directory");
+    const char* directory = data.data() + sizeof(header);
+    if (snapshot::checksum(directory, directoryBytes) != header.directory_crc) fail("Directory checksum mismatch");
+
+    // A sound index of another snapshot is stale, not damaged
+    if (header.snapshot_crc != snapshot.header_crc() || header.snapshot_objects != snapshot.size() ||
+        header.snapshot_bytes != snapshot.file_bytes()) {
+        close();
+        return false;
+    }
+
+    directory_.resize(SECTION_COUNT);
+    memcpy(directory_.data(), directory, directoryBytes);
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        const auto& entry = directory_[s];
+        if (entry.section != s || entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > data.size() ||
+            entry.bytes > data.size() - entry.offset) {
+            fail("Damaged section directory");
+        }
+    }
+    auto section = [&](Section s) { return data.data() + directory_[s].offset; };
+    auto entries = [&](Section s, size_t width) { return static_cast<size_t>(directory_[s].bytes) / width; };
+
+    size_t slotCount = header.slot_count;
+    size_t postingCount = entries(ID_POSTINGS, sizeof(uint32_t));
+    epochCount_ = entries(EPOCH_KEYS, sizeof(int64_t));
+    textIdCount_ = entries(TEXT_ID_OBJECTS, sizeof(uint32_t));
+    bool keepsEpochs = snapshot.epochs() != nullptr;
+    if (slotCount < 2 || (slotCount & (slotCount - 1)) != 0 ||
+        directory_[ID_SLOTS].bytes != slotCount * sizeof(Slot) ||
+        postingCount + textIdCount_ != snapshot.size() ||
+        directory_[EPOCH_KEYS].bytes != (keepsEpochs ? snapshot.size() * sizeof(int64_t) : 0) ||
+        entries(EPOCH_OBJECTS, sizeof(uint32_t)) != epochCount_) {
+        fail("Index sections do not match the snapshot");
+    }
+    snapshot_ = &snapshot;
+    slots_ = reinterpret_cast<const Slot*>(section(ID_SLOTS));
+    slotMask_ = slotCount - 1;
+    slotShift_ = 64;
+    for (size_t n = slotCount; n > 1; n /= 2) --slotShift_;
+    postings_ = reinterpret_cast<const uint32_t*>(section(ID_POSTINGS));
+    textIdObjects_ = reinterpret_cast<const uint32_t*>(section(TEXT_ID_OBJECTS));
+    epochKeys_ = keepsEpochs ? reinterpret_cast<const int64_t*>(section(EPOCH_KEYS)) : nullptr;
+    epochObjects_ = reinterpret_cast<const uint32_t*>(section(EPOCH_OBJECTS));
+    return true;
+}
+
+void CatalogIndex::close() {
+    file_.close();
+    snapshot_ = nullptr;
+    slots_ = nullptr;
+    slotMask_ = 0;
+    slotShift_ = 0;
+    postings_ = nullptr;
+    textIdObjects_ = nullptr;
+    textIdCount_ = 0;
+    epochKeys_ = nullptr;
+    epochObjects_ = nullptr;
+    epochCount_ = 0;
+    directory_.clear();
+}
+
+bool CatalogIndex::verify() const {
+    string_view data = file_.contents();
+    for (const auto& entry : directory_) {
+        if (snapshot::checksum(data.data() + entry.offset, entry.bytes) != entry.crc) return false;
+    }
+    return true;
+}
+
+vector<size_t> CatalogIndex::find(uint32_t id) const {
+    vector<size_t> objects;
+    if (!slots_) return objects;
+    // Linear probing ends at the id or at the first empty slot; the table is at most half full
+    for (size_t slot = slot_of(id, slotShift_); slots_[slot].count != 0; slot = (slot + 1) & slotMask_) {
+        if (slots_[slot].id != id) continue;
+        const uint32_t* first = postings_ + slots_[slot].first;
+        objects.assign(first, first + slots_[slot].count);
+        break;
+    }
+    return objects;
+}
+
+vector<size_t> CatalogIndex::find(string_view id) const {
+    uint32_t number;
+    if (is_numeric_id(id, number)) {
+        return find(number);
+    }
+    vector<size_t> objects;
+    for (size_t k = 0; k < textIdCount_; ++k) {
+        if (snapshot_->id(textIdObjects_[k]) == id) objects.push_back(textIdObjects_[k]);
+    }
+    return objects;
+}
+
+pair<size_t, size_t> CatalogIndex::epoch_range(int64_t fromMs, int64_t toMs) const {
+    if (!epochKeys_ || toMs <= fromMs) return {0, 0};
+    const int64_t* first = lower_bound(epochKeys_, epochKeys_ + epochCount_, fromMs);
+    const int64_t* last = lower_bound(first, epochKeys_ + epochCount_, toMs);
+    return {static_cast<size_t>(first - epochKeys_), static_cast<size_t>(last - epochKeys_)};
+}
+
+pair<size_t, size_t> CatalogIndex::epoch_range(const DateRange& days) const {
+    return epoch_range(epoch_ms_of(*days.begin()), epoch_ms_of(*days.end()));
+}
@@ -0,0 +1,115 @@
+#ifndef CATALOG_INDEX_H
+#define CATALOG_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "calendar.h"
+#include "catalog_snapshot.h"
+#include "mapped_file.h"
+
+// Indexes over a CatalogSnapshot, kept in a file of their own next to it (catalog_index_path) so
+// a process that opens the snapshot opens them too instead of rebuilding them.
+//
+//   - id index: an open-addressing hash table from numeric NEO id to the object offsets that
+//     carry the id, one offset per feed date the object appears on, in offset order. Slots are
+//     {id, first posting, posting count} with a power-of-two slot count at most half full; a
+//     count of 0 marks an empty slot. Text ids, which the snapshot does not store as numbers,
+//     are listed separately and compared one by one.
+//   - epoch index: every object offset sorted by close-approach epoch (then by offset), with the
+//     epochs alongside, so a time range is two binary searches and a slice. Absent when the
+//     snapshot did not keep the approach time.
+//
+// The file has the snapshot's layout: a header, a directory of sections with their crc32, and the
+// sections 8-byte aligned. The header records the header crc, object count and size of the
+// snapshot it was built from, so an index left behind by an older snapshot is never used.
+namespace catalog_index {
+
+const char MAGIC[8] = {'N', 'E', 'O', 'I', 'N', 'D', 'E', 'X'};
+const uint32_t FORMAT_VERSION = 1;
+
+enum Section : uint32_t {
+    ID_SLOTS,               // Slot per hash slot
+    ID_POSTINGS,            // uint32 object offset, grouped by id
+    TEXT_ID_OBJECTS,        // uint32 offset of each object with a text id
+    EPOCH_KEYS,             // int64 ms, ascending
+    EPOCH_OBJECTS,          // uint32 object offset per key
+    SECTION_COUNT
+};
+
+struct Slot {
+    uint32_t id;
+    uint32_t first;                 // first posting
+    uint32_t count;                 // postings; 0 = empty slot
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t snapshot_crc;          // header crc of the snapshot indexed
+    uint32_t slot_count;            // power of two
+    uint64_t snapshot_objects;
+    uint64_t snapshot_bytes;
+    uint64_t file_bytes;
+    uint32_t directory_crc;
+    uint32_t header_crc;            // crc32 of the header up to this field
+};
+
+} // namespace catalog_index
+
+// Path of the index file kept for a snapshot
+std::string catalog_index_path(const std::string& snapshotPath);
+
+// Builds both indexes for a snapshot and writes them through a temporary file and a rename;
+// SnapshotError when the file cannot be written
+void write_catalog_index(const CatalogSnapshot& snapshot, const std::string& path);
+
+// An index file mapped read-only, answering lookups against the snapshot it was built from
+class CatalogIndex {
+public:
+    CatalogIndex() = default;
+    CatalogIndex(const CatalogIndex&) = delete;
+    CatalogIndex& operator=(const CatalogIndex&) = delete;
+
+    // False when the file cannot be mapped or was built from another snapshot; SnapshotError when
+    // it is not an index this version reads, or its header or directory is damaged. The snapshot
+    // must stay open while the index is used.
+    bool open(const std::string& path, const CatalogSnapshot& snapshot);
+    void close();
+    bool is_open() const { return file_.is_open(); }
+
+    // Checks every section against its crc32; false on the first mismatch
+    bool verify() const;
+
+    // Offsets of the objects with this id, ascending; empty when there are none
+    std::vector<size_t> find(uint32_t id) const;
+    std::vector<size_t> find(std::string_view id) const;
+
+    bool has_epochs() const { return epochKeys_ != nullptr; }
+    // Positions [first, second) of the epoch index whose epochs are in [fromMs, toMs)
+    std::pair<size_t, size_t> epoch_range(int64_t fromMs, int64_t toMs) const;
+    // Positions of the approaches on the days of a range
+    std::pair<size_t, size_t> epoch_range(const DateRange& days) const;
+    int64_t epoch_at(size_t position) const { return epochKeys_[position]; }
+    size_t object_at(size_t position) const { return epochObjects_[position]; }
+
+private:
+    MappedFile file_;
+    const CatalogSnapshot* snapshot_ = nullptr;
+    const catalog_index::Slot* slots_ = nullptr;
+    size_t slotMask_ = 0;
+    unsigned slotShift_ = 0;
+    const uint32_t* postings_ = nullptr;
+    const uint32_t* textIdObjects_ = nullptr;
+    size_t textIdCount_ = 0;
+    const int64_t* epochKeys_ = nullptr;
+    const uint32_t* epochObjects_ = nullptr;
+    size_t epochCount_ = 0;
+    std::vector<snapshot::DirectoryEntry> directory_;
+};
+
+#endif // CATALOG_INDEX_H
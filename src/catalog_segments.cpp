@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include "catalog_segments.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const MANIFEST_FILE = "MANIFEST";
+const char* const MANIFEST_MAGIC = "NEOSEGMENTS 1";
+const string SEGMENT_PREFIX = "segment-";
+const string SEGMENT_SUFFIX = ".neosnap";
+
+bool ends_with(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Number of a segment-NNNNNN.neosnap file name; false for any other name
+bool segment_number(const string& name, uint64_t& number) {
+    if (name.rfind(SEGMENT_PREFIX, 0) != 0 || !ends_with(name, SEGMENT_SUFFIX)) return false;
+    string digits = name.substr(SEGMENT_PREFIX.size(), name.size() - SEGMENT_PREFIX.size() - SEGMENT_SUFFIX.size());
+    if (digits.empty() || digits.find_first_not_of("0123456789") != string::npos) return false;
+    number = stoull(digits);
+    return true;
+}
+
+} // namespace
+
+size_t CatalogView::find_day(Date date) const {
+    auto found = lower_bound(days_.begin(), days_.end(), date,
+                             [](const DaySource& source, Date value) { return source.date < value; });
+    return found != days_.end() && found->date == date ? static_cast<size_t>(found - days_.begin()) : days_.size();
+}
+
+NeoRecord CatalogView::record(size_t day, size_t k) const {
+    NeoRecord record;
+    visit(day, k, [&record](const auto& catalog, size_t index) { record = catalog.record(index); });
+    return record;
+}
+
+string CatalogView::id(size_t day, size_t k) const {
+    string id;
+    visit(day, k, [&id](const auto& catalog, size_t index) { id = catalog.id(index); });
+    return id;
+}
+
+SegmentedCatalog::SegmentedCatalog(const string& directory, ProjectionOptions projection, SegmentOptions options)
+    : directory_(directory), projection_(projection), options_(options) {
+    load_manifest();
+    {
+        lock_guard<mutex> lock(mutex_);
+        publish_view();
+    }
+    if (options_.background) {
+        worker_ = thread([this] { worker_loop(); });
+    }
+}
+
+SegmentedCatalog::~SegmentedCatalog() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    try {
+        flush();
+    } catch (const exception& e) {
+        cerr << "Could not write the catalog delta to " << directory_ << ": " << e.what() << endl;
+    }
+}
+
+// Function to read the manifest, map the segments it lists and remove files a crash left behind
+void SegmentedCatalog::load_manifest() {
+    error_code ec;
+    fs::create_directories(directory_, ec);
+    if (!fs::is_directory(directory_, ec)) {
+        throw SnapshotError("Could not create catalog directory " + directory_);
+    }
+    // New segments are numbered past every segment file on disk, listed or not
+    vector<string> onDisk;
+    for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        string name = it->path().filename().string();
+        uint64_t number = 0;
+        if (segment_number(name, number)) nextSegment_ = max(nextSegment_, number + 1);
+        onDisk.push_back(name);
+    }
+
+    string manifestPath = (fs::path(directory_) / MANIFEST_FILE).string();
+    ifstream manifest(manifestPath);
+    set<string> listed;
+    if (manifest.is_open()) {
+        string line;
+        if (!getline(manifest, line) || line != MANIFEST_MAGIC) {
+            throw SnapshotError(manifestPath + ": Not a segment manifest");
+        }
+        if (!getline(manifest, line) || line.rfind("fields ", 0) != 0) {
+            throw SnapshotError(manifestPath + ": Missing field list");
+        }
+        if (line.find_first_not_of("0123456789", 7) != string::npos || line.size() == 7) {
+            throw SnapshotError(manifestPath + ": Damaged field list");
+        }
+        if (static_cast<uint32_t>(stoul(line.substr(7))) != projection_.fields) {
+            throw SnapshotError(directory_ + " keeps other fields than requested");
+        }
+        while (getline(manifest, line)) {
+            if (line.empty()) continue;
+            segments_.push_back({line, open_segment(line)});
+            listed.insert(line);
+        }
+    }
+
+    // A crash between writing a segment and replacing the manifest leaves an unlisted file
+    for (const auto& name : onDisk) {
+        uint64_t number = 0;
+        if (ends_with(name, ".tmp") || (segment_number(name, number) && listed.count(name) == 0)) {
+            fs::remove(fs::path(directory_) / name, ec);
+        }
+    }
+}
+
+void SegmentedCatalog::write_manifest() const {
+    string path = (fs::path(directory_) / MANIFEST_FILE).string();
+    string temporary = path + ".tmp";
+    {
+        ofstream out(temporary, ios::trunc);
+        out << MANIFEST_MAGIC << "\n" << "fields " << projection_.fields << "\n";
+        for (const auto& segment : segments_) {
+            out << segment.file << "\n";
+        }
+        if (!out.flush()) {
+            throw SnapshotError("Could not write " + temporary);
+        }
+    }
+    error_code ec;
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        throw SnapshotError("Could not replace " + path + ": " + ec.message());
+    }
+}
+
+string SegmentedCatalog::next_segment_file() {
+    char name[64];
+    snprintf(name, sizeof(name), "segment-%06llu.neosnap", static_cast<unsigned long long>(nextSegment_++));
+    return name;
+}
+
+shared_ptr<const CatalogSnapshot> SegmentedCatalog::open_segment(const string& file) const {
+    string path = (fs::path(directory_) / file).string();
+    auto snapshot = make_shared<CatalogSnapshot>();
+    if (!snapshot->open(path)) {
+        throw SnapshotError("Missing segment " + path);
+    }
+    if (snapshot->fields() != projection_.fields) {
+        throw SnapshotError(path + " keeps other fields than its manifest");
+    }
+    return snapshot;
+}
+
+vector<DecodeError> SegmentedCatalog::add_feed(string_view body) {
+    // Parsing happens before any lock, so readers and the compaction never wait for it
+    auto feed = make_shared<ProjectedCatalog>(projection_);
+    feed->add_feed(body);
+    vector<Date> days(feed->dates().size());
+    for (size_t d = 0; d < days.size(); ++d) {
+        if (!parse_date(feed->dates()[d], days[d])) {
+            throw SnapshotError("Feed date is not YYYY-MM-DD: " + feed->dates()[d]);
+        }
+    }
+
+    lock_guard<mutex> writing(writeMutex_);
+    bool full = false;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (size_t d = 0; d < days.size(); ++d) {
+            DeltaDay& slot = delta_[days[d].days];
+            if (slot.feed) {
+                deltaObjects_ -= slot.feed->date_begin(slot.date + 1) - slot.feed->date_begin(slot.date);
+            }
+            slot = {feed, d};
+            deltaObjects_ += feed->date_begin(d + 1) - feed->date_begin(d);
+        }
+        publish_view();
+        full = deltaObjects_ >= options_.delta_objects;
+    }
+    if (full) {
+        flush_delta();
+    }
+    return feed->malformed();
+}
+
+void SegmentedCatalog::flush() {
+    lock_guard<mutex> writing(writeMutex_);
+    flush_delta();
+}
+
+// Function to write the delta as the newest segment; the caller holds writeMutex_, so the delta
+// cannot change while the segment is written
+void SegmentedCatalog::flush_delta() {
+    map<int32_t, DeltaDay> days;
+    string file;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (delta_.empty()) return;
+        days = delta_;
+        file = next_segment_file();
+    }
+    SnapshotWriter writer(projection_.fields);
+    for (const auto& [day, source] : days) {
+        writer.add_day(*source.feed, source.date);
+    }
+    writer.write((fs::path(directory_) / file).string());
+    auto snapshot = open_segment(file);
+    {
+        lock_guard<mutex> lock(mutex_);
+        segments_.push_back({file, snapshot});
+        delta_.clear();
+        deltaObjects_ = 0;
+        ++stats_.flushes;
+        write_manifest();
+        publish_view();
+    }
+    wake_.notify_all();
+}
+
+bool SegmentedCatalog::compaction_due() const {
+    return options_.merge_width >= 2 && segments_.size() > max<size_t>(1, options_.max_segments);
+}
+
+void SegmentedCatalog::compact() {
+    while (compact_once()) {
+    }
+}
+
+// Function to merge the adjacent run of segments with the fewest bytes into one. Only flushes
+// change the segment list meanwhile, and they only append, so the run keeps its position.
+bool SegmentedCatalog::compact_once() {
+    lock_guard<mutex> compacting(compactMutex_);
+    Clock::time_point started = Clock::now();
+    vector<Segment> run;
+    size_t first = 0;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!compaction_due()) return false;
+        size_t width = min(options_.merge_width, segments_.size());
+        uint64_t fewest = UINT64_MAX;
+        for (size_t s = 0; s + width <= segments_.size(); ++s) {
+            uint64_t bytes = 0;
+            for (size_t i = s; i < s + width; ++i) bytes += segments_[i].snapshot->file_bytes();
+            if (bytes < fewest) {
+                fewest = bytes;
+                first = s;
+            }
+        }
+        run.assign(segments_.begin() + first, segments_.begin() + first + width);
+    }
+
+    // Newest copy of each date within the run, in date order
+    map<int32_t, pair<size_t, size_t>> newest;
+    for (size_t r = 0; r < run.size(); ++r) {
+        for (size_t d = 0; d < run[r].snapshot->date_count(); ++d) {
+            newest[run[r].snapshot->date(d).days] = make_pair(r, d);
+        }
+    }
+    SnapshotWriter writer(projection_.fields);
+    for (const auto& [day, source] : newest) {
+        writer.add_day(*run[source.first].snapshot, source.second);
+    }
+    string file;
+    {
+        lock_guard<mutex> lock(mutex_);
+        file = next_segment_file();
+    }
+    writer.write((fs::path(directory_) / file).string());
+    auto merged = open_segment(file);
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        segments_.erase(segments_.begin() + first, segments_.begin() + first + run.size());
+        segments_.insert(segments_.begin() + first, {file, merged});
+        ++stats_.compactions;
+        stats_.compacted_bytes += merged->file_bytes();
+        stats_.compaction_ms += chrono::duration<double, milli>(Clock::now() - started).count();
+        write_manifest();
+        publish_view();
+    }
+    // Views still reading the old segments keep their mappings; the files go once unlisted
+    for (const auto& segment : run) {
+        error_code ec;
+        fs::remove(fs::path(directory_) / segment.file, ec);
+    }
+    return true;
+}
+
+// Function to build the view of the current segments and delta; the caller holds mutex_
+void SegmentedCatalog::publish_view() {
+    auto view = make_shared<CatalogView>();
+    map<int32_t, CatalogView::DaySource> days;
+    for (const auto& segment : segments_) {
+        const CatalogSnapshot& snapshot = *segment.snapshot;
+        view->segments_.push_back(segment.snapshot);
+        for (size_t d = 0; d < snapshot.date_count(); ++d) {
+            days[snapshot.date(d).days] = {snapshot.date(d), &snapshot, nullptr, snapshot.date_begin(d),
+                                           snapshot.date_begin(d + 1)};
+        }
+    }
+    set<const ProjectedCatalog*> feeds;
+    for (const auto& [day, source] : delta_) {
+        const ProjectedCatalog& feed = *source.feed;
+        if (feeds.insert(&feed).second) view->deltaFeeds_.push_back(source.feed);
+        days[day] = {Date(day), nullptr, &feed, feed.date_begin(source.date), feed.date_begin(source.date + 1)};
+    }
+    for (const auto& [day, source] : days) {
+        view->days_.push_back(source);
+        view->objectCount_ += source.end - source.begin;
+    }
+    view_ = view;
+}
+
+shared_ptr<const CatalogView> SegmentedCatalog::view() const {
+    lock_guard<mutex> lock(mutex_);
+    return view_;
+}
+
+SegmentStats SegmentedCatalog::stats() const {
+    lock_guard<mutex> lock(mutex_);
+    SegmentStats stats = stats_;
+    stats.segments = segments_.size();
+    for (const auto& segment : segments_) stats.segment_bytes += segment.snapshot->file_bytes();
+    stats.delta_days = delta_.size();
+    stats.delta_objects = deltaObjects_;
+    return stats;
+}
+
+void SegmentedCatalog::worker_loop() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || compaction_due(); });
+        if (stopping_) {
+            return;
+        }
+        lock.unlock();
+        try {
+            compact_once();
+        } catch (const exception& e) {
+            // Segments stay as they are; compact() retries and reports the error to its caller
+            cerr << "Compaction of " << directory_ << " failed: " << e.what() << endl;
+            return;
+        }
+        lock.lock();
+    }
+}
+
+string format_segment_stats(const SegmentStats& stats) {
+    ostringstream out;
+    out << fixed << setprecision(2) << stats.segments << " segments (" << stats.segment_bytes / 1e6 << " MB), delta "
+        << stats.delta_days << " days / " << stats.delta_objects << " objects; " << stats.flushes << " flushes, "
+        << stats.compactions << " compactions (" << stats.compacted_bytes / 1e6 << " MB written in " << setprecision(1)
+        << stats.compaction_ms << " ms)";
+    return out.str();
+}
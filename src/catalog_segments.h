@@ -0,0 +1,165 @@
+#ifndef CATALOG_SEGMENTS_H
+#define CATALOG_SEGMENTS_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "calendar.h"
+#include "catalog_snapshot.h"
+#include "decode_result.h"
+#include "neo_projection.h"
+#include "neo_record.h"
+
+// When the delta is written out and how segments are merged
+struct SegmentOptions {
+    size_t delta_objects = 10000;   // the delta becomes a segment once it holds this many objects
+    size_t max_segments = 8;        // a compaction is due while there are more segments than this
+    size_t merge_width = 4;         // adjacent segments merged by one compaction
+    bool background = true;         // compact on a worker thread; otherwise only in compact()
+};
+
+// Counters of a SegmentedCatalog
+struct SegmentStats {
+    size_t segments = 0;
+    uint64_t segment_bytes = 0;
+    size_t delta_days = 0;
+    size_t delta_objects = 0;
+    uint64_t flushes = 0;           // deltas written as segments
+    uint64_t compactions = 0;
+    uint64_t compacted_bytes = 0;   // bytes written by compactions
+    double compaction_ms = 0.0;     // spent in compactions, off the ingest path
+};
+
+// One consistent state of a SegmentedCatalog: its days in date order, each taken from the newest
+// segment or delta feed that has it. A view holds on to the segments and feeds it reads, so it
+// stays valid and unchanged while later appends and compactions go on.
+class CatalogView {
+public:
+    size_t size() const { return objectCount_; }
+    size_t day_count() const { return days_.size(); }
+    Date day(size_t day) const { return days_[day].date; }
+    size_t day_size(size_t day) const { return days_[day].end - days_[day].begin; }
+
+    // Index of the date's day, or day_count() when the view does not have it
+    size_t find_day(Date date) const;
+
+    // Object k of a day
+    NeoRecord record(size_t day, size_t k) const;
+    std::string id(size_t day, size_t k) const;
+
+    // Calls visit(catalog, index) with the ProjectedCatalog or CatalogSnapshot that holds object
+    // k of a day, for code written against either, such as output_neo_data
+    template <typename Visit>
+    void visit(size_t day, size_t k, Visit&& visit) const {
+        const DaySource& source = days_[day];
+        if (source.segment) {
+            visit(*source.segment, source.begin + k);
+        } else {
+            visit(*source.delta, source.begin + k);
+        }
+    }
+
+    size_t segment_count() const { return segments_.size(); }
+
+private:
+    friend class SegmentedCatalog;
+
+    // Objects [begin, end) of one date of a segment, or of a delta feed
+    struct DaySource {
+        Date date;
+        const CatalogSnapshot* segment = nullptr;
+        const ProjectedCatalog* delta = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<std::shared_ptr<const CatalogSnapshot>> segments_;
+    std::vector<std::shared_ptr<const ProjectedCatalog>> deltaFeeds_;
+    std::vector<DaySource> days_;
+    size_t objectCount_ = 0;
+};
+
+// A projected catalog kept in a directory as immutable snapshot segments plus a small in-memory
+// delta, so appending a daily feed costs in proportion to that feed rather than to the catalog.
+//   - add_feed puts the feed's dates in the delta; a date seen again replaces the older copy
+//   - once the delta holds delta_objects objects it is written as a new segment, in date order
+//   - a background compaction merges the merge_width adjacent segments with the fewest bytes
+//     while there are more than max_segments, dropping days a newer segment replaced
+// The MANIFEST file lists the live segments oldest first and is replaced by rename, so a crash
+// leaves either the old or the new list. The delta lives in memory until flush() or destruction.
+class SegmentedCatalog {
+public:
+    // Opens or creates the store in directory; SnapshotError when its manifest or a segment is
+    // damaged, or it was written with other fields than projection.fields
+    SegmentedCatalog(const std::string& directory, ProjectionOptions projection = {}, SegmentOptions options = {});
+    ~SegmentedCatalog();
+
+    SegmentedCatalog(const SegmentedCatalog&) = delete;
+    SegmentedCatalog& operator=(const SegmentedCatalog&) = delete;
+
+    // Adds every date of a feed document and returns the records it skipped as malformed;
+    // JsonStreamError on broken JSON, SnapshotError on a feed date that is not YYYY-MM-DD
+    std::vector<DecodeError> add_feed(std::string_view body);
+
+    // Writes the delta as a segment, if it holds anything
+    void flush();
+
+    // Runs compactions until none is due, waiting for one the worker has started
+    void compact();
+
+    // The current state; cheap, and safe to call from any thread
+    std::shared_ptr<const CatalogView> view() const;
+
+    SegmentStats stats() const;
+    const std::string& directory() const { return directory_; }
+
+private:
+    struct Segment {
+        std::string file;                               // name within directory_
+        std::shared_ptr<const CatalogSnapshot> snapshot;
+    };
+    // One delta date and the parsed feed it came from
+    struct DeltaDay {
+        std::shared_ptr<const ProjectedCatalog> feed;
+        size_t date = 0;
+    };
+
+    void load_manifest();
+    void write_manifest() const;
+    std::string next_segment_file();
+    std::shared_ptr<const CatalogSnapshot> open_segment(const std::string& file) const;
+    void flush_delta();
+    bool compaction_due() const;
+    bool compact_once();
+    void publish_view();
+    void worker_loop();
+
+    std::string directory_;
+    ProjectionOptions projection_;
+    SegmentOptions options_;
+
+    std::mutex writeMutex_;                   // serializes add_feed and flush
+    std::mutex compactMutex_;                 // one compaction at a time
+    mutable std::mutex mutex_;                // guards everything below
+    std::condition_variable wake_;
+    std::vector<Segment> segments_;           // oldest first
+    std::map<int32_t, DeltaDay> delta_;       // by day number
+    size_t deltaObjects_ = 0;
+    uint64_t nextSegment_ = 1;
+    std::shared_ptr<const CatalogView> view_;
+    SegmentStats stats_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+// Renders the counters on one line
+std::string format_segment_stats(const SegmentStats& stats);
+
+#endif // CATALOG_SEGMENTS_H
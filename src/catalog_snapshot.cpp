@@ -0,0 +1,489 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <zlib.h>
+#include "catalog_snapshot.h"
+#include "feed_index.h"
+
+using namespace std;
+using namespace snapshot;
+namespace fs = std::filesystem;
+
+namespace {
+
+const size_t SECTION_ALIGNMENT = 8;
+const size_t CRC_CHUNK = size_t(1) << 30;      // crc32 takes a 32-bit length
+const uint8_t FLAG_HAZARDOUS = 1 << 0;
+const uint8_t FLAG_SENTRY = 1 << 1;
+const uint8_t EXPLICIT_DECIMAL = 0xFF;
+
+template <typename T>
+void append(string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Appends one text to a string column: the text to the heap, its end offset to the ends
+void append_text(string& ends, string& heap, string_view text) {
+    heap.append(text);
+    if (heap.size() > UINT32_MAX) {
+        throw SnapshotError("String section larger than 4 GB");
+    }
+    append(ends, static_cast<uint32_t>(heap.size()));
+}
+
+// Field group that keeps a decimal field
+uint32_t decimal_group(int field) {
+    return field <= ProjectedCatalog::VELOCITY_KM_H ? FIELD_VELOCITY : FIELD_MISS_DISTANCE;
+}
+
+// Field group each section belongs to (0: always present), its entry width, and whether it has an
+// entry per object (otherwise its length is checked where it is read)
+struct SectionShape {
+    uint32_t field;
+    size_t width;
+    bool perObject;
+};
+
+SectionShape shape_of(uint32_t section) {
+    if (section >= DECIMAL_DIGITS && section < DECIMAL_SCALES) {
+        return {decimal_group(static_cast<int>(section - DECIMAL_DIGITS)), sizeof(int64_t), true};
+    }
+    if (section >= DECIMAL_SCALES && section < BODIES) {
+        return {decimal_group(static_cast<int>(section - DECIMAL_SCALES)), sizeof(uint8_t), true};
+    }
+    switch (section) {
+        case IDS: return {0, sizeof(uint32_t), true};
+        case NAME_ENDS: return {FIELD_NAME, sizeof(uint32_t), true};
+        case NAME_TEXT: return {FIELD_NAME, 1, false};
+        case MAGNITUDES: return {FIELD_MAGNITUDE, sizeof(double), true};
+        case DIAMETER_KM_MIN:
+        case DIAMETER_KM_MAX:
+        case DIAMETER_M_MIN:
+        case DIAMETER_M_MAX: return {FIELD_DIAMETERS, sizeof(double), true};
+        case FLAGS: return {FIELD_FLAGS, sizeof(uint8_t), true};
+        case EPOCHS: return {FIELD_APPROACH_TIME, sizeof(int64_t), true};
+        case APPROACH_DAYS: return {FIELD_APPROACH_TIME, sizeof(int32_t), true};
+        case BODIES: return {FIELD_ORBITING_BODY, sizeof(uint8_t), true};
+        case BODY_NAME_ENDS: return {FIELD_ORBITING_BODY, sizeof(uint32_t), false};
+        case BODY_NAME_TEXT: return {FIELD_ORBITING_BODY, 1, false};
+        case DATES: return {0, sizeof(int32_t), false};
+        case DATE_FIRST: return {0, sizeof(uint32_t), false};
+        case EXPLICIT_KEYS: return {0, sizeof(uint64_t), false};
+        case EXPLICIT_ENDS: return {0, sizeof(uint32_t), false};
+        default: return {0, 1, false};
+    }
+}
+
+} // namespace
+
+uint32_t snapshot::checksum(const char* data, size_t bytes) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    while (bytes > 0) {
+        size_t chunk = min(bytes, CRC_CHUNK);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(chunk));
+        data += chunk;
+        bytes -= chunk;
+    }
+    return static_cast<uint32_t>(crc);
+}
+
+SnapshotWriter::SnapshotWriter(uint32_t fields) : fields_(fields), sections_(SECTION_COUNT) {}
+
+void SnapshotWriter::add_day(const ProjectedCatalog& catalog, size_t date) {
+    if (catalog.options().fields != fields_) {
+        throw SnapshotError("Catalog keeps other fields than the snapshot being written");
+    }
+    Date day;
+    if (!parse_date(catalog.dates()[date], day)) {
+        throw SnapshotError("Feed date is not YYYY-MM-DD: " + catalog.dates()[date]);
+    }
+    add_objects(catalog, day, catalog.date_begin(date), catalog.date_begin(date + 1));
+}
+
+void SnapshotWriter::add_day(const CatalogSnapshot& snapshot, size_t date) {
+    if (snapshot.fields() != fields_) {
+        throw SnapshotError("Snapshot keeps other fields than the snapshot being written");
+    }
+    add_objects(snapshot, snapshot.date(date), snapshot.date_begin(date), snapshot.date_begin(date + 1));
+}
+
+// Function to append the objects [begin, end) of a catalog or snapshot to every kept column
+template <typename Catalog>
+void SnapshotWriter::add_objects(const Catalog& catalog, Date day, size_t begin, size_t end) {
+    auto keeps = [this](uint32_t field) { return (fields_ & field) != 0; };
+    if (dateCount_ > 0 && day <= lastDate_) {
+        throw SnapshotError("Snapshot days must be added in date order: " + format_date(day));
+    }
+    append(sections_[DATES], day.days);
+    append(sections_[DATE_FIRST], static_cast<uint32_t>(objectCount_));
+    lastDate_ = day;
+    ++dateCount_;
+
+    // Objects are visited in order and their slots in ascending order, so the keys come out sorted
+    auto add_explicit = [&](uint32_t slot, string_view text) {
+        append(sections_[EXPLICIT_KEYS], static_cast<uint64_t>(objectCount_) * 16 + slot);
+        append_text(sections_[EXPLICIT_ENDS], sections_[EXPLICIT_TEXT], text);
+    };
+    for (size_t i = begin; i < end; ++i, ++objectCount_) {
+        if (objectCount_ >= UINT32_MAX) {
+            throw SnapshotError("Too many objects for one snapshot");
+        }
+        string id = catalog.id(i);
+        uint32_t numericId = 0;
+        if (!is_numeric_id(id, numericId)) {
+            numericId = 0;
+            add_explicit(SLOT_ID, id);
+        }
+        append(sections_[IDS], numericId);
+        if (keeps(FIELD_NAME)) {
+            append_text(sections_[NAME_ENDS], sections_[NAME_TEXT], catalog.name(i));
+        }
+        if (keeps(FIELD_JPL_URL)) {
+            string url = catalog.nasa_jpl_url(i);
+            if (url != sbdb_lookup_url(id)) add_explicit(SLOT_URL, url);
+        }
+        if (keeps(FIELD_MAGNITUDE)) append(sections_[MAGNITUDES], catalog.absolute_magnitude_h(i));
+        if (keeps(FIELD_DIAMETERS)) {
+            append(sections_[DIAMETER_KM_MIN], catalog.diameter_km_min(i));
+            append(sections_[DIAMETER_KM_MAX], catalog.diameter_km_max(i));
+            append(sections_[DIAMETER_M_MIN], catalog.diameter_m_min(i));
+            append(sections_[DIAMETER_M_MAX], catalog.diameter_m_max(i));
+        }
+        if (keeps(FIELD_FLAGS)) {
+            uint8_t flags = (catalog.is_potentially_hazardous(i) ? FLAG_HAZARDOUS : 0) |
+                            (catalog.is_sentry_object(i) ? FLAG_SENTRY : 0);
+            append(sections_[FLAGS], flags);
+        }
+        if (keeps(FIELD_APPROACH_TIME)) {
+            int64_t epoch = catalog.epoch_ms(i);
+            append(sections_[EPOCHS], epoch);
+            append(sections_[APPROACH_DAYS], catalog.close_approach_day(i).days);
+            string dateFull = catalog.close_approach_date_full(i);
+            if (dateFull != format_approach_time(epoch)) add_explicit(SLOT_DATE_FULL, dateFull);
+        }
+        for (int field = 0; field < ProjectedCatalog::DECIMAL_FIELDS; ++field) {
+            if (!keeps(decimal_group(field))) continue;
+            auto decimal = static_cast<ProjectedCatalog::DecimalField>(field);
+            int64_t scaled = 0;
+            uint8_t scale = 0;
+            if (!catalog.decimal_digits(decimal, i, scaled, scale)) {
+                scaled = 0;
+                scale = EXPLICIT_DECIMAL;
+                add_explicit(SLOT_DECIMAL + field, catalog.decimal_text(decimal, i));
+            }
+            append(sections_[DECIMAL_DIGITS + field], scaled);
+            append(sections_[DECIMAL_SCALES + field], scale);
+        }
+        if (keeps(FIELD_ORBITING_BODY)) {
+            string body = catalog.orbiting_body(i);
+            size_t code = find(bodyNames_.begin(), bodyNames_.end(), body) - bodyNames_.begin();
+            if (code == bodyNames_.size()) {
+                if (code > UINT8_MAX) throw SnapshotError("Too many orbiting bodies");
+                bodyNames_.push_back(body);
+                append_text(sections_[BODY_NAME_ENDS], sections_[BODY_NAME_TEXT], body);
+            }
+            append(sections_[BODIES], static_cast<uint8_t>(code));
+        }
+    }
+}
+
+// Function to write the header, the directory and then each section at the next aligned offset
+void SnapshotWriter::write(const string& path) const {
+    vector<bool> present(SECTION_COUNT, false);
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        present[s] = shape_of(s).field == 0 || (fields_ & shape_of(s).field) != 0;
+    }
+    // DATE_FIRST ends with the object count, which is only known now
+    string dateFirst = sections_[DATE_FIRST];
+    append(dateFirst, static_cast<uint32_t>(objectCount_));
+    auto bytes_of = [&](uint32_t section) -> const string& {
+        return section == DATE_FIRST ? dateFirst : sections_[section];
+    };
+
+    vector<DirectoryEntry> directory;
+    uint64_t offset = sizeof(Header) + sizeof(DirectoryEntry) * static_cast<size_t>(count(present.begin(), present.end(), true));
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        if (!present[s]) continue;
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        directory.push_back({s, checksum(bytes_of(s).data(), bytes_of(s).size()), offset, bytes_of(s).size()});
+        offset += bytes_of(s).size();
+    }
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.fields = fields_;
+    header.section_count = static_cast<uint32_t>(directory.size());
+    header.object_count = objectCount_;
+    header.date_count = dateCount_;
+    header.file_bytes = offset;
+    header.directory_crc = checksum(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(DirectoryEntry));
+    header.header_crc = checksum(reinterpret_cast<const char*>(&header), offsetof(Header, header_crc));
+
+    string temporary = path + ".tmp";
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(DirectoryEntry));
+        uint64_t written = sizeof(header) + directory.size() * sizeof(DirectoryEntry);
+        const char padding[SECTION_ALIGNMENT] = {};
+        for (const auto& entry : directory) {
+            out.write(padding, static_cast<streamsize>(entry.offset - written));
+            out.write(bytes_of(entry.section).data(), static_cast<streamsize>(entry.bytes));
+            written = entry.offset + entry.bytes;
+        }
+        if (!out.flush()) {
+            error_code ec;
+            fs::remove(temporary, ec);
+            throw SnapshotError("Could not write " + temporary);
+        }
+    }
+    error_code ec;
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        throw SnapshotError("Could not replace " + path + ": " + ec.message());
+    }
+}
+
+void write_catalog_snapshot(const ProjectedCatalog& catalog, const string& path) {
+    // A feed lists its dates in any order; the snapshot keeps them sorted
+    vector<size_t> order(catalog.dates().size());
+    for (size_t d = 0; d < order.size(); ++d) order[d] = d;
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) { return catalog.dates()[a] < catalog.dates()[b]; });
+    SnapshotWriter writer(catalog.options().fields);
+    for (size_t d : order) {
+        writer.add_day(catalog, d);
+    }
+    writer.write(path);
+}
+
+bool CatalogSnapshot::open(const string& path) {
+    close();
+    if (!file_.open(path)) {
+        return false;
+    }
+    auto fail = [&](const string& message) {
+        close();
+        throw SnapshotError(path + ": " + message);
+    };
+    string_view data = file_.contents();
+    Header header;
+    if (data.size() < sizeof(header)) fail("Too short to be a catalog snapshot");
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) fail("Not a catalog snapshot");
+    if (header.byte_order != BYTE_ORDER_MARK) fail("Snapshot was written with another byte order");
+    if (header.version != FORMAT_VERSION) fail("Unsupported snapshot version " + to_string(header.version));
+    if (checksum(data.data(), offsetof(Header, header_crc)) != header.header_crc) fail("Header checksum mismatch");
+    if (header.file_bytes != data.size()) fail("Snapshot is truncated or has trailing data");
+    if (header.section_count > SECTION_COUNT ||
+        sizeof(header) + header.section_count * sizeof(DirectoryEntry) > data.size()) {
+        fail("Damaged section directory");
+    }
+    const char* directory = data.data() + sizeof(header);
+    if (checksum(directory, header.section_count * sizeof(DirectoryEntry)) != header.directory_crc) {
+        fail("Directory checksum mismatch");
+    }
+
+    fields_ = header.fields;
+    headerCrc_ = header.header_crc;
+    objectCount_ = header.object_count;
+    dateCount_ = header.date_count;
+    for (uint32_t i = 0; i < header.section_count; ++i) {
+        DirectoryEntry entry;
+        memcpy(&entry, directory + i * sizeof(entry), sizeof(entry));
+        if (entry.section >= SECTION_COUNT || entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > data.size() ||
+            entry.bytes > data.size() - entry.offset) {
+            fail("Damaged section directory");
+        }
+        sections_[entry.section] = {data.data() + entry.offset, static_cast<size_t>(entry.bytes), entry.crc};
+    }
+
+    // Every section the fields call for must be there with one entry per object or per date
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        SectionShape shape = shape_of(s);
+        bool expected = shape.field == 0 || (fields_ & shape.field) != 0;
+        const Located& section = sections_[s];
+        if (expected != (section.data != nullptr) ||
+            (expected && shape.perObject && section.bytes != objectCount_ * shape.width) ||
+            (expected && section.bytes % shape.width != 0)) {
+            fail("Section " + to_string(s) + " is missing or has the wrong size");
+        }
+    }
+    if (sections_[DATES].bytes != dateCount_ * sizeof(int32_t) ||
+        sections_[DATE_FIRST].bytes != (dateCount_ + 1) * sizeof(uint32_t) ||
+        sections_[EXPLICIT_KEYS].bytes / sizeof(uint64_t) != sections_[EXPLICIT_ENDS].bytes / sizeof(uint32_t)) {
+        fail("Date or explicit-value sections do not match the header");
+    }
+    dates_ = column<int32_t>(DATES);
+    dateFirst_ = column<uint32_t>(DATE_FIRST);
+    ids_ = column<uint32_t>(IDS);
+    return true;
+}
+
+void CatalogSnapshot::close() {
+    file_.close();
+    for (auto& section : sections_) section = Located();
+    fields_ = 0;
+    headerCrc_ = 0;
+    objectCount_ = 0;
+    dateCount_ = 0;
+    dates_ = nullptr;
+    dateFirst_ = nullptr;
+    ids_ = nullptr;
+}
+
+bool CatalogSnapshot::verify() const {
+    for (const auto& section : sections_) {
+        if (section.data && checksum(section.data, section.bytes) != section.crc) return false;
+    }
+    return true;
+}
+
+Date CatalogSnapshot::date_of(size_t index) const {
+    // The last date whose first object is at or before index
+    const uint32_t* after = upper_bound(dateFirst_, dateFirst_ + dateCount_, static_cast<uint32_t>(index));
+    return date(static_cast<size_t>(after - dateFirst_) - 1);
+}
+
+size_t CatalogSnapshot::find_date(Date date) const {
+    const int32_t* found = lower_bound(dates_, dates_ + dateCount_, date.days);
+    return found != dates_ + dateCount_ && *found == date.days ? static_cast<size_t>(found - dates_) : dateCount_;
+}
+
+string_view CatalogSnapshot::text(Section ends, Section heap, size_t item) const {
+    const uint32_t* offsets = column<uint32_t>(ends);
+    uint32_t begin = item == 0 ? 0 : offsets[item - 1];
+    uint32_t end = offsets[item];
+    if (end < begin || end > sections_[heap].bytes) {
+        throw SnapshotError("Damaged string section " + to_string(heap));
+    }
+    return string_view(sections_[heap].data + begin, end - begin);
+}
+
+bool CatalogSnapshot::find_explicit(size_t index, uint32_t slot, string_view& value) const {
+    const uint64_t* keys = column<uint64_t>(EXPLICIT_KEYS);
+    size_t count = sections_[EXPLICIT_KEYS].bytes / sizeof(uint64_t);
+    uint64_t key = static_cast<uint64_t>(index) * 16 + slot;
+    const uint64_t* found = lower_bound(keys, keys + count, key);
+    if (found == keys + count || *found != key) return false;
+    value = text(EXPLICIT_ENDS, EXPLICIT_TEXT, static_cast<size_t>(found - keys));
+    return true;
+}
+
+string CatalogSnapshot::id(size_t index) const {
+    if (ids_[index] != 0) return to_string(ids_[index]);
+    string_view text;
+    find_explicit(index, SLOT_ID, text);
+    return string(text);
+}
+
+string_view CatalogSnapshot::name(size_t index) const {
+    return sections_[NAME_ENDS].data ? text(NAME_ENDS, NAME_TEXT, index) : string_view();
+}
+
+string CatalogSnapshot::nasa_jpl_url(size_t index) const {
+    if (!(fields_ & FIELD_JPL_URL)) return string();
+    string_view url;
+    return find_explicit(index, SLOT_URL, url) ? string(url) : sbdb_lookup_url(id(index));
+}
+
+double CatalogSnapshot::absolute_magnitude_h(size_t index) const {
+    return number(MAGNITUDES, index);
+}
+
+double CatalogSnapshot::number(Section section, size_t index) const {
+    const double* values = column<double>(section);
+    return values ? values[index] : 0.0;
+}
+
+bool CatalogSnapshot::is_potentially_hazardous(size_t index) const {
+    return flags() && (flags()[index] & FLAG_HAZARDOUS) != 0;
+}
+
+bool CatalogSnapshot::is_sentry_object(size_t index) const {
+    return flags() && (flags()[index] & FLAG_SENTRY) != 0;
+}
+
+int64_t CatalogSnapshot::epoch_ms(size_t index) const {
+    return epochs() ? epochs()[index] : 0;
+}
+
+Date CatalogSnapshot::close_approach_day(size_t index) const {
+    return approach_days() ? Date(approach_days()[index]) : Date();
+}
+
+string CatalogSnapshot::close_approach_date(size_t index) const {
+    return approach_days() ? format_date(close_approach_day(index)) : string();
+}
+
+string CatalogSnapshot::close_approach_date_full(size_t index) const {
+    if (!epochs()) return string();
+    string_view text;
+    return find_explicit(index, SLOT_DATE_FULL, text) ? string(text) : format_approach_time(epochs()[index]);
+}
+
+string CatalogSnapshot::orbiting_body(size_t index) const {
+    const uint8_t* bodies = column<uint8_t>(BODIES);
+    if (!bodies) return string();
+    if (static_cast<size_t>(bodies[index]) >= sections_[BODY_NAME_ENDS].bytes / sizeof(uint32_t)) {
+        throw SnapshotError("Damaged orbiting body code");
+    }
+    return string(text(BODY_NAME_ENDS, BODY_NAME_TEXT, bodies[index]));
+}
+
+string CatalogSnapshot::decimal_text(ProjectedCatalog::DecimalField field, size_t index) const {
+    const int64_t* digits = decimal_digits(field);
+    if (!digits) return string();
+    uint8_t scale = decimal_scales(field)[index];
+    if (scale == EXPLICIT_DECIMAL) {
+        string_view text;
+        find_explicit(index, SLOT_DECIMAL + field, text);
+        return string(text);
+    }
+    return scaled_decimal_text(digits[index], scale);
+}
+
+bool CatalogSnapshot::decimal_digits(ProjectedCatalog::DecimalField field, size_t index, int64_t& scaled,
+                                     uint8_t& scale) const {
+    const int64_t* digits = decimal_digits(field);
+    if (!digits || decimal_scales(field)[index] == EXPLICIT_DECIMAL) return false;
+    scaled = digits[index];
+    scale = decimal_scales(field)[index];
+    return true;
+}
+
+double CatalogSnapshot::decimal_value(ProjectedCatalog::DecimalField field, size_t index) const {
+    // Through the text, so the value is rounded exactly as decoding the feed rounds it
+    return decode_number(decimal_text(field, index));
+}
+
+NeoRecord CatalogSnapshot::record(size_t index) const {
+    NeoRecord record;
+    record.feed_date = format_date(date_of(index));
+    record.id = id(index);
+    record.name = string(name(index));
+    record.nasa_jpl_url = nasa_jpl_url(index);
+    record.absolute_magnitude_h = absolute_magnitude_h(index);
+    record.diameter_km_min = diameter_km_min(index);
+    record.diameter_km_max = diameter_km_max(index);
+    record.diameter_m_min = diameter_m_min(index);
+    record.diameter_m_max = diameter_m_max(index);
+    record.is_potentially_hazardous = is_potentially_hazardous(index);
+    record.is_sentry_object = is_sentry_object(index);
+    CloseApproach& approach = record.approach;
+    approach.date = close_approach_day(index);
+    approach.date_full = close_approach_date_full(index);
+    approach.epoch_ms = epoch_ms(index);
+    approach.velocity_km_s = decimal_value(ProjectedCatalog::VELOCITY_KM_S, index);
+    approach.velocity_km_h = decimal_value(ProjectedCatalog::VELOCITY_KM_H, index);
+    approach.miss_au = decimal_value(ProjectedCatalog::MISS_AU, index);
+    approach.miss_lunar = decimal_value(ProjectedCatalog::MISS_LUNAR, index);
+    approach.miss_km = decimal_value(ProjectedCatalog::MISS_KM, index);
+    approach.miss_miles = decimal_value(ProjectedCatalog::MISS_MILES, index);
+    approach.orbiting_body = orbiting_body(index);
+    return record;
+}
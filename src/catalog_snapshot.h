@@ -0,0 +1,228 @@
+#ifndef CATALOG_SNAPSHOT_H
+#define CATALOG_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "calendar.h"
+#include "mapped_file.h"
+#include "neo_projection.h"
+#include "neo_record.h"
+
+// A snapshot file that cannot be written, or read back as a snapshot
+class SnapshotError : public std::runtime_error {
+public:
+    explicit SnapshotError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+// Binary snapshot of a ProjectedCatalog, laid out so that it can be mapped and used in place.
+//
+// A 64-byte header (magic, format version, byte order, the projected fields and the object and
+// date counts) is followed by a directory with the offset, size and crc32 of every section, and
+// then the sections, each 8-byte aligned:
+//   - fixed-width columns with one entry per object: numeric id, magnitude, the four diameters,
+//     flags, epoch, approach day, and each decimal field as a scaled integer plus its scale
+//   - string columns as a heap of the texts back to back plus a column of their end offsets:
+//     names, and the orbiting bodies as a dictionary with a one-byte code per object
+//   - the feed dates and where each date's objects start
+//   - values the columns cannot express (text ids, and URLs, full dates or decimals that do not
+//     follow the rules ProjectedCatalog applies), as a sorted key column and a string column
+// Fields the catalog did not keep have no sections. Integers are little-endian.
+//
+// The header and directory carry their own crc32 and are checked on open; the sections are
+// checked by verify(), which reads the whole file, so opening costs the same at any size.
+namespace snapshot {
+
+const char MAGIC[8] = {'N', 'E', 'O', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t FORMAT_VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+enum Section : uint32_t {
+    DATES,                  // int32 day number per date
+    DATE_FIRST,             // uint32 per date plus one: objects of date d are [first[d], first[d + 1])
+    IDS,                    // uint32; 0 when the id is text (see EXPLICIT_KEYS)
+    NAME_ENDS,              // uint32
+    NAME_TEXT,
+    MAGNITUDES,             // double
+    DIAMETER_KM_MIN,        // double, then km max, m min, m max
+    DIAMETER_KM_MAX,
+    DIAMETER_M_MIN,
+    DIAMETER_M_MAX,
+    FLAGS,                  // uint8: bit 0 potentially hazardous, bit 1 sentry
+    EPOCHS,                 // int64 ms
+    APPROACH_DAYS,          // int32 day number
+    DECIMAL_DIGITS,         // int64 per decimal field, in ProjectedCatalog::DecimalField order
+    DECIMAL_SCALES = DECIMAL_DIGITS + ProjectedCatalog::DECIMAL_FIELDS,   // uint8; 0xFF = explicit
+    BODIES = DECIMAL_SCALES + ProjectedCatalog::DECIMAL_FIELDS,           // uint8 dictionary code
+    BODY_NAME_ENDS,         // uint32 per dictionary entry
+    BODY_NAME_TEXT,
+    EXPLICIT_KEYS,          // uint64 object * 16 + slot, ascending
+    EXPLICIT_ENDS,          // uint32 per key
+    EXPLICIT_TEXT,
+    SECTION_COUNT
+};
+
+// Slots of the explicit-value table
+enum ExplicitSlot : uint32_t { SLOT_ID, SLOT_URL, SLOT_DATE_FULL, SLOT_DECIMAL };
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t fields;                // ProjectedField bits the catalog kept
+    uint32_t section_count;
+    uint64_t object_count;
+    uint64_t date_count;
+    uint64_t file_bytes;
+    uint32_t directory_crc;         // crc32 of the directory
+    uint32_t header_crc;            // crc32 of the header up to this field
+    uint64_t reserved;
+};
+
+struct DirectoryEntry {
+    uint32_t section;
+    uint32_t crc;                   // crc32 of the section's bytes
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+// crc32 of a byte range of any length, as the header, directory and sections carry it
+uint32_t checksum(const char* data, size_t bytes);
+
+} // namespace snapshot
+
+class CatalogSnapshot;
+
+// Lays out a snapshot day by day from catalogs and other snapshots with the same fields, so
+// snapshots can be merged without rebuilding a ProjectedCatalog. Days must come in date order.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(uint32_t fields);
+
+    // Appends one date and its objects; SnapshotError when the fields differ, the date is not
+    // after the last one added, or a feed date is not YYYY-MM-DD
+    void add_day(const ProjectedCatalog& catalog, size_t date);
+    void add_day(const CatalogSnapshot& snapshot, size_t date);
+
+    size_t size() const { return objectCount_; }
+    size_t date_count() const { return dateCount_; }
+
+    // Writes through a temporary file and a rename, so readers never see a partial snapshot;
+    // SnapshotError when the file cannot be written
+    void write(const std::string& path) const;
+
+private:
+    template <typename Catalog>
+    void add_objects(const Catalog& catalog, Date day, size_t begin, size_t end);
+
+    uint32_t fields_;
+    std::vector<std::string> sections_;
+    std::vector<std::string> bodyNames_;
+    size_t objectCount_ = 0;
+    size_t dateCount_ = 0;
+    Date lastDate_;
+};
+
+// Writes the whole catalog to path with a SnapshotWriter
+void write_catalog_snapshot(const ProjectedCatalog& catalog, const std::string& path);
+
+// A snapshot mapped read-only. Opening checks the header and the directory and touches nothing
+// else; columns are read in place, so a scan over one column pages in only that column. Field
+// accessors return what the ProjectedCatalog that was written returns.
+class CatalogSnapshot {
+public:
+    CatalogSnapshot() = default;
+    CatalogSnapshot(const CatalogSnapshot&) = delete;
+    CatalogSnapshot& operator=(const CatalogSnapshot&) = delete;
+
+    // False when the file cannot be mapped; SnapshotError when it is not a snapshot this
+    // version reads, or its header or directory is damaged
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return file_.is_open(); }
+
+    // Checks every section against its crc32; false on the first mismatch
+    bool verify() const;
+
+    uint32_t fields() const { return fields_; }
+    // The header's crc32, which covers the directory and through it every section; identifies
+    // the snapshot's contents for files built from it
+    uint32_t header_crc() const { return headerCrc_; }
+    size_t size() const { return objectCount_; }
+    size_t file_bytes() const { return file_.contents().size(); }
+
+    size_t date_count() const { return dateCount_; }
+    Date date(size_t date) const { return Date(dates_[date]); }
+    size_t date_begin(size_t date) const { return dateFirst_[date]; }
+    Date date_of(size_t index) const;
+    // Index of a feed date, or date_count() when the snapshot does not have it
+    size_t find_date(Date date) const;
+
+    // Whole columns for scans; nullptr when the catalog did not keep the field
+    const uint32_t* ids() const { return ids_; }
+    const double* magnitudes() const { return column<double>(snapshot::MAGNITUDES); }
+    const uint8_t* flags() const { return column<uint8_t>(snapshot::FLAGS); }
+    const int64_t* epochs() const { return column<int64_t>(snapshot::EPOCHS); }
+    const int32_t* approach_days() const { return column<int32_t>(snapshot::APPROACH_DAYS); }
+    const int64_t* decimal_digits(ProjectedCatalog::DecimalField field) const {
+        return column<int64_t>(snapshot::Section(snapshot::DECIMAL_DIGITS + field));
+    }
+    const uint8_t* decimal_scales(ProjectedCatalog::DecimalField field) const {
+        return column<uint8_t>(snapshot::Section(snapshot::DECIMAL_SCALES + field));
+    }
+
+    // Field access; fields that were not kept read as empty / 0 / false
+    std::string id(size_t index) const;
+    std::string_view name(size_t index) const;
+    std::string nasa_jpl_url(size_t index) const;
+    double absolute_magnitude_h(size_t index) const;
+    double diameter_km_min(size_t index) const { return number(snapshot::DIAMETER_KM_MIN, index); }
+    double diameter_km_max(size_t index) const { return number(snapshot::DIAMETER_KM_MAX, index); }
+    double diameter_m_min(size_t index) const { return number(snapshot::DIAMETER_M_MIN, index); }
+    double diameter_m_max(size_t index) const { return number(snapshot::DIAMETER_M_MAX, index); }
+    bool is_potentially_hazardous(size_t index) const;
+    bool is_sentry_object(size_t index) const;
+    int64_t epoch_ms(size_t index) const;
+    Date close_approach_day(size_t index) const;
+    std::string close_approach_date(size_t index) const;
+    std::string close_approach_date_full(size_t index) const;
+    std::string orbiting_body(size_t index) const;
+    std::string decimal_text(ProjectedCatalog::DecimalField field, size_t index) const;
+    double decimal_value(ProjectedCatalog::DecimalField field, size_t index) const;
+
+    // The scaled integer behind decimal_text; false when the field was not kept or is stored as text
+    bool decimal_digits(ProjectedCatalog::DecimalField field, size_t index, int64_t& scaled, uint8_t& scale) const;
+
+    // Everything NeoRecord holds
+    NeoRecord record(size_t index) const;
+
+private:
+    struct Located {
+        const char* data = nullptr;
+        size_t bytes = 0;
+        uint32_t crc = 0;
+    };
+
+    template <typename T>
+    const T* column(snapshot::Section section) const {
+        return reinterpret_cast<const T*>(sections_[section].data);
+    }
+    double number(snapshot::Section section, size_t index) const;
+    std::string_view text(snapshot::Section ends, snapshot::Section heap, size_t item) const;
+    bool find_explicit(size_t index, uint32_t slot, std::string_view& value) const;
+
+    MappedFile file_;
+    Located sections_[snapshot::SECTION_COUNT];
+    uint32_t fields_ = 0;
+    uint32_t headerCrc_ = 0;
+    size_t objectCount_ = 0;
+    size_t dateCount_ = 0;
+    const int32_t* dates_ = nullptr;
+    const uint32_t* dateFirst_ = nullptr;
+    const uint32_t* ids_ = nullptr;
+};
+
+#endif // CATALOG_SNAPSHOT_H
@@ -0,0 +1,42 @@
+#ifndef DECODE_RESULT_H
+#define DECODE_RESULT_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <variant>
+
+// Why one record of a feed could not be decoded
+struct DecodeError {
+    size_t offset = 0;         // byte offset of the offending value in the document
+    std::string path;          // field path inside the record, e.g. "close_approach_data.0.miss_distance.lunar"
+    std::string message;
+};
+
+// "message at byte N (path)", in the form JsonStreamError uses
+inline std::string describe(const DecodeError& error) {
+    std::string text = error.message + " at byte " + std::to_string(error.offset);
+    return error.path.empty() ? text : text + " (" + error.path + ")";
+}
+
+// A decoded value or the error that kept it from being decoded. Record decoding returns these
+// instead of throwing, so a malformed record costs a branch where it is skipped rather than an
+// unwind through the decoder.
+template <typename T>
+class DecodeResult {
+public:
+    DecodeResult(T value) : state_(std::move(value)) {}
+    DecodeResult(DecodeError error) : state_(std::move(error)) {}
+
+    bool ok() const { return state_.index() == 0; }
+    explicit operator bool() const { return ok(); }
+
+    T& value() { return std::get<0>(state_); }
+    const T& value() const { return std::get<0>(state_); }
+    const DecodeError& error() const { return std::get<1>(state_); }
+
+private:
+    std::variant<T, DecodeError> state_;
+};
+
+#endif // DECODE_RESULT_H
@@ -0,0 +1,173 @@
+#include <cfloat>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "fast_number.h"
+
+using namespace std;
+
+namespace {
+
+// Powers of ten that are exact doubles
+const double EXACT_POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+const int MAX_EXACT_POWER = 22;
+const uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+const int MAX_MANTISSA_DIGITS = 19;   // every 19-digit decimal fits in a uint64_t
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const bool SWAR_DIGITS = false;
+#else
+const bool SWAR_DIGITS = true;
+#endif
+
+uint64_t load8(const char* p) {
+    uint64_t chunk;
+    memcpy(&chunk, p, sizeof(chunk));
+    return chunk;
+}
+
+// True when all eight bytes are ASCII digits
+bool is_eight_digits(uint64_t chunk) {
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+            0x3333333333333333ULL);
+}
+
+// Value of eight ASCII digits (first digit in the lowest byte), combined pairwise in three multiplies
+uint32_t eight_digits_value(uint64_t chunk) {
+    chunk = (chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    chunk = (chunk & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return static_cast<uint32_t>((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32);
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Function to read a run of digits into mantissa. Leading zeros of the whole number are not
+// significant; digits beyond MAX_MANTISSA_DIGITS only mark the mantissa as truncated.
+const char* read_digits(const char* p, const char* end, uint64_t& mantissa, int& significant, bool& truncated) {
+    while (true) {
+        if (SWAR_DIGITS && significant > 0 && significant + 8 <= MAX_MANTISSA_DIGITS && end - p >= 8) {
+            uint64_t chunk = load8(p);
+            if (is_eight_digits(chunk)) {
+                mantissa = mantissa * 100000000 + eight_digits_value(chunk);
+                significant += 8;
+                p += 8;
+                continue;
+            }
+        }
+        if (p == end || !is_digit(*p)) return p;
+        unsigned digit = static_cast<unsigned>(*p - '0');
+        if (significant < MAX_MANTISSA_DIGITS) {
+            if (significant > 0 || digit != 0) {
+                mantissa = mantissa * 10 + digit;
+                ++significant;
+            }
+        } else {
+            truncated = true;
+            ++significant;
+        }
+        ++p;
+    }
+}
+
+bool parse_with_strtod(const char* begin, const char* end, double& value) {
+    // strtod needs a terminated buffer; the program never changes LC_NUMERIC from "C"
+    char buffer[128];
+    size_t size = static_cast<size_t>(end - begin);
+    if (size >= sizeof(buffer)) return false;
+    memcpy(buffer, begin, size);
+    buffer[size] = '\0';
+    char* parsedEnd = nullptr;
+    double parsed = strtod(buffer, &parsedEnd);
+    if (parsedEnd != buffer + size) return false;
+    value = parsed;
+    return true;
+}
+
+// Correctly rounded fallback for what the fast path cannot do exactly
+bool parse_slow(const char* begin, const char* end, double& value) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    double parsed = 0.0;
+    auto result = from_chars(begin, end, parsed);
+    if (result.ec == errc() && result.ptr == end) {
+        value = parsed;
+        return true;
+    }
+    // Out-of-range values keep strtod's overflow/underflow results (inf, 0, denormals)
+#endif
+    return parse_with_strtod(begin, end, value);
+}
+
+} // namespace
+
+bool parse_decimal(string_view text, double& value) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    const char* begin = p;
+
+    bool negative = p != end && *p == '-';
+    if (negative) ++p;
+    if (p == end || !is_digit(*p)) return false;
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    bool truncated = false;
+
+    const char* integerStart = p;
+    p = read_digits(p, end, mantissa, significant, truncated);
+    if (*integerStart == '0' && p - integerStart > 1) return false;   // JSON forbids leading zeros
+    int exponent = 0;
+
+    if (p != end && *p == '.') {
+        const char* fractionStart = ++p;
+        p = read_digits(p, end, mantissa, significant, truncated);
+        if (p == fractionStart) return false;
+        // Every fraction digit scales the mantissa down, leading zeros included
+        exponent -= static_cast<int>(p - fractionStart);
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = p != end && *p == '-';
+        if (p != end && (*p == '+' || *p == '-')) ++p;
+        if (p == end || !is_digit(*p)) return false;
+        int explicitExponent = 0;
+        for (; p != end && is_digit(*p); ++p) {
+            if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (p != end) return false;
+
+    // Clinger's fast path: both operands are exact doubles, so the one rounding is the right one.
+    // Truncated mantissas (more than 19 significant digits) always take the slow path.
+#if FLT_EVAL_METHOD == 0
+    if (!truncated && mantissa <= MAX_EXACT_MANTISSA && exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER) {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent] : result * EXACT_POWERS_OF_TEN[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+#endif
+    if (!truncated && mantissa == 0) {
+        value = negative ? -0.0 : 0.0;
+        return true;
+    }
+    return parse_slow(begin, end, value);
+}
+
+size_t parse_decimals(const string_view* texts, size_t count, double* values) {
+    size_t failures = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!parse_decimal(texts[i], values[i])) {
+            values[i] = 0.0;
+            ++failures;
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,19 @@
+#ifndef FAST_NUMBER_H
+#define FAST_NUMBER_H
+
+#include <cstddef>
+#include <string_view>
+
+// Locale-free, allocation-free decimal to double conversion for the numbers NeoWs sends (plain
+// JSON numbers, often wrapped in strings). Digits are read eight at a time with SWAR arithmetic;
+// values with at most 19 significant digits and a small exponent are finished with an exact
+// Clinger fast path, and everything else goes to std::from_chars (or strtod where from_chars
+// has no floating-point support). Results are correctly rounded either way.
+
+// Parses the whole of text as a JSON number; false (and value untouched) when it is not one
+bool parse_decimal(std::string_view text, double& value);
+
+// Parses count numbers into values; returns how many failed (those entries are set to 0)
+size_t parse_decimals(const std::string_view* texts, size_t count, double* values);
+
+#endif // FAST_NUMBER_H
@@ -0,0 +1,1323 @@
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <string_view>
+#include "approach_history.h"
+#include "calendar.h"
+#include "catalog_index.h"
+#include "catalog_segments.h"
+#include "catalog_snapshot.h"
+#include "fast_number.h"
+#include "feed_benchmark.h"
+#include "feed_decoder.h"
+#include "feed_index.h"
+#include "feed_stream.h"
+#include "get_data.h"
+#include "latency_recorder.h"
+#include "neo_projection.h"
+#include "neo_fetcher.h"
+#include "series_codec.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Total time spent per method before the best run is taken
+const double MIN_BENCH_MS = 300.0;
+const int MAX_BENCH_RUNS = 50;
+
+// Keeps results the checksum does not cover from being optimized away
+volatile double benchmarkSink = 0.0;
+
+template <typename Record>
+double record_checksum(const Record& record) {
+    return record.absolute_magnitude_h + record.diameter_km_min + record.diameter_km_max +
+           record.approach.velocity_km_s + record.approach.miss_km + (record.is_potentially_hazardous ? 1.0 : 0.0) +
+           static_cast<double>(record.id.size() + record.name.size() + record.approach.date.days);
+}
+
+// The diameter lookups calculateMass(const json&) made on every call
+double mass_lookups(const json& asteroidData) {
+    return asteroidData["estimated_diameter"]["kilometers"]["estimated_diameter_min"].get<double>() +
+           asteroidData["estimated_diameter"]["kilometers"]["estimated_diameter_max"].get<double>();
+}
+
+// The lookups Asteroid(const json&) made, including calculateMass running twice and the
+// sub-object copies
+NeoRecord record_from_dom(const json& asteroidData, double& massInputs) {
+    NeoRecord record;
+    record.name = asteroidData["name"];
+    record.diameter_km_min = asteroidData["estimated_diameter"]["kilometers"]["estimated_diameter_min"].get<double>();
+    massInputs += mass_lookups(asteroidData);
+    record.id = asteroidData["id"];
+    record.nasa_jpl_url = asteroidData["nasa_jpl_url"];
+    record.absolute_magnitude_h = asteroidData["absolute_magnitude_h"];
+    record.is_potentially_hazardous = asteroidData["is_potentially_hazardous_asteroid"];
+    auto diameter = asteroidData["estimated_diameter"];
+    record.diameter_km_min = diameter["kilometers"]["estimated_diameter_min"].get<double>();
+    record.diameter_km_max = diameter["kilometers"]["estimated_diameter_max"].get<double>();
+    auto close_approach = asteroidData["close_approach_data"][0];
+    record.approach.date = parse_date(close_approach["close_approach_date"].get<string>());
+    record.approach.velocity_km_s = stod(close_approach["relative_velocity"]["kilometers_per_second"].get<string>());
+    record.approach.miss_km = stod(close_approach["miss_distance"]["kilometers"].get<string>());
+    massInputs += mass_lookups(asteroidData);
+    return record;
+}
+
+// Every NeoRecord field read with chained operator[] lookups, one path at a time
+NeoRecord record_from_chained_lookups(const json& neo) {
+    NeoRecord record;
+    record.id = neo["id"].get<string>();
+    record.name = neo["name"].get<string>();
+    record.nasa_jpl_url = neo["nasa_jpl_url"].get<string>();
+    record.absolute_magnitude_h = neo["absolute_magnitude_h"].get<double>();
+    record.diameter_km_min = neo["estimated_diameter"]["kilometers"]["estimated_diameter_min"].get<double>();
+    record.diameter_km_max = neo["estimated_diameter"]["kilometers"]["estimated_diameter_max"].get<double>();
+    record.diameter_m_min = neo["estimated_diameter"]["meters"]["estimated_diameter_min"].get<double>();
+    record.diameter_m_max = neo["estimated_diameter"]["meters"]["estimated_diameter_max"].get<double>();
+    record.is_potentially_hazardous = neo["is_potentially_hazardous_asteroid"].get<bool>();
+    record.is_sentry_object = neo["is_sentry_object"].get<bool>();
+    record.approach.date = parse_date(neo["close_approach_data"][0]["close_approach_date"].get<string>());
+    record.approach.date_full = neo["close_approach_data"][0]["close_approach_date_full"].get<string>();
+    record.approach.epoch_ms = neo["close_approach_data"][0]["epoch_date_close_approach"].get<int64_t>();
+    record.approach.velocity_km_s = stod(neo["close_approach_data"][0]["relative_velocity"]["kilometers_per_second"].get<string>());
+    record.approach.velocity_km_h = stod(neo["close_approach_data"][0]["relative_velocity"]["kilometers_per_hour"].get<string>());
+    record.approach.miss_au = stod(neo["close_approach_data"][0]["miss_distance"]["astronomical"].get<string>());
+    record.approach.miss_lunar = stod(neo["close_approach_data"][0]["miss_distance"]["lunar"].get<string>());
+    record.approach.miss_km = stod(neo["close_approach_data"][0]["miss_distance"]["kilometers"].get<string>());
+    record.approach.miss_miles = stod(neo["close_approach_data"][0]["miss_distance"]["miles"].get<string>());
+    record.approach.orbiting_body = neo["close_approach_data"][0]["orbiting_body"].get<string>();
+    return record;
+}
+
+// Function to run one method repeatedly and keep its fastest run
+template <typename Method>
+DecodeTiming time_method(const string& name, Method method) {
+    DecodeTiming timing;
+    timing.method = name;
+    timing.best_ms = 1e300;
+    double spent = 0.0;
+    for (int run = 0; run < MAX_BENCH_RUNS && (run < 3 || spent < MIN_BENCH_MS); ++run) {
+        Clock::time_point started = Clock::now();
+        size_t records = 0;
+        double checksum = 0.0;
+        method(records, checksum);
+        double ms = chrono::duration<double, milli>(Clock::now() - started).count();
+        spent += ms;
+        timing.best_ms = min(timing.best_ms, ms);
+        timing.records = records;
+        timing.checksum = checksum;
+    }
+    return timing;
+}
+
+DecodeBenchmark benchmark_body(const string& label, const string& body) {
+    DecodeBenchmark result;
+    result.input = label;
+    result.bytes = body.size();
+    result.timings.push_back(time_method("nlohmann DOM", [&](size_t& records, double& checksum) {
+        json document = json::parse(body);
+        double massInputs = 0.0;
+        for (const auto& [date, neos] : document["near_earth_objects"].items()) {
+            for (const auto& neo : neos) {
+                checksum += record_checksum(record_from_dom(neo, massInputs));
+                ++records;
+            }
+        }
+        benchmarkSink += massInputs;
+    }));
+    result.timings.push_back(time_method("decode_feed", [&](size_t& records, double& checksum) {
+        DecodedFeed feed = decode_feed(body);
+        for (const auto& record : feed.records) {
+            checksum += record_checksum(record);
+        }
+        records = feed.records.size();
+    }));
+    result.timings.push_back(time_method("decode_feed_view", [&](size_t& records, double& checksum) {
+        deque<string> unescaped;
+        FeedView feed = decode_feed_view(body, unescaped);
+        for (const auto& record : feed.records) {
+            checksum += record_checksum(record);
+        }
+        records = feed.records.size();
+    }));
+    return result;
+}
+
+// The listing and hazard-filter access pattern: one or two fields per object
+DecodeBenchmark benchmark_lazy(const string& label, const string& body) {
+    DecodeBenchmark result;
+    result.input = label + " (names and hazard flags)";
+    result.bytes = body.size();
+    result.timings.push_back(time_method("decode_feed", [&](size_t& records, double& checksum) {
+        DecodedFeed feed = decode_feed(body);
+        for (const auto& record : feed.records) {
+            checksum += static_cast<double>(record.name.size()) + (record.is_potentially_hazardous ? 1.0 : 0.0);
+        }
+        records = feed.records.size();
+    }));
+    result.timings.push_back(time_method("FeedIndex", [&](size_t& records, double& checksum) {
+        FeedIndex index(body);
+        for (size_t i = 0; i < index.object_count(); ++i) {
+            NeoCursor neo = index.object(i);
+            checksum += static_cast<double>(neo.name().size()) + (neo.is_potentially_hazardous() ? 1.0 : 0.0);
+        }
+        records = index.object_count();
+    }));
+    return result;
+}
+
+// Reading every record field from an already parsed document: chained lookups in the DOM,
+// one NeoCursor path at a time, and one compiled FieldExtractor pass per object
+DecodeBenchmark benchmark_extraction(const string& label, const string& body) {
+    DecodeBenchmark result;
+    result.input = label + " (field extraction from a parsed document)";
+    result.bytes = body.size();
+    const json document = json::parse(body);
+    FeedIndex index(body);
+    result.timings.push_back(time_method("operator[]", [&](size_t& records, double& checksum) {
+        for (const auto& [date, neos] : document["near_earth_objects"].items()) {
+            for (const auto& neo : neos) {
+                checksum += record_checksum(record_from_chained_lookups(neo));
+                ++records;
+            }
+        }
+    }));
+    result.timings.push_back(time_method("NeoCursor paths", [&](size_t& records, double& checksum) {
+        for (size_t i = 0; i < index.object_count(); ++i) {
+            NeoCursor neo = index.object(i);
+            NeoRecord record;
+            record.id = neo.id();
+            record.name = neo.name();
+            record.nasa_jpl_url = neo.text("nasa_jpl_url");
+            record.absolute_magnitude_h = neo.number("absolute_magnitude_h");
+            record.diameter_km_min = neo.number("estimated_diameter.kilometers.estimated_diameter_min");
+            record.diameter_km_max = neo.number("estimated_diameter.kilometers.estimated_diameter_max");
+            record.diameter_m_min = neo.number("estimated_diameter.meters.estimated_diameter_min");
+            record.diameter_m_max = neo.number("estimated_diameter.meters.estimated_diameter_max");
+            record.is_potentially_hazardous = neo.is_potentially_hazardous();
+            record.is_sentry_object = neo.flag("is_sentry_object");
+            record.approach.date = decode_date(neo.raw("close_approach_data.0.close_approach_date"));
+            record.approach.date_full = neo.text("close_approach_data.0.close_approach_date_full");
+            record.approach.epoch_ms = static_cast<int64_t>(neo.number("close_approach_data.0.epoch_date_close_approach"));
+            record.approach.velocity_km_s = neo.number("close_approach_data.0.relative_velocity.kilometers_per_second");
+            record.approach.velocity_km_h = neo.number("close_approach_data.0.relative_velocity.kilometers_per_hour");
+            record.approach.miss_au = neo.number("close_approach_data.0.miss_distance.astronomical");
+            record.approach.miss_lunar = neo.number("close_approach_data.0.miss_distance.lunar");
+            record.approach.miss_km = neo.number("close_approach_data.0.miss_distance.kilometers");
+            record.approach.miss_miles = neo.number("close_approach_data.0.miss_distance.miles");
+            record.approach.orbiting_body = neo.text("close_approach_data.0.orbiting_body");
+            checksum += record_checksum(record);
+        }
+        records = index.object_count();
+    }));
+    result.timings.push_back(time_method("FieldExtractor", [&](size_t& records, double& checksum) {
+        RecordExtractor extractor;
+        for (size_t i = 0; i < index.object_count(); ++i) {
+            checksum += record_checksum(extractor.extract(index.object(i)));
+        }
+        records = index.object_count();
+    }));
+    return result;
+}
+
+// Strings that sit on rounding boundaries or at the ends of the double range
+const char* const EDGE_CASE_NUMBERS[] = {
+    "0", "-0", "0.0", "1", "-1", "0.1", "0.2", "0.3", "1e23", "8.98846567431158e307",
+    "9007199254740992", "9007199254740993", "9007199254740995", "18446744073709551615",
+    "18446744073709551616", "123456789012345678901234567890", "2.2250738585072014e-308",
+    "2.2250738585072011e-308", "4.9e-324", "2.4703282292062327e-324", "1e-400",
+    "1.7976931348623157e308", "1.7976931348623158e308", "1e308", "0.000000000000000000000001",
+    "3.141592653589793238462643383279", "7.2340981233E-1", "1E22", "1e-22", "123456.7890123456",
+};
+const size_t SYNTHETIC_NUMBERS = 200000;
+
+// Function to collect the numeric strings and numbers of a document, as NeoWs wrote them
+void collect_numbers(const json& value, vector<string>& out) {
+    if (value.is_object() || value.is_array()) {
+        for (const auto& element : value) collect_numbers(element, out);
+    } else if (value.is_number()) {
+        out.push_back(value.dump());
+    } else if (value.is_string()) {
+        const string& text = value.get_ref<const string&>();
+        char* parsedEnd = nullptr;
+        if (!text.empty() && (text[0] == '-' || (text[0] >= '0' && text[0] <= '9')) &&
+            (strtod(text.c_str(), &parsedEnd), parsedEnd == text.c_str() + text.size())) {
+            out.push_back(text);
+        }
+    }
+}
+
+// Random values in the shapes the feed uses: fixed ten-place decimals (velocities, distances)
+// and shortest round-trip forms (diameters, magnitudes)
+void add_synthetic_numbers(vector<string>& out) {
+    mt19937_64 random(20240613);
+    uniform_real_distribution<double> magnitude(-12.0, 9.0);
+    char buffer[64];
+    for (size_t i = 0; i < SYNTHETIC_NUMBERS; ++i) {
+        double value = pow(10.0, magnitude(random));
+        switch (i % 4) {
+            case 0: snprintf(buffer, sizeof(buffer), "%.10f", value); break;
+            case 1: snprintf(buffer, sizeof(buffer), "%.17g", value); break;
+            case 2: snprintf(buffer, sizeof(buffer), "%.15g", value * 1e6); break;
+            default: {
+                // Raw bit patterns cover the whole range, denormals included
+                uint64_t bits = random() & 0x7FEFFFFFFFFFFFFFULL;
+                memcpy(&value, &bits, sizeof(value));
+                snprintf(buffer, sizeof(buffer), "%.17g", value);
+            }
+        }
+        out.push_back(buffer);
+    }
+    for (const char* text : EDGE_CASE_NUMBERS) out.push_back(text);
+}
+
+bool same_bits(double a, double b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Heap bytes of a string beyond the object itself; short ones live inside it
+size_t string_heap_bytes(const string& text) {
+    return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+// Function to estimate the heap a json value holds: std::map nodes for objects, vectors of
+// values for arrays, and the strings, on top of the 16-byte json value itself
+size_t dom_heap_bytes(const json& value) {
+    const size_t MAP_NODE_LINKS = 32;    // parent, children and colour of a red-black tree node
+    size_t bytes = 0;
+    if (value.is_object()) {
+        bytes += sizeof(json::object_t);
+        for (const auto& [key, member] : value.get_ref<const json::object_t&>()) {
+            bytes += MAP_NODE_LINKS + sizeof(json::object_t::value_type) + string_heap_bytes(key) +
+                     dom_heap_bytes(member);
+        }
+    } else if (value.is_array()) {
+        const auto& elements = value.get_ref<const json::array_t&>();
+        bytes += sizeof(json::array_t) + elements.capacity() * sizeof(json);
+        for (const auto& element : elements) bytes += dom_heap_bytes(element);
+    } else if (value.is_string()) {
+        bytes += sizeof(json::string_t) + string_heap_bytes(value.get_ref<const json::string_t&>());
+    }
+    return bytes;
+}
+
+size_t record_bytes(const DecodedFeed& feed) {
+    size_t bytes = sizeof(feed) + feed.records.capacity() * sizeof(NeoRecord);
+    for (const auto& date : feed.dates) bytes += sizeof(string) + string_heap_bytes(date);
+    for (const auto& record : feed.records) {
+        bytes += string_heap_bytes(record.feed_date) + string_heap_bytes(record.id) + string_heap_bytes(record.name) +
+                 string_heap_bytes(record.nasa_jpl_url) + string_heap_bytes(record.approach.date_full) +
+                 string_heap_bytes(record.approach.orbiting_body);
+    }
+    return bytes;
+}
+
+bool same_record(const NeoRecord& a, const NeoRecord& b) {
+    const CloseApproach& x = a.approach;
+    const CloseApproach& y = b.approach;
+    return a.feed_date == b.feed_date && a.id == b.id && a.name == b.name && a.nasa_jpl_url == b.nasa_jpl_url &&
+           same_bits(a.absolute_magnitude_h, b.absolute_magnitude_h) && same_bits(a.diameter_km_min, b.diameter_km_min) &&
+           same_bits(a.diameter_km_max, b.diameter_km_max) && same_bits(a.diameter_m_min, b.diameter_m_min) &&
+           same_bits(a.diameter_m_max, b.diameter_m_max) && a.is_potentially_hazardous == b.is_potentially_hazardous &&
+           a.is_sentry_object == b.is_sentry_object && x.date == y.date && x.date_full == y.date_full &&
+           x.epoch_ms == y.epoch_ms && same_bits(x.velocity_km_s, y.velocity_km_s) &&
+           same_bits(x.velocity_km_h, y.velocity_km_h) && same_bits(x.miss_au, y.miss_au) &&
+           same_bits(x.miss_lunar, y.miss_lunar) && same_bits(x.miss_km, y.miss_km) &&
+           same_bits(x.miss_miles, y.miss_miles) && x.orbiting_body == y.orbiting_body;
+}
+
+// Function to damage `percent` of a feed's records, spread evenly, cycling through values of
+// the wrong type, an impossible date and a missing id
+string corrupt_feed(const string& body, size_t percent, size_t& corrupted) {
+    json document = json::parse(body);
+    size_t seen = 0;
+    corrupted = 0;
+    for (auto& [date, neos] : document["near_earth_objects"].items()) {
+        for (auto& neo : neos) {
+            // Damage a record whenever the running share of damaged ones falls below percent
+            if (percent == 0 || ++seen * percent < (corrupted + 1) * 100) continue;
+            json& approach = neo["close_approach_data"][0];
+            switch (corrupted++ % 7) {
+                case 0: approach["relative_velocity"]["kilometers_per_second"] = "fast"; break;
+                case 1: neo["absolute_magnitude_h"] = "n/a"; break;
+                case 2: neo["is_potentially_hazardous_asteroid"] = "maybe"; break;
+                case 3: approach["epoch_date_close_approach"] = "soon"; break;
+                case 4: neo.erase("id"); break;
+                case 5: approach["close_approach_date"] = "2023-02-29"; break;
+                default: neo["name"] = 42; break;
+            }
+        }
+    }
+    return document.dump();
+}
+
+// Function to capture what a printing function writes to cout
+template <typename Print>
+string captured_output(Print print) {
+    ostringstream captured;
+    streambuf* saved = cout.rdbuf(captured.rdbuf());
+    try {
+        print();
+    } catch (...) {
+        cout.rdbuf(saved);
+        throw;
+    }
+    cout.rdbuf(saved);
+    return captured.str();
+}
+
+} // namespace
+
+string synthesize_feed(const string& body, size_t copies, size_t firstCopy) {
+    json source = json::parse(body);
+    json& days = source["near_earth_objects"];
+    long span = static_cast<long>(days.size());
+    json synthetic;
+    size_t count = 0;
+    for (size_t copy = firstCopy; copy < firstCopy + copies; ++copy) {
+        for (const auto& [date, neos] : days.items()) {
+            synthetic["near_earth_objects"][add_days(date, static_cast<long>(copy) * span)] = neos;
+            count += neos.size();
+        }
+    }
+    synthetic["element_count"] = count;
+    synthetic["links"] = source.value("links", json::object());
+    return synthetic.dump();
+}
+
+vector<DecodeBenchmark> run_decode_benchmark(const string& path, size_t scale) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string body = contents.str();
+
+    vector<DecodeBenchmark> results;
+    results.push_back(benchmark_body(path, body));
+    results.push_back(benchmark_lazy(path, body));
+    results.push_back(benchmark_extraction(path, body));
+    if (scale > 1) {
+        string synthetic = synthesize_feed(body, scale);
+        string label = path + " x" + to_string(scale);
+        results.push_back(benchmark_body(label, synthetic));
+        results.push_back(benchmark_lazy(label, synthetic));
+        results.push_back(benchmark_extraction(label, synthetic));
+    }
+    return results;
+}
+
+string format_decode_benchmark(const vector<DecodeBenchmark>& results) {
+    ostringstream out;
+    out << fixed;
+    for (const auto& result : results) {
+        out << result.input << " (" << setprecision(2) << result.bytes / 1e6 << " MB)" << endl;
+        out << left << setw(20) << "  Method" << right << setw(12) << "Best (ms)" << setw(12) << "MB/s" << setw(10)
+            << "Records" << setw(10) << "Speed-up" << endl;
+        double baseline = result.timings.empty() ? 0.0 : result.timings.front().best_ms;
+        for (const auto& timing : result.timings) {
+            double mbPerSecond = timing.best_ms > 0 ? result.bytes / 1e3 / timing.best_ms : 0.0;
+            out << "  " << left << setw(18) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+                << setprecision(1) << setw(12) << mbPerSecond << setw(10) << timing.records << setw(9)
+                << (timing.best_ms > 0 ? baseline / timing.best_ms : 0.0) << "x" << endl;
+        }
+        bool agree = true;
+        for (const auto& timing : result.timings) {
+            agree = agree && timing.records == result.timings.front().records &&
+                    abs(timing.checksum - result.timings.front().checksum) <= 1e-6 * abs(result.timings.front().checksum);
+        }
+        out << "  Results " << (agree ? "match" : "DIFFER") << " across methods." << endl;
+    }
+    return out.str();
+}
+
+NumberBenchmark run_number_benchmark(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    NumberBenchmark result;
+    vector<string> texts;
+    collect_numbers(json::parse(file), texts);
+    result.from_file = texts.size();
+    add_synthetic_numbers(texts);
+    result.synthetic = texts.size() - result.from_file;
+
+    vector<string_view> views(texts.begin(), texts.end());
+    vector<double> values(views.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        double expected = strtod(texts[i].c_str(), nullptr);
+        double parsed = 0.0;
+        if (!parse_decimal(views[i], parsed) || !same_bits(parsed, expected)) {
+            if (result.mismatched.size() < 10) result.mismatched.push_back(texts[i]);
+            ++result.mismatches;
+        }
+    }
+
+    auto sum = [&](double& checksum) {
+        for (double value : values) checksum += isfinite(value) ? value : 0.0;
+    };
+    result.timings.push_back(time_method("strtod", [&](size_t& records, double& checksum) {
+        // What parse_feed_number used to do: copy to a terminated buffer, then strtod
+        char buffer[128];
+        for (size_t i = 0; i < views.size(); ++i) {
+            size_t size = min(views[i].size(), sizeof(buffer) - 1);
+            memcpy(buffer, views[i].data(), size);
+            buffer[size] = '\0';
+            values[i] = strtod(buffer, nullptr);
+        }
+        sum(checksum);
+        records = views.size();
+    }));
+    result.timings.push_back(time_method("stod", [&](size_t& records, double& checksum) {
+        for (size_t i = 0; i < views.size(); ++i) {
+            try {
+                values[i] = stod(string(views[i]));
+            } catch (const out_of_range&) {
+                values[i] = strtod(texts[i].c_str(), nullptr);
+            }
+        }
+        sum(checksum);
+        records = views.size();
+    }));
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    result.timings.push_back(time_method("from_chars", [&](size_t& records, double& checksum) {
+        for (size_t i = 0; i < views.size(); ++i) {
+            auto parsed = from_chars(views[i].data(), views[i].data() + views[i].size(), values[i]);
+            if (parsed.ec != errc()) values[i] = strtod(texts[i].c_str(), nullptr);
+        }
+        sum(checksum);
+        records = views.size();
+    }));
+#endif
+    result.timings.push_back(time_method("parse_decimals", [&](size_t& records, double& checksum) {
+        benchmarkSink += static_cast<double>(parse_decimals(views.data(), views.size(), values.data()));
+        sum(checksum);
+        records = views.size();
+    }));
+    return result;
+}
+
+string format_number_benchmark(const NumberBenchmark& result) {
+    ostringstream out;
+    size_t total = result.from_file + result.synthetic;
+    out << total << " numbers (" << result.from_file << " from the feed, " << result.synthetic
+        << " synthetic and edge cases)" << endl;
+    if (result.mismatches == 0) {
+        out << "  parse_decimal matches strtod bit-for-bit on all of them." << endl;
+    } else {
+        out << "  parse_decimal DIFFERS from strtod on " << result.mismatches << " numbers, e.g.:" << endl;
+        for (const auto& text : result.mismatched) out << "    " << text << endl;
+    }
+    out << fixed << left << setw(18) << "  Method" << right << setw(12) << "Best (ms)" << setw(14) << "Numbers/s"
+        << setw(10) << "Speed-up" << endl;
+    double baseline = result.timings.empty() ? 0.0 : result.timings.front().best_ms;
+    for (const auto& timing : result.timings) {
+        double perSecond = timing.best_ms > 0 ? timing.records * 1e3 / timing.best_ms : 0.0;
+        out << "  " << left << setw(16) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+            << setprecision(0) << setw(14) << perSecond << setprecision(1) << setw(9)
+            << (timing.best_ms > 0 ? baseline / timing.best_ms : 0.0) << "x" << endl;
+    }
+    return out.str();
+}
+
+ProjectionBenchmark run_projection_benchmark(const string& path, size_t scale) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string body = scale > 1 ? synthesize_feed(contents.str(), scale) : contents.str();
+
+    ProjectionBenchmark result;
+    result.input = scale > 1 ? path + " x" + to_string(scale) : path;
+    json document = json::parse(body);
+    DecodedFeed feed = decode_feed(body);
+    ProjectedCatalog catalog;
+    catalog.add_feed(body);
+    ProjectionOptions listing;
+    listing.fields = FIELD_NAME | FIELD_FLAGS;
+    ProjectedCatalog names(listing);
+    names.add_feed(body);
+    result.objects = catalog.size();
+    result.rule_exceptions = catalog.rule_exceptions();
+
+    auto footprint = [&](const string& representation, size_t bytes, auto build) {
+        DecodeTiming timing = time_method(representation, build);
+        result.footprints.push_back({representation, bytes, timing.best_ms});
+    };
+    footprint("json DOM", sizeof(json) + dom_heap_bytes(document), [&](size_t& records, double&) {
+        records = json::parse(body)["near_earth_objects"].size();
+    });
+    footprint("NeoRecord", record_bytes(feed), [&](size_t& records, double&) {
+        records = decode_feed(body).records.size();
+    });
+    footprint("projected", catalog.memory_bytes(), [&](size_t& records, double&) {
+        ProjectedCatalog built;
+        built.add_feed(body);
+        records = built.size();
+    });
+    footprint("projected name,flags", names.memory_bytes(), [&](size_t& records, double&) {
+        ProjectedCatalog built(listing);
+        built.add_feed(body);
+        records = built.size();
+    });
+
+    // The DOM's dates are sorted, the catalog's are in document order: match them up by date
+    const json& days = document["near_earth_objects"];
+    for (size_t d = 0; d < catalog.dates().size(); ++d) {
+        const json& neos = days[catalog.dates()[d]];
+        for (size_t j = 0; j < neos.size(); ++j) {
+            size_t index = catalog.date_begin(d) + j;
+            string expected = captured_output([&] { output_neo_data(neos[j]); });
+            string projected = captured_output([&] { output_neo_data(catalog, index); });
+            bool outputDiffers = expected != projected;
+            bool recordDiffers = index >= feed.records.size() || !same_record(feed.records[index], catalog.record(index));
+            if (outputDiffers) ++result.output_mismatches;
+            if (recordDiffers) ++result.record_mismatches;
+            if ((outputDiffers || recordDiffers) && result.mismatched.size() < 10) {
+                result.mismatched.push_back(catalog.id(index));
+            }
+        }
+    }
+    if (feed.records.size() != catalog.size()) {
+        ++result.record_mismatches;
+    }
+    return result;
+}
+
+string format_projection_benchmark(const ProjectionBenchmark& result) {
+    ostringstream out;
+    out << result.input << " (" << result.objects << " objects)" << endl;
+    out << fixed << left << setw(24) << "  Representation" << right << setw(14) << "Bytes/object" << setw(12)
+        << "Build (ms)" << setw(10) << "vs DOM" << endl;
+    double perObject = max<size_t>(1, result.objects);
+    double baseline = result.footprints.empty() ? 0.0 : result.footprints.front().bytes;
+    for (const auto& footprint : result.footprints) {
+        out << "  " << left << setw(22) << footprint.representation << right << setprecision(1) << setw(14)
+            << footprint.bytes / perObject << setprecision(3) << setw(12) << footprint.build_ms << setprecision(1)
+            << setw(9) << (footprint.bytes > 0 ? baseline / footprint.bytes : 0.0) << "x" << endl;
+    }
+    out << "  " << result.rule_exceptions << " values did not follow a rule and are stored explicitly." << endl;
+    if (result.output_mismatches == 0 && result.record_mismatches == 0) {
+        out << "  The projection reproduces output_neo_data and every NeoRecord field for all objects." << endl;
+    } else {
+        out << "  The projection DIFFERS: " << result.output_mismatches << " outputs and " << result.record_mismatches
+            << " records, e.g. ids";
+        for (const auto& id : result.mismatched) out << " " << id;
+        out << endl;
+    }
+    return out.str();
+}
+
+ErrorBenchmark run_error_benchmark(const string& path, size_t scale, size_t percent) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string clean = synthesize_feed(contents.str(), max<size_t>(1, scale));
+
+    ErrorBenchmark result;
+    string body = corrupt_feed(clean, percent, result.corrupted);
+    result.input = path + " x" + to_string(max<size_t>(1, scale)) + ", " + to_string(percent) + "% corrupted";
+    result.bytes = body.size();
+    FeedIndex index(body);
+    result.objects = index.object_count();
+    DecodedFeed sample = decode_feed(body);
+    for (size_t i = 0; i < sample.malformed.size() && i < 7; ++i) {
+        result.examples.push_back(describe(sample.malformed[i]));
+    }
+
+    result.timings.push_back(time_method("decode_feed clean", [&](size_t& records, double& checksum) {
+        DecodedFeed feed = decode_feed(clean);
+        for (const auto& record : feed.records) checksum += record_checksum(record);
+        records = feed.records.size();
+    }));
+    result.timings.push_back(time_method("decode_feed", [&](size_t& records, double& checksum) {
+        DecodedFeed feed = decode_feed(body);
+        for (const auto& record : feed.records) checksum += record_checksum(record);
+        records = feed.records.size();
+    }));
+    result.timings.push_back(time_method("FeedStreamParser", [&](size_t& records, double& checksum) {
+        FeedStreamParser parser([&](NeoRecord&& record) { checksum += record_checksum(record); });
+        const size_t CHUNK = 16384;
+        for (size_t offset = 0; offset < body.size(); offset += CHUNK) {
+            parser.feed(body.data() + offset, min(CHUNK, body.size() - offset));
+        }
+        parser.finish();
+        records = parser.records_emitted();
+    }));
+    result.timings.push_back(time_method("try_extract", [&](size_t& records, double& checksum) {
+        RecordExtractor extractor;
+        for (size_t i = 0; i < index.object_count(); ++i) {
+            DecodeResult<NeoRecord> record = extractor.try_extract(index.object(i));
+            if (!record) continue;
+            checksum += record_checksum(record.value());
+            ++records;
+        }
+    }));
+    result.timings.push_back(time_method("ProjectedCatalog", [&](size_t& records, double& checksum) {
+        ProjectedCatalog catalog;
+        catalog.add_feed(body);
+        for (size_t i = 0; i < catalog.size(); ++i) checksum += record_checksum(catalog.record(i));
+        records = catalog.size();
+    }));
+
+    // The cost of the error itself, on the malformed records alone: returned, or thrown out of
+    // extract() and caught as the exception channel would
+    vector<size_t> malformed;
+    RecordExtractor extractor;
+    for (size_t i = 0; i < index.object_count(); ++i) {
+        if (!extractor.try_extract(index.object(i))) malformed.push_back(i);
+    }
+    if (!malformed.empty()) {
+        DecodeTiming returned = time_method("returned", [&](size_t& records, double&) {
+            for (size_t i : malformed) records += extractor.try_extract(index.object(i)) ? 0 : 1;
+        });
+        DecodeTiming thrown = time_method("thrown", [&](size_t& records, double&) {
+            for (size_t i : malformed) {
+                try {
+                    extractor.extract(index.object(i));
+                } catch (const JsonStreamError&) {
+                    ++records;
+                }
+            }
+        });
+        result.returned_ns = returned.best_ms * 1e6 / malformed.size();
+        result.thrown_ns = thrown.best_ms * 1e6 / malformed.size();
+    }
+
+    // The first run is on the clean feed, which must lose nothing; the others must drop exactly
+    // the corrupted records and agree on the rest
+    const DecodeTiming& reference = result.timings[1];
+    result.consistent = result.timings[0].records == result.objects;
+    for (size_t i = 1; i < result.timings.size(); ++i) {
+        const DecodeTiming& timing = result.timings[i];
+        result.consistent = result.consistent && timing.records + result.corrupted == result.objects &&
+                            abs(timing.checksum - reference.checksum) <= 1e-6 * abs(reference.checksum);
+    }
+    return result;
+}
+
+string format_error_benchmark(const ErrorBenchmark& result) {
+    ostringstream out;
+    out << fixed << result.input << " (" << setprecision(2) << result.bytes / 1e6 << " MB, " << result.objects
+        << " objects, " << result.corrupted << " corrupted)" << endl;
+    out << left << setw(20) << "  Method" << right << setw(12) << "Best (ms)" << setw(12) << "MB/s" << setw(10)
+        << "Records" << setw(10) << "Skipped" << endl;
+    for (const auto& timing : result.timings) {
+        double mbPerSecond = timing.best_ms > 0 ? result.bytes / 1e3 / timing.best_ms : 0.0;
+        out << "  " << left << setw(18) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+            << setprecision(1) << setw(12) << mbPerSecond << setw(10) << timing.records << setw(10)
+            << result.objects - timing.records << endl;
+    }
+    out << "  " << (result.consistent ? "Every method skipped exactly the corrupted records and agrees on the rest."
+                          : "The methods DIFFER in what they skipped or decoded.") << endl;
+    if (result.corrupted > 0) {
+        out << "  A malformed record costs " << setprecision(0) << result.returned_ns
+            << " ns when try_extract returns the error and " << result.thrown_ns << " ns when extract throws it." << endl;
+    }
+    for (const auto& example : result.examples) out << "  Skipped: " << example << endl;
+    return out.str();
+}
+
+SnapshotBenchmark run_snapshot_benchmark(const string& path, size_t scale, const string& snapshotPath) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string body = scale > 1 ? synthesize_feed(contents.str(), scale) : contents.str();
+
+    SnapshotBenchmark result;
+    result.input = scale > 1 ? path + " x" + to_string(scale) : path;
+    result.text_bytes = body.size();
+    // Compared object by object with the snapshot, which keeps its dates sorted
+    ProjectedCatalog parsed;
+    parsed.add_feed(body);
+    vector<size_t> order(parsed.dates().size());
+    for (size_t d = 0; d < order.size(); ++d) order[d] = d;
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) { return parsed.dates()[a] < parsed.dates()[b]; });
+    ProjectedCatalog catalog;
+    for (size_t d : order) catalog.append_day(parsed, d);
+    result.objects = catalog.size();
+    Clock::time_point started = Clock::now();
+    write_catalog_snapshot(catalog, snapshotPath);
+    result.write_ms = chrono::duration<double, milli>(Clock::now() - started).count();
+
+    CatalogSnapshot snapshot;
+    if (!snapshot.open(snapshotPath)) {
+        throw SnapshotError("Could not map " + snapshotPath);
+    }
+    result.snapshot_bytes = snapshot.file_bytes();
+    result.verified = snapshot.verify();
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        bool differs = i >= snapshot.size() || !same_record(catalog.record(i), snapshot.record(i)) ||
+                       captured_output([&] { output_neo_data(catalog, i); }) !=
+                           captured_output([&] { output_neo_data(snapshot, i); });
+        if (!differs) continue;
+        ++result.mismatches;
+        if (result.mismatched.size() < 10) result.mismatched.push_back(catalog.id(i));
+    }
+    if (snapshot.size() != catalog.size()) {
+        result.mismatches += max(snapshot.size(), catalog.size()) - min(snapshot.size(), catalog.size());
+    }
+
+    result.timings.push_back(time_method("decode_feed text", [&](size_t& records, double&) {
+        records = decode_feed(body).records.size();
+    }));
+    result.timings.push_back(time_method("catalog from text", [&](size_t& records, double&) {
+        ProjectedCatalog built;
+        built.add_feed(body);
+        records = built.size();
+    }));
+    result.timings.push_back(time_method("snapshot open", [&](size_t& records, double&) {
+        CatalogSnapshot opened;
+        opened.open(snapshotPath);
+        records = opened.size();
+    }));
+    result.timings.push_back(time_method("open + verify", [&](size_t& records, double&) {
+        CatalogSnapshot opened;
+        opened.open(snapshotPath);
+        records = opened.verify() ? opened.size() : 0;
+    }));
+
+    // Potentially hazardous objects approaching in the first half of the span, by day number
+    Date first = snapshot.date_count() > 0 ? snapshot.date(0) : Date();
+    DateRange window(first, first + static_cast<int32_t>((snapshot.date_count() + 1) / 2) - 1);
+    DecodedFeed feed = decode_feed(body);
+    result.timings.push_back(time_method("scan NeoRecords", [&](size_t& records, double&) {
+        for (const auto& record : feed.records) {
+            if (record.is_potentially_hazardous && window.contains(record.approach.date)) ++records;
+        }
+    }));
+    result.timings.push_back(time_method("scan columns", [&](size_t& records, double&) {
+        const uint8_t* flags = snapshot.flags();
+        const int32_t* days = snapshot.approach_days();
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            if ((flags[i] & 1) && window.contains(Date(days[i]))) ++records;
+        }
+    }));
+    return result;
+}
+
+string format_snapshot_benchmark(const SnapshotBenchmark& result) {
+    ostringstream out;
+    double perObject = max<size_t>(1, result.objects);
+    out << fixed << setprecision(2) << result.input << " (" << result.objects << " objects): feed text "
+        << result.text_bytes / 1e6 << " MB, snapshot " << result.snapshot_bytes / 1e6 << " MB ("
+        << setprecision(1) << result.snapshot_bytes / perObject << " bytes/object), written in " << result.write_ms
+        << " ms" << endl;
+    out << left << setw(22) << "  Method" << right << setw(12) << "Best (ms)" << setw(10) << "Records" << endl;
+    for (const auto& timing : result.timings) {
+        out << "  " << left << setw(20) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+            << setw(10) << timing.records << endl;
+    }
+    out << "  Opening reads the header and directory only; the file was just written, so its pages are cached." << endl;
+    out << "  " << (result.verified ? "Every section matches its checksum." : "A section does NOT match its checksum.")
+        << endl;
+    if (result.mismatches == 0) {
+        out << "  The snapshot reproduces output_neo_data and every NeoRecord field for all objects." << endl;
+    } else {
+        out << "  The snapshot DIFFERS for " << result.mismatches << " objects, e.g. ids";
+        for (const auto& id : result.mismatched) out << " " << id;
+        out << endl;
+    }
+    return out.str();
+}
+
+IndexBenchmark run_index_benchmark(const string& path, size_t scale, const string& snapshotPath) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string body = scale > 1 ? synthesize_feed(contents.str(), scale) : contents.str();
+
+    IndexBenchmark result;
+    result.input = scale > 1 ? path + " x" + to_string(scale) : path;
+    ProjectedCatalog catalog;
+    catalog.add_feed(body);
+    write_catalog_snapshot(catalog, snapshotPath);
+    CatalogSnapshot snapshot;
+    if (!snapshot.open(snapshotPath)) {
+        throw SnapshotError("Could not map " + snapshotPath);
+    }
+    result.objects = snapshot.size();
+    string indexPath = catalog_index_path(snapshotPath);
+
+    result.timings.push_back(time_method("index build", [&](size_t& records, double&) {
+        write_catalog_index(snapshot, indexPath);
+        records = snapshot.size();
+    }));
+    result.timings.push_back(time_method("index open", [&](size_t& records, double&) {
+        CatalogIndex opened;
+        records = opened.open(indexPath, snapshot) ? snapshot.size() : 0;
+    }));
+    CatalogIndex index;
+    if (!index.open(indexPath, snapshot)) {
+        throw SnapshotError("Could not open " + indexPath);
+    }
+    result.index_bytes = fs::file_size(indexPath);
+    result.verified = index.verify();
+
+    // Every id once, as the interactive lookup gets them
+    vector<string> ids;
+    for (size_t i = 0; i < snapshot.size(); ++i) ids.push_back(snapshot.id(i));
+    sort(ids.begin(), ids.end());
+    ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    result.distinct_ids = ids.size();
+    vector<uint32_t> numbers(ids.size(), 0);
+    for (size_t k = 0; k < ids.size(); ++k) is_numeric_id(ids[k], numbers[k]);
+    auto scan_id = [&](size_t k) {
+        vector<size_t> found;
+        const uint32_t* column = snapshot.ids();
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            // A 0 in the column is a text id, or the id "0"
+            if (column[i] == numbers[k] && (numbers[k] != 0 || snapshot.id(i) == ids[k])) found.push_back(i);
+        }
+        return found;
+    };
+    for (size_t k = 0; k < ids.size(); ++k) {
+        if (index.find(ids[k]) != scan_id(k)) ++result.mismatches;
+    }
+    result.timings.push_back(time_method("ids by scan", [&](size_t& records, double&) {
+        for (size_t k = 0; k < ids.size(); ++k) records += scan_id(k).size();
+    }));
+    result.timings.push_back(time_method("ids by hash", [&](size_t& records, double&) {
+        for (size_t k = 0; k < ids.size(); ++k) records += index.find(ids[k]).size();
+    }));
+
+    // Approaches on the day of the median epoch; synthetic copies shift the feed dates but keep
+    // the epochs, so the day is taken from the epochs themselves
+    if (const int64_t* epochs = snapshot.epochs(); epochs && snapshot.size() > 0) {
+        Date middle = date_of_epoch_ms(index.epoch_at(snapshot.size() / 2));
+        DateRange day(middle, middle);
+        int64_t fromMs = epoch_ms_of(*day.begin()), toMs = epoch_ms_of(*day.end());
+        auto scan_epochs = [&] {
+            vector<size_t> found;
+            for (size_t i = 0; i < snapshot.size(); ++i) {
+                if (epochs[i] >= fromMs && epochs[i] < toMs) found.push_back(i);
+            }
+            return found;
+        };
+        auto indexed_epochs = [&] {
+            pair<size_t, size_t> range = index.epoch_range(day);
+            vector<size_t> found;
+            for (size_t k = range.first; k < range.second; ++k) found.push_back(index.object_at(k));
+            return found;
+        };
+        vector<size_t> indexed = indexed_epochs();
+        sort(indexed.begin(), indexed.end());
+        if (indexed != scan_epochs()) ++result.mismatches;
+        result.timings.push_back(time_method("day by scan", [&](size_t& records, double&) {
+            records = scan_epochs().size();
+        }));
+        result.timings.push_back(time_method("day by index", [&](size_t& records, double&) {
+            records = indexed_epochs().size();
+        }));
+    }
+
+    // The index of this snapshot must not open against a snapshot of its first day only
+    string otherPath = snapshotPath + ".first";
+    SnapshotWriter writer(catalog.options().fields);
+    if (!catalog.dates().empty()) writer.add_day(catalog, 0);
+    writer.write(otherPath);
+    CatalogSnapshot other;
+    CatalogIndex stale;
+    result.stale_rejected = other.open(otherPath) && !stale.open(indexPath, other);
+    other.close();
+    fs::remove(otherPath);
+    index.close();
+    fs::remove(indexPath);
+    return result;
+}
+
+string format_index_benchmark(const IndexBenchmark& result) {
+    ostringstream out;
+    out << fixed << setprecision(2) << result.input << " (" << result.objects << " objects, " << result.distinct_ids
+        << " distinct ids): index " << result.index_bytes / 1e6 << " MB (" << setprecision(1)
+        << result.index_bytes / double(max<size_t>(1, result.objects)) << " bytes/object)" << endl;
+    out << left << setw(22) << "  Method" << right << setw(12) << "Best (ms)" << setw(10) << "Records" << endl;
+    for (const auto& timing : result.timings) {
+        out << "  " << left << setw(20) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+            << setw(10) << timing.records << endl;
+    }
+    out << "  " << (result.verified ? "Every index section matches its checksum." : "An index section does NOT match its checksum.")
+        << endl;
+    out << "  " << (result.stale_rejected ? "The index is refused for a different snapshot."
+                                          : "The index was ACCEPTED for a different snapshot.") << endl;
+    if (result.mismatches == 0) {
+        out << "  Hash and epoch lookups find the same objects as the scans." << endl;
+    } else {
+        out << "  Index and scan DISAGREE on " << result.mismatches << " lookups." << endl;
+    }
+    return out.str();
+}
+
+SegmentBenchmark run_segment_benchmark(const string& path, size_t feeds, const string& directory) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw FileNotFoundException("Could not open " + path);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string source = contents.str();
+
+    SegmentBenchmark result;
+    result.input = path + ", " + to_string(feeds) + " weekly feeds";
+    result.feeds = feeds;
+    vector<string> weeks(feeds);
+    for (size_t w = 0; w < feeds; ++w) {
+        weeks[w] = synthesize_feed(source, 1, w);
+    }
+    // What the store must hold: every week projected in one pass, and where each day starts in it
+    ProjectedCatalog whole;
+    whole.add_feed(synthesize_feed(source, feeds));
+    result.objects = whole.size();
+    map<int32_t, size_t> wholeDay;
+    for (size_t d = 0; d < whole.dates().size(); ++d) {
+        wholeDay[parse_date(whole.dates()[d]).days] = d;
+    }
+    auto compare = [&](const CatalogView& view) {
+        size_t mismatches = view.size() > whole.size() ? view.size() - whole.size() : whole.size() - view.size();
+        for (size_t d = 0; d < view.day_count(); ++d) {
+            auto found = wholeDay.find(view.day(d).days);
+            if (found == wholeDay.end()) continue;
+            size_t first = whole.date_begin(found->second);
+            for (size_t k = 0; k < view.day_size(d) && first + k < whole.date_begin(found->second + 1); ++k) {
+                bool differs = !same_record(view.record(d, k), whole.record(first + k)) ||
+                               captured_output([&] { output_neo_data(whole, first + k); }) !=
+                                   captured_output([&] {
+                                       view.visit(d, k, [](const auto& catalog, size_t index) { output_neo_data(catalog, index); });
+                                   });
+                if (differs) ++mismatches;
+            }
+        }
+        return mismatches;
+    };
+
+    error_code ec;
+    fs::remove_all(directory, ec);
+    SegmentOptions options;
+    options.delta_objects = 1000;
+    {
+        SegmentedCatalog store(directory, ProjectionOptions(), options);
+        // A reader takes views while the feeds go in; each must show whole days with their first object
+        atomic<bool> appending{true};
+        size_t checked = 0, inconsistent = 0;
+        thread reader([&] {
+            while (appending) {
+                shared_ptr<const CatalogView> view = store.view();
+                bool consistent = true;
+                size_t objects = 0;
+                for (size_t d = 0; d < view->day_count() && consistent; ++d) {
+                    auto found = wholeDay.find(view->day(d).days);
+                    consistent = found != wholeDay.end() &&
+                                 view->day_size(d) == whole.date_begin(found->second + 1) - whole.date_begin(found->second) &&
+                                 (view->day_size(d) == 0 || view->id(d, 0) == whole.id(whole.date_begin(found->second)));
+                    objects += view->day_size(d);
+                }
+                ++checked;
+                if (!consistent || objects != view->size()) ++inconsistent;
+            }
+        });
+
+        LatencyRecorder latency(max<size_t>(1, feeds));
+        for (const auto& week : weeks) {
+            Clock::time_point started = Clock::now();
+            store.add_feed(week);
+            double ms = chrono::duration<double, milli>(Clock::now() - started).count();
+            latency.record(ms);
+            result.append_total_ms += ms;
+            result.append_max_ms = max(result.append_max_ms, ms);
+        }
+        appending = false;
+        reader.join();
+        result.views_checked = checked;
+        result.inconsistent_views = inconsistent;
+        result.append_p50_ms = latency.percentile(0.50);
+        result.append_p95_ms = latency.percentile(0.95);
+
+        store.flush();
+        store.compact();
+        result.stats = format_segment_stats(store.stats());
+        result.mismatches = compare(*store.view());
+    }
+    {
+        options.background = false;
+        SegmentedCatalog reopened(directory, ProjectionOptions(), options);
+        result.reopened_mismatches = compare(*reopened.view());
+    }
+
+    string rewritePath = directory + ".rewrite.neosnap";
+    result.rewrite_ms = time_method("rewrite", [&](size_t& records, double&) {
+        write_catalog_snapshot(whole, rewritePath);
+        records = whole.size();
+    }).best_ms;
+    fs::remove(rewritePath, ec);
+    fs::remove_all(directory, ec);
+    return result;
+}
+
+string format_segment_benchmark(const SegmentBenchmark& result) {
+    ostringstream out;
+    out << fixed << setprecision(3) << result.input << " (" << result.objects << " objects)" << endl;
+    out << "  add_feed: p50 " << result.append_p50_ms << " ms, p95 " << result.append_p95_ms << " ms, max "
+        << result.append_max_ms << " ms, " << setprecision(1) << result.append_total_ms << " ms in all" << endl;
+    out << "  Rewriting one snapshot of the whole catalog instead: " << result.rewrite_ms << " ms per feed" << endl;
+    out << "  " << result.stats << endl;
+    out << "  A concurrent reader checked " << result.views_checked << " views: ";
+    if (result.inconsistent_views == 0) {
+        out << "every one held whole days." << endl;
+    } else {
+        out << result.inconsistent_views << " were INCONSISTENT." << endl;
+    }
+    if (result.mismatches == 0 && result.reopened_mismatches == 0) {
+        out << "  The store matches a catalog built in one pass, before and after reopening it." << endl;
+    } else {
+        out << "  The store DIFFERS from a catalog built in one pass for " << result.mismatches << " objects, and for "
+            << result.reopened_mismatches << " after reopening it." << endl;
+    }
+    return out.str();
+}
+
+vector<NeoDetail> synthesize_details(size_t objects, size_t approaches, unsigned seed) {
+    // Orbiting bodies as NeoWs names them, Earth most often
+    const char* const BODIES[] = {"Earth", "Earth", "Earth", "Earth", "Earth", "Earth", "Mars", "Venus", "Merc", "Juptr"};
+    const double KM_PER_AU = 149597870.7;
+    const double KM_PER_LUNAR = 384400.0;
+    const double KM_PER_MILE = 1.609344;
+    // NeoWs sends ten decimals
+    auto rounded = [](double value) { return round(value * 1e10) / 1e10; };
+    mt19937 random(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    int64_t start = epoch_ms_of(date_from_civil(1900, 1, 1));
+    vector<NeoDetail> details(objects);
+    for (size_t k = 0; k < objects; ++k) {
+        NeoDetail& detail = details[k];
+        detail.id = to_string(2000000 + k);
+        detail.name = "(" + to_string(1990 + k % 40) + " SYN" + to_string(k) + ")";
+        // Approaches about every synodic period, with distance and speed drifting smoothly
+        double periodDays = 300.0 + 1700.0 * unit(random);
+        double span = 110000.0 / max<size_t>(1, approaches);
+        periodDays = min(periodDays, span);
+        double phase = unit(random) * 6.283185307179586;
+        double baseMiss = 0.02 + 0.45 * unit(random);
+        double baseVelocity = 5.0 + 25.0 * unit(random);
+        int64_t epoch = start + static_cast<int64_t>(unit(random) * periodDays * 86400000.0);
+        detail.approaches.resize(approaches);
+        for (size_t i = 0; i < approaches; ++i) {
+            CloseApproach& approach = detail.approaches[i];
+            epoch += static_cast<int64_t>((periodDays + 20.0 * (unit(random) - 0.5)) * 86400000.0);
+            double wave = sin(phase + 0.37 * static_cast<double>(i));
+            approach.epoch_ms = epoch / 60000 * 60000;
+            approach.date = date_of_epoch_ms(approach.epoch_ms);
+            approach.date_full = format_approach_time(approach.epoch_ms);
+            approach.miss_au = rounded(max(0.0005, baseMiss * (1.0 + 0.9 * wave)));
+            approach.miss_lunar = rounded(approach.miss_au * KM_PER_AU / KM_PER_LUNAR);
+            approach.miss_km = rounded(approach.miss_au * KM_PER_AU);
+            approach.miss_miles = rounded(approach.miss_km / KM_PER_MILE);
+            approach.velocity_km_s = rounded(baseVelocity * (1.0 - 0.2 * wave));
+            approach.velocity_km_h = rounded(approach.velocity_km_s * 3600.0);
+            approach.orbiting_body = BODIES[random() % 10];
+        }
+    }
+    return details;
+}
+
+ApproachBenchmark run_approach_benchmark(size_t objects, size_t approaches) {
+    ApproachBenchmark result;
+    vector<NeoDetail> details = synthesize_details(objects, approaches);
+    result.objects = details.size();
+    ApproachHistory history;
+    Clock::time_point started = Clock::now();
+    for (const auto& detail : details) {
+        history.add(detail);
+    }
+    result.build_ms = chrono::duration<double, milli>(Clock::now() - started).count();
+    result.approaches = history.size();
+    result.history_bytes = history.memory_bytes();
+    // The rows as the detail store keeps them
+    vector<json> stored;
+    for (const auto& detail : details) {
+        stored.push_back(detail_to_json(detail)["approaches"]);
+        result.json_bytes += sizeof(json) + dom_heap_bytes(stored.back());
+        result.detail_bytes += detail.approaches.capacity() * sizeof(CloseApproach);
+        for (const auto& approach : detail.approaches) {
+            result.detail_bytes += string_heap_bytes(approach.date_full) + string_heap_bytes(approach.orbiting_body);
+        }
+    }
+
+    ApproachQuery query;
+    set_year_range(query, 2000, 2100);
+    query.max_miss_au = 0.05;
+    query.body = history.body_code("Earth");
+    result.timings.push_back(time_method("JSON rows", [&](size_t& records, double& checksum) {
+        for (const auto& rows : stored) {
+            for (const auto& row : rows) {
+                int64_t epoch = row[2].get<int64_t>();
+                double miss = row[5].get<double>();
+                if (epoch >= query.from_ms && epoch < query.to_ms && miss <= query.max_miss_au &&
+                    row[9].get_ref<const string&>() == "Earth") {
+                    checksum += miss;
+                    ++records;
+                }
+            }
+        }
+    }));
+    result.timings.push_back(time_method("NeoDetail vectors", [&](size_t& records, double& checksum) {
+        for (const auto& detail : details) {
+            for (const auto& approach : detail.approaches) {
+                if (approach.epoch_ms >= query.from_ms && approach.epoch_ms < query.to_ms &&
+                    approach.miss_au <= query.max_miss_au && approach.orbiting_body == "Earth") {
+                    checksum += approach.miss_au;
+                    ++records;
+                }
+            }
+        }
+    }));
+    result.timings.push_back(time_method("find_approaches", [&](size_t& records, double& checksum) {
+        vector<size_t> rows = find_approaches(history, query);
+        for (size_t row : rows) checksum += history.miss_au()[row];
+        records = rows.size();
+    }));
+    result.timings.push_back(time_method("count_approaches", [&](size_t& records, double&) {
+        records = count_approaches(history, query);
+    }));
+    // Matches are summed in the same order everywhere, so the checksums agree exactly; counting has none
+    result.consistent = true;
+    for (const auto& timing : result.timings) {
+        result.consistent = result.consistent && timing.records == result.timings[0].records &&
+                            (timing.method == "count_approaches" || timing.checksum == result.timings[0].checksum);
+    }
+    return result;
+}
+
+string format_approach_benchmark(const ApproachBenchmark& result) {
+    ostringstream out;
+    double perApproach = max<size_t>(1, result.approaches);
+    out << fixed << setprecision(1) << result.objects << " objects, " << result.approaches
+        << " approaches; approaches within 0.05 AU of Earth between 2000 and 2100" << endl;
+    out << "  Memory per approach: stored JSON " << result.json_bytes / perApproach << " bytes, NeoDetail "
+        << result.detail_bytes / perApproach << " bytes, ApproachHistory " << result.history_bytes / perApproach
+        << " bytes (built in " << result.build_ms << " ms)" << endl;
+    out << left << setw(22) << "  Method" << right << setw(12) << "Best (ms)" << setw(10) << "Found" << setw(14)
+        << "M rows/s" << endl;
+    for (const auto& timing : result.timings) {
+        out << "  " << left << setw(20) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+            << setw(10) << timing.records << setprecision(1) << setw(14)
+            << result.approaches / max(timing.best_ms, 1e-6) / 1e3 << endl;
+    }
+    out << "  " << (result.consistent ? "Every method found the same approaches."
+                                      : "The methods DISAGREE on the matching approaches.") << endl;
+    return out.str();
+}
+
+namespace {
+
+// Function to encode one column, decode it back and time both
+template <typename T, typename Encode, typename Decode>
+ColumnCompression compress_column(const string& name, const T* values, size_t count, Encode encode, Decode decode) {
+    ColumnCompression result;
+    result.column = name;
+    result.raw_bytes = count * sizeof(T);
+    Clock::time_point started = Clock::now();
+    EncodedSeries series = encode(values, count);
+    result.encode_ms = chrono::duration<double, milli>(Clock::now() - started).count();
+    result.encoded_bytes = series.bytes();
+    vector<T> decoded(count);
+    result.decode_ms = time_method(name, [&](size_t& records, double&) {
+        decode(series, decoded.data());
+        records = count;
+    }).best_ms;
+    result.exact = count == 0 || memcmp(decoded.data(), values, count * sizeof(T)) == 0;
+    return result;
+}
+
+} // namespace
+
+CompressionBenchmark run_compression_benchmark(size_t objects, size_t approaches) {
+    CompressionBenchmark result;
+    ApproachHistory history;
+    for (const auto& detail : synthesize_details(objects, approaches)) {
+        history.add(detail);
+    }
+    result.objects = history.object_count();
+    result.approaches = history.size();
+    result.columns.push_back(compress_column("epoch", history.epochs(), history.size(), encode_timestamps, decode_timestamps));
+    result.columns.push_back(
+        compress_column("velocity", history.velocities_km_s(), history.size(), encode_doubles, decode_doubles));
+    result.columns.push_back(compress_column("miss distance", history.miss_au(), history.size(), encode_doubles, decode_doubles));
+
+    CompressedApproachHistory compressed(history);
+    ApproachQuery query;
+    set_year_range(query, 2000, 2100);
+    query.max_miss_au = 0.05;
+    query.body = history.body_code("Earth");
+    result.timings.push_back(time_method("count, plain", [&](size_t& records, double&) {
+        records = count_approaches(history, query);
+    }));
+    result.timings.push_back(time_method("count, compressed", [&](size_t& records, double&) {
+        records = count_approaches(compressed, query);
+    }));
+    result.timings.push_back(time_method("find, plain", [&](size_t& records, double&) {
+        records = find_approaches(history, query).size();
+    }));
+    result.timings.push_back(time_method("find, compressed", [&](size_t& records, double&) {
+        records = find_approaches(compressed, query).size();
+    }));
+    result.consistent = find_approaches(history, query) == find_approaches(compressed, query);
+    for (const auto& timing : result.timings) {
+        result.consistent = result.consistent && timing.records == result.timings[0].records;
+    }
+    return result;
+}
+
+string format_compression_benchmark(const CompressionBenchmark& result) {
+    ostringstream out;
+    out << result.objects << " objects, " << result.approaches << " approaches" << endl;
+    out << left << setw(17) << "  Column" << right << setw(10) << "Raw MB" << setw(12) << "Encoded MB" << setw(8)
+        << "Ratio" << setw(10) << "Bits/val" << setw(13) << "Encode ms" << setw(13) << "Decode GB/s" << endl;
+    bool exact = true;
+    for (const auto& column : result.columns) {
+        double values = max<double>(1.0, static_cast<double>(result.approaches));
+        out << "  " << left << setw(15) << column.column << right << fixed << setprecision(2) << setw(10)
+            << column.raw_bytes / 1e6 << setw(12) << column.encoded_bytes / 1e6 << setw(8)
+            << column.raw_bytes / max<double>(1.0, static_cast<double>(column.encoded_bytes)) << setprecision(1)
+            << setw(10) << column.encoded_bytes * 8.0 / values << setw(13) << column.encode_ms << setprecision(2)
+            << setw(13) << column.raw_bytes / max(column.decode_ms, 1e-6) / 1e6 << endl;
+        exact = exact && column.exact;
+    }
+    out << "  " << (exact ? "Every column decodes bit for bit." : "A column does NOT decode to its values.") << endl;
+    out << "  Approaches within 0.05 AU of Earth between 2000 and 2100:" << endl;
+    for (const auto& timing : result.timings) {
+        out << "  " << left << setw(20) << timing.method << right << setprecision(3) << setw(12) << timing.best_ms
+            << " ms" << setw(10) << timing.records << endl;
+    }
+    out << "  " << (result.consistent ? "Plain and compressed columns give the same rows."
+                                      : "Plain and compressed columns DISAGREE.") << endl;
+    return out.str();
+}
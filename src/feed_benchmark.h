@@ -0,0 +1,220 @@
+#ifndef FEED_BENCHMARK_H
+#define FEED_BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include "neo_details.h"
+
+// Timing of one decode strategy on one input
+struct DecodeTiming {
+    std::string method;
+    double best_ms = 0.0;      // fastest of the repetitions
+    size_t records = 0;
+    double checksum = 0.0;     // sum over decoded fields, to check the methods agree
+};
+
+// All strategies measured on one input
+struct DecodeBenchmark {
+    std::string input;         // e.g. "data.json" or "data.json x1000"
+    size_t bytes = 0;
+    std::vector<DecodeTiming> timings;
+};
+
+// Builds a feed with every day of the source feed repeated `copies` times under shifted dates;
+// copy c is shifted by (firstCopy + c) times the source's span of days
+std::string synthesize_feed(const std::string& body, size_t copies, size_t firstCopy = 0);
+
+// Times the DOM path (json::parse plus the per-field lookups Asteroid used to do) against
+// decode_feed and decode_feed_view, and decode_feed against FeedIndex for reading only names and
+// hazard flags, and chained operator[] lookups against FieldExtractor for reading every field of
+// an already parsed document, on the file itself and on a synthetic feed `scale` times larger
+std::vector<DecodeBenchmark> run_decode_benchmark(const std::string& path, size_t scale);
+
+// Renders the results as a table with throughput and speed-up against the first method
+std::string format_decode_benchmark(const std::vector<DecodeBenchmark>& results);
+
+// Number-conversion run: parse_decimal checked bit-for-bit against strtod, then timed against
+// the library conversions on the same strings
+struct NumberBenchmark {
+    size_t from_file = 0;              // numeric strings collected from the feed
+    size_t synthetic = 0;              // generated values and edge cases added to them
+    size_t mismatches = 0;             // strings where parse_decimal and strtod disagree
+    std::vector<std::string> mismatched;   // the first few of them
+    std::vector<DecodeTiming> timings;     // records = numbers converted per run
+};
+
+// Collects every number (and numeric string) in the feed at path, adds random values in the
+// feed's own formats plus rounding edge cases, and runs the check and the timings
+NumberBenchmark run_number_benchmark(const std::string& path);
+
+// Renders the check result and a numbers/s table
+std::string format_number_benchmark(const NumberBenchmark& result);
+
+// Memory held by one in-memory representation of a feed and how long it takes to build
+struct ProjectionFootprint {
+    std::string representation;
+    size_t bytes = 0;
+    double build_ms = 0.0;             // fastest of the repetitions
+};
+
+// Projection run: the footprint of the JSON DOM, decoded NeoRecords and projected catalogs, and
+// a check that the projection reproduces what the program prints and every record field
+struct ProjectionBenchmark {
+    std::string input;                 // e.g. "data.json x100"
+    size_t objects = 0;
+    size_t rule_exceptions = 0;        // values the projection had to keep explicitly
+    size_t output_mismatches = 0;      // objects whose output_neo_data text differs
+    size_t record_mismatches = 0;      // objects whose NeoRecord differs from decode_feed's
+    std::vector<std::string> mismatched;   // ids of the first few of them
+    std::vector<ProjectionFootprint> footprints;
+};
+
+// Builds each representation of the feed at path repeated `scale` times, measures its memory
+// and compares the projected catalog object by object with the DOM and decode_feed
+ProjectionBenchmark run_projection_benchmark(const std::string& path, size_t scale);
+
+// Renders bytes per object for each representation and the check result
+std::string format_projection_benchmark(const ProjectionBenchmark& result);
+
+// Malformed-record run: how each decoder copes with a feed in which some records carry a value
+// of the wrong type or no id
+struct ErrorBenchmark {
+    std::string input;                 // e.g. "data.json x100, 5% corrupted"
+    size_t bytes = 0;
+    size_t objects = 0;
+    size_t corrupted = 0;              // records damaged on purpose
+    bool consistent = false;           // every method skipped exactly those and agrees on the rest
+    std::vector<std::string> examples; // how decode_feed reported the first few
+    std::vector<DecodeTiming> timings; // records = records kept
+    double returned_ns = 0.0;          // per malformed record, error returned by try_extract
+    double thrown_ns = 0.0;            // per malformed record, error thrown by extract and caught
+};
+
+// Builds the feed at path repeated `scale` times, damages `percent` of its records and times
+// decode_feed on the clean and damaged feeds, then the streaming parser, RecordExtractor and a
+// projected catalog on the damaged one. Also times the malformed records alone with the error
+// returned against thrown and caught.
+ErrorBenchmark run_error_benchmark(const std::string& path, size_t scale, size_t percent);
+
+// Renders the timings, the records each method skipped and the cost of a malformed record
+std::string format_error_benchmark(const ErrorBenchmark& result);
+
+// Snapshot run: getting a catalog from feed text against mapping a snapshot of it, a scan over
+// the result, and a check that the snapshot gives back what the catalog it was written from gives
+struct SnapshotBenchmark {
+    std::string input;                 // e.g. "data.json x1000"
+    size_t objects = 0;
+    size_t text_bytes = 0;             // the feed text
+    size_t snapshot_bytes = 0;
+    double write_ms = 0.0;
+    bool verified = false;             // every section matched its checksum
+    size_t mismatches = 0;             // objects whose NeoRecord or printed output differs
+    std::vector<std::string> mismatched;   // ids of the first few of them
+    std::vector<DecodeTiming> timings; // records = objects loaded, or matches of the scan
+};
+
+// Builds a projected catalog from the feed at path repeated `scale` times, writes it to
+// snapshotPath, and times loading from text against opening the snapshot, and the same scan
+// (potentially hazardous objects approaching in the first half of the span) over decoded
+// records and over the snapshot's columns
+SnapshotBenchmark run_snapshot_benchmark(const std::string& path, size_t scale, const std::string& snapshotPath);
+
+// Renders the sizes, the timings and the check result
+std::string format_snapshot_benchmark(const SnapshotBenchmark& result);
+
+// Result of looking objects up in a snapshot by id and by approach time
+struct IndexBenchmark {
+    std::string input;                 // e.g. "data.json x1000"
+    size_t objects = 0;
+    size_t distinct_ids = 0;
+    size_t index_bytes = 0;
+    bool verified = false;             // every index section matched its checksum
+    bool stale_rejected = false;       // the index did not open against another snapshot
+    size_t mismatches = 0;             // ids or epoch ranges where index and scan disagree
+    std::vector<DecodeTiming> timings; // records = objects found
+};
+
+// Writes a snapshot of the feed at path repeated `scale` times to snapshotPath and its index next
+// to it, then times building the index against opening it, finding every id with the hash index
+// against scanning the id column, and finding a day of approaches with the epoch index against
+// scanning the epoch column
+IndexBenchmark run_index_benchmark(const std::string& path, size_t scale, const std::string& snapshotPath);
+
+// Renders the sizes, the timings and the check results
+std::string format_index_benchmark(const IndexBenchmark& result);
+
+// Result of appending daily feeds to a SegmentedCatalog one at a time
+struct SegmentBenchmark {
+    std::string input;                 // e.g. "data.json, 500 weekly feeds"
+    size_t feeds = 0;
+    size_t objects = 0;
+    double append_p50_ms = 0.0;        // per add_feed, including any flush it triggered
+    double append_p95_ms = 0.0;
+    double append_max_ms = 0.0;
+    double append_total_ms = 0.0;
+    double rewrite_ms = 0.0;           // writing one snapshot of the whole final catalog
+    std::string stats;                 // format_segment_stats after the last append
+    size_t views_checked = 0;          // views a concurrent reader checked during ingest
+    size_t inconsistent_views = 0;     // of those, views whose days did not match the feeds
+    size_t mismatches = 0;             // objects that differ from a catalog built in one pass
+    size_t reopened_mismatches = 0;    // the same after reopening the store from disk
+};
+
+// Appends data.json shifted week by week, `feeds` times, to a store in directory, with a reader
+// thread checking every view it gets meanwhile, and compares the result with a projected catalog
+// of all weeks at once, before and after reopening the store
+SegmentBenchmark run_segment_benchmark(const std::string& path, size_t feeds, const std::string& directory);
+
+// Renders the latencies, the store counters and the check results
+std::string format_segment_benchmark(const SegmentBenchmark& result);
+
+// Detail records with long, smooth close-approach histories, `approaches` per object over about
+// three centuries from 1900, as /neo/{id} reports them; the same seed gives the same records
+std::vector<NeoDetail> synthesize_details(size_t objects, size_t approaches, unsigned seed = 1);
+
+// Result of querying approach histories kept three ways
+struct ApproachBenchmark {
+    size_t objects = 0;
+    size_t approaches = 0;
+    size_t json_bytes = 0;             // approach rows of the stored JSON, as a DOM
+    size_t detail_bytes = 0;           // NeoDetail approach vectors
+    size_t history_bytes = 0;          // ApproachHistory
+    double build_ms = 0.0;             // ApproachHistory from the NeoDetails
+    std::vector<DecodeTiming> timings; // records = matching approaches
+    bool consistent = false;           // every method found the same approaches
+};
+
+// Times "approaches within 0.05 AU of Earth between 2000 and 2100" over synthetic histories:
+// walking the stored JSON rows, walking NeoDetail vectors, and scanning an ApproachHistory
+ApproachBenchmark run_approach_benchmark(size_t objects, size_t approaches);
+
+// Renders the sizes, the timings and whether the methods agree
+std::string format_approach_benchmark(const ApproachBenchmark& result);
+
+// One column of an approach history compressed and decoded again
+struct ColumnCompression {
+    std::string column;
+    size_t raw_bytes = 0;
+    size_t encoded_bytes = 0;
+    double encode_ms = 0.0;
+    double decode_ms = 0.0;            // fastest whole-column decode, block by block
+    bool exact = false;                // every value decoded bit for bit
+};
+
+// Result of compressing synthetic approach histories
+struct CompressionBenchmark {
+    size_t objects = 0;
+    size_t approaches = 0;
+    std::vector<ColumnCompression> columns;
+    std::vector<DecodeTiming> timings; // the --bench-approaches query on plain and compressed columns
+    bool consistent = false;           // both found the same rows
+};
+
+// Compresses the epoch, velocity and miss-distance columns of synthetic histories, checks that
+// they decode exactly, and times decoding and the approach query against the plain columns
+CompressionBenchmark run_compression_benchmark(size_t objects, size_t approaches);
+
+// Renders the ratios, decode speeds and query timings
+std::string format_compression_benchmark(const CompressionBenchmark& result);
+
+#endif // FEED_BENCHMARK_H
@@ -0,0 +1,235 @@
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "feed_crawler.h"
+#include "calendar.h"
+#include "get_data.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Moves a links.next URL onto the configured API root. NeoWs links use plain http:// and the
+// public host, which would bypass NEO_API_BASE_URL and HTTPS.
+string rebase_link(const string& link) {
+    for (const string& endpoint : {string("/feed"), string("/neo/browse")}) {
+        auto at = link.find(endpoint + "?");
+        if (at != string::npos) {
+            return neo_api_root() + link.substr(at);
+        }
+    }
+    return link;
+}
+
+} // namespace
+
+string query_param(const string& url, const string& name) {
+    auto query = url.find('?');
+    if (query == string::npos) return "";
+    size_t pos = query + 1;
+    while (pos < url.size()) {
+        size_t end = url.find('&', pos);
+        if (end == string::npos) end = url.size();
+        string pair = url.substr(pos, end - pos);
+        if (pair.compare(0, name.size() + 1, name + "=") == 0) {
+            return pair.substr(name.size() + 1);
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+string without_query_param(const string& url, const string& name) {
+    auto query = url.find('?');
+    if (query == string::npos) return url;
+    string result = url.substr(0, query);
+    string kept;
+    size_t pos = query + 1;
+    while (pos <= url.size()) {
+        size_t end = url.find('&', pos);
+        if (end == string::npos) end = url.size();
+        string pair = url.substr(pos, end - pos);
+        if (!pair.empty() && pair.compare(0, name.size() + 1, name + "=") != 0) {
+            kept += (kept.empty() ? "" : "&") + pair;
+        }
+        pos = end + 1;
+    }
+    return kept.empty() ? result : result + "?" + kept;
+}
+
+string with_query_param(const string& url, const string& name, const string& value) {
+    // Replaced in place, so the other parameters keep their order
+    auto query = url.find('?');
+    if (query != string::npos) {
+        size_t pos = query + 1;
+        while (pos < url.size()) {
+            size_t end = url.find('&', pos);
+            if (end == string::npos) end = url.size();
+            if (url.compare(pos, name.size() + 1, name + "=") == 0) {
+                return url.substr(0, pos + name.size() + 1) + value + url.substr(end);
+            }
+            pos = end + 1;
+        }
+    }
+    return url + (query == string::npos ? "?" : "&") + name + "=" + value;
+}
+
+string page_identity(const string& url) {
+    string start = query_param(url, "start_date");
+    string end = query_param(url, "end_date");
+    if (!start.empty() || !end.empty()) {
+        return "feed " + start + " " + end;
+    }
+    string page = query_param(url, "page");
+    if (!page.empty()) {
+        return "page " + page;
+    }
+    return without_query_param(url, "api_key");
+}
+
+string feed_crawl_start_url(const string& startDate, const string& apiKey) {
+    return build_feed_url({startDate, add_days(startDate, MAX_FEED_WINDOW_DAYS - 1)}, apiKey);
+}
+
+string browse_crawl_start_url(const string& apiKey) {
+    return neo_api_root() + "/neo/browse?page=0&size=20&api_key=" + apiKey;
+}
+
+// Function to find the top-level links.next value. Per-object "links" only carry "self", so the
+// first "next" key in the document is the page link.
+string extract_next_link(const string& body) {
+    size_t pos = body.find("\"next\"");
+    if (pos == string::npos) return "";
+    pos = body.find_first_not_of(" \t\r\n", pos + 6);
+    if (pos == string::npos || body[pos] != ':') return "";
+    pos = body.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == string::npos || body[pos] != '"') return "";
+
+    string link;
+    for (++pos; pos < body.size() && body[pos] != '"'; ++pos) {
+        if (body[pos] == '\\' && pos + 1 < body.size()) ++pos;   // links only escape '/'
+        link += body[pos];
+    }
+    return rebase_link(link);
+}
+
+string predict_next_url(const string& url) {
+    string start = query_param(url, "start_date");
+    string end = query_param(url, "end_date");
+    if (!start.empty() && !end.empty()) {
+        // NeoWs starts the next window on this window's last day and ends it a week later
+        string withStart = with_query_param(url, "start_date", end);
+        return with_query_param(withStart, "end_date", add_days(end, MAX_FEED_WINDOW_DAYS));
+    }
+    string page = query_param(url, "page");
+    if (!page.empty()) {
+        return with_query_param(url, "page", to_string(stol(page) + 1));
+    }
+    return "";
+}
+
+FeedCrawler::FeedCrawler(RequestScheduler& scheduler, string apiKey, CrawlOptions options)
+    : scheduler_(scheduler), apiKey_(std::move(apiKey)), options_(std::move(options)) {}
+
+bool FeedCrawler::past_stop_date(const string& url) const {
+    if (options_.stop_date.empty()) return false;
+    string start = query_param(url, "start_date");
+    return !start.empty() && start > options_.stop_date;
+}
+
+void FeedCrawler::save_checkpoint(const CrawlProgress& progress) const {
+    json checkpoint;
+    checkpoint["next_url"] = progress.next_url;
+    checkpoint["pages"] = progress.pages;
+    checkpoint["objects"] = progress.objects;
+    checkpoint["finished"] = progress.finished;
+
+    // Rename into place so a crash mid-write keeps the previous checkpoint intact
+    string tmpPath = options_.checkpoint_path + ".tmp";
+    {
+        ofstream file(tmpPath, ios::trunc);
+        if (!file.is_open()) {
+            throw FileNotFoundException("Could not write crawl checkpoint: " + tmpPath);
+        }
+        file << checkpoint.dump(2) << endl;
+    }
+    fs::rename(tmpPath, options_.checkpoint_path);
+}
+
+bool FeedCrawler::load_checkpoint(CrawlProgress& progress) const {
+    ifstream file(options_.checkpoint_path);
+    if (!file.is_open()) return false;
+    try {
+        json checkpoint;
+        file >> checkpoint;
+        progress.next_url = checkpoint.at("next_url").get<string>();
+        progress.pages = checkpoint.at("pages").get<size_t>();
+        progress.objects = checkpoint.at("objects").get<size_t>();
+        progress.finished = checkpoint.value("finished", false);
+    } catch (const exception& e) {
+        cerr << "Ignoring unreadable crawl checkpoint " << options_.checkpoint_path << ": " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+// Function to walk the pages, keeping the next requests in flight while one page is processed
+CrawlProgress FeedCrawler::crawl(const string& startUrl, const PageHandler& onPage) {
+    CrawlProgress progress;
+    if (load_checkpoint(progress) && !progress.finished && !progress.next_url.empty()) {
+        cout << "Resuming crawl after " << progress.pages << " pages at " << progress.next_url << endl;
+    } else {
+        progress = CrawlProgress();
+        progress.next_url = without_query_param(startUrl, "api_key");
+    }
+
+    // Requests in flight, oldest first; the head is always progress.next_url
+    deque<pair<string, future<FetchResult>>> inFlight;
+    auto requestUrl = [&](const string& url) { return with_query_param(url, "api_key", apiKey_); };
+    auto withinLimits = [&](const string& url, size_t ahead) {
+        return !url.empty() && !past_stop_date(url) &&
+               (options_.max_pages == 0 || progress.pages + ahead < options_.max_pages);
+    };
+    auto fillPipeline = [&]() {
+        if (inFlight.empty() && withinLimits(progress.next_url, 0)) {
+            inFlight.emplace_back(progress.next_url,
+                                  scheduler_.submit(requestUrl(progress.next_url), apiKey_, RequestPriority::Background));
+        }
+        while (!inFlight.empty() && inFlight.size() < max<size_t>(1, options_.pipeline_depth)) {
+            string guess = predict_next_url(inFlight.back().first);
+            if (!withinLimits(guess, inFlight.size())) break;
+            inFlight.emplace_back(guess, scheduler_.submit(requestUrl(guess), apiKey_, RequestPriority::Background));
+        }
+    };
+
+    fillPipeline();
+    while (!inFlight.empty()) {
+        FetchResult page = inFlight.front().second.get();
+        inFlight.pop_front();
+        if (page.status != 200) {
+            save_checkpoint(progress);
+            throw ApiRequestException("HTTP " + to_string(page.status) + " while crawling " + progress.next_url);
+        }
+
+        // Queue the following page before processing this one. Guesses are checked against
+        // links.next by the page they ask for, not by their text; once one is wrong, it and every
+        // guess built on it are withdrawn from the queue.
+        string next = without_query_param(extract_next_link(page.body), "api_key");
+        if (!inFlight.empty() && page_identity(inFlight.front().first) != page_identity(next)) {
+            for (const auto& guess : inFlight) {
+                scheduler_.cancel(requestUrl(guess.first));
+            }
+            inFlight.clear();
+        }
+        progress.next_url = next;
+        ++progress.pages;
+        fillPipeline();
+
+        progress.objects += onPage(page);
+        progress.finished = next.empty() || past_stop_date(next);
+        save_checkpoint(progress);
+    }
+    return progress;
+}
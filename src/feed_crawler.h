@@ -0,0 +1,73 @@
+#ifndef FEED_CRAWLER_H
+#define FEED_CRAWLER_H
+
+#include <functional>
+#include <string>
+#include "request_scheduler.h"
+
+// Settings for a FeedCrawler
+struct CrawlOptions {
+    std::string checkpoint_path = "crawl_checkpoint.json";
+    size_t max_pages = 0;          // 0 = no limit
+    std::string stop_date;         // feed crawls stop before a page starting after this date ("" = no limit)
+    size_t pipeline_depth = 3;     // pages requested ahead of the one being processed
+};
+
+// Where a crawl stands; persisted to the checkpoint after every processed page
+struct CrawlProgress {
+    std::string next_url;          // without the api_key parameter
+    size_t pages = 0;
+    size_t objects = 0;
+    bool finished = false;
+};
+
+// Walks the feed (or browse) endpoint page by page through links.next. Requests for the next
+// pages are already in flight while the current one is processed, and progress is checkpointed
+// so an interrupted crawl resumes where it stopped. Requests run at background priority.
+class FeedCrawler {
+public:
+    // Receives each page in order; returns the number of objects it indexed
+    using PageHandler = std::function<size_t(const FetchResult& page)>;
+
+    FeedCrawler(RequestScheduler& scheduler, std::string apiKey, CrawlOptions options = CrawlOptions());
+
+    // Crawls from startUrl, or from the checkpoint when one exists for an unfinished crawl
+    CrawlProgress crawl(const std::string& startUrl, const PageHandler& onPage);
+
+private:
+    void save_checkpoint(const CrawlProgress& progress) const;
+    bool load_checkpoint(CrawlProgress& progress) const;
+    bool past_stop_date(const std::string& url) const;
+
+    RequestScheduler& scheduler_;
+    std::string apiKey_;
+    CrawlOptions options_;
+};
+
+// First feed page of a crawl starting at date
+std::string feed_crawl_start_url(const std::string& startDate, const std::string& apiKey);
+
+// First page of the browse endpoint (whole catalog, 20 objects per page)
+std::string browse_crawl_start_url(const std::string& apiKey);
+
+// Pulls the top-level links.next URL out of a page without parsing the whole document
+std::string extract_next_link(const std::string& body);
+
+// Guesses the page after url, keeping its other query parameters: for the feed the window NeoWs
+// links to next (from url's end_date to a week later), for browse page+1; "" if unknown
+std::string predict_next_url(const std::string& url);
+
+// The page a crawl URL asks for, independent of parameter order and extras such as detailed or
+// api_key: the feed window's start and end dates, the browse page, or else the URL itself
+std::string page_identity(const std::string& url);
+
+// Returns url with its query parameter set in place (appended when missing)
+std::string with_query_param(const std::string& url, const std::string& name, const std::string& value);
+
+// Returns url without the given query parameter
+std::string without_query_param(const std::string& url, const std::string& name);
+
+// Value of a query parameter, or "" when absent
+std::string query_param(const std::string& url, const std::string& name);
+
+#endif // FEED_CRAWLER_H
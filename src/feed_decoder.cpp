@@ -0,0 +1,526 @@
+#include <algorithm>
+#include <cstring>
+#include "fast_number.h"
+#include "feed_decoder.h"
+#include "feed_stream.h"
+#include "mapped_file.h"
+
+using namespace std;
+
+namespace {
+
+// Day arrays are only kept by the view form of a feed
+void note_day_text(DecodedFeed&, string_view) {}
+void note_day_text(FeedView& feed, string_view text) {
+    feed.day_texts.push_back(text);
+}
+
+// Recursive-descent reader over one complete document. Each parse_* member consumes exactly one
+// JSON value and writes the fields it knows into the record being built. Feed is DecodedFeed
+// (text copied into strings) or FeedView (text viewed in place; strings that had escapes are
+// unescaped into `unescaped`, whose elements never move).
+// Broken JSON structure throws, since nothing after it can be trusted. A value of the wrong type
+// inside a record does not: the value is skipped, the first such error is remembered with its
+// offset and field path, and the record is dropped into feed.malformed once its object closes.
+template <typename Feed>
+class FeedDecoder {
+public:
+    explicit FeedDecoder(string_view text, deque<string>* unescaped = nullptr)
+        : begin_(text.data()), p_(text.data()), end_(text.data() + text.size()), unescaped_(unescaped) {}
+
+    Feed decode() {
+        Feed feed;
+        skip_whitespace();
+        for_each_member([&](string_view key) {
+            if (key == "near_earth_objects") {
+                parse_dates(feed);
+            } else if (key == "element_count") {
+                feed.element_count = parse_feed_integer(number_token());
+            } else {
+                skip_value();
+            }
+        });
+        skip_whitespace();
+        if (p_ != end_) fail("Unexpected data after the document");
+        return feed;
+    }
+
+private:
+    [[noreturn]] void fail(const string& msg) const {
+        throw JsonStreamError(msg, static_cast<size_t>(p_ - begin_));
+    }
+
+    // Function to note a bad value in the current record; only the first one is kept
+    void field_error(const char* path, const char* at, const char* message) {
+        if (recordFailed_) return;
+        recordFailed_ = true;
+        recordError_.offset = static_cast<size_t>(at - begin_);
+        recordError_.path = path;
+        recordError_.message = message;
+    }
+
+    // Skips a value of the wrong type for a field
+    void wrong_type(const char* path, const char* message) {
+        const char* at = p_;
+        skip_value();
+        field_error(path, at, message);
+    }
+
+    void skip_whitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) ++p_;
+    }
+
+    char peek() {
+        skip_whitespace();
+        if (p_ == end_) fail("Unexpected end of input");
+        return *p_;
+    }
+
+    void expect(char c) {
+        if (peek() != c) fail(string("Expected '") + c + "'");
+        ++p_;
+    }
+
+    // Calls onKey for every member of the object at the cursor; onKey must consume the value
+    template <typename OnKey>
+    void for_each_member(OnKey onKey) {
+        expect('{');
+        if (peek() == '}') {
+            ++p_;
+            return;
+        }
+        // Each nesting level unescapes into its own buffer: onKey may recurse into a nested object,
+        // and key must stay valid while it runs. The buffer only allocates for a key with escapes.
+        string keyScratch;
+        while (true) {
+            if (peek() != '"') fail("Expected a key");
+            string_view key = parse_string(keyScratch);
+            expect(':');
+            skip_whitespace();
+            onKey(key);
+            char next = peek();
+            ++p_;
+            if (next == '}') return;
+            if (next != ',') fail("Expected ',' or '}'");
+        }
+    }
+
+    // Calls onElement for every element of the array at the cursor, with its index
+    template <typename OnElement>
+    void for_each_element(OnElement onElement) {
+        expect('[');
+        if (peek() == ']') {
+            ++p_;
+            return;
+        }
+        for (size_t index = 0;; ++index) {
+            skip_whitespace();
+            onElement(index);
+            char next = peek();
+            ++p_;
+            if (next == ']') return;
+            if (next != ',') fail("Expected ',' or ']'");
+        }
+    }
+
+    // Function to read a string; the view points into the input unless the string had escapes
+    string_view parse_string(string& scratch) {
+        if (peek() != '"') fail("Expected a string");
+        const char* start = ++p_;
+        while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+            if (static_cast<unsigned char>(*p_) < 0x20) fail("Control character in string");
+            ++p_;
+        }
+        if (p_ == end_) fail("Unterminated string");
+        if (*p_ == '"') {
+            return string_view(start, static_cast<size_t>(p_++ - start));
+        }
+
+        scratch.assign(start, p_);
+        while (true) {
+            if (p_ == end_) fail("Unterminated string");
+            char c = *p_++;
+            if (c == '"') return scratch;
+            if (static_cast<unsigned char>(c) < 0x20) fail("Control character in string");
+            if (c != '\\') {
+                scratch += c;
+                continue;
+            }
+            if (p_ == end_) fail("Unterminated string");
+            switch (*p_++) {
+                case '"': scratch += '"'; break;
+                case '\\': scratch += '\\'; break;
+                case '/': scratch += '/'; break;
+                case 'b': scratch += '\b'; break;
+                case 'f': scratch += '\f'; break;
+                case 'n': scratch += '\n'; break;
+                case 'r': scratch += '\r'; break;
+                case 't': scratch += '\t'; break;
+                case 'u': append_utf8(scratch, unicode_escape()); break;
+                default: --p_; fail("Invalid escape");
+            }
+        }
+    }
+
+    unsigned hex4() {
+        if (end_ - p_ < 4) fail("Truncated \\u escape");
+        unsigned value = 0;
+        for (int i = 0; i < 4; ++i, ++p_) {
+            char c = *p_;
+            unsigned digit = c >= '0' && c <= '9' ? c - '0'
+                           : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                           : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+            if (digit == 16) fail("Invalid \\u escape");
+            value = value * 16 + digit;
+        }
+        return value;
+    }
+
+    unsigned unicode_escape() {
+        unsigned cp = hex4();
+        if (cp >= 0xD800 && cp < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+            p_ += 2;
+            unsigned low = hex4();
+            if (low >= 0xDC00 && low < 0xE000) return 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            fail("Invalid surrogate pair");
+        }
+        return cp;
+    }
+
+    string_view number_token() {
+        skip_whitespace();
+        const char* start = p_;
+        while (p_ < end_ && ((*p_ >= '0' && *p_ <= '9') || *p_ == '-' || *p_ == '+' || *p_ == '.' || *p_ == 'e' || *p_ == 'E')) {
+            ++p_;
+        }
+        if (p_ == start) fail("Expected a number");
+        return string_view(start, static_cast<size_t>(p_ - start));
+    }
+
+    bool literal(const char* word) {
+        size_t length = strlen(word);
+        if (static_cast<size_t>(end_ - p_) < length || memcmp(p_, word, length) != 0) return false;
+        p_ += length;
+        return true;
+    }
+
+    // Text of a number, bare or in a string (NeoWs sends most numbers as strings); false for null
+    // and for values of another type, which are reported against path
+    bool numeric_text(const char* path, string_view& text) {
+        char c = peek();
+        if (c == '"') {
+            text = parse_string(valueScratch_);
+            return true;
+        }
+        if (literal("null")) return false;
+        if (c == '{' || c == '[' || c == 't' || c == 'f') {
+            wrong_type(path, "Expected a number");
+            return false;
+        }
+        text = number_token();
+        return true;
+    }
+
+    double parse_number_field(const char* path) {
+        const char* at = peek() == '"' ? p_ + 1 : p_;
+        string_view text;
+        double value = 0.0;
+        if (numeric_text(path, text) && !parse_decimal(text, value)) {
+            field_error(path, at, "Invalid number");
+        }
+        return value;
+    }
+
+    bool parse_bool(const char* path) {
+        skip_whitespace();
+        if (literal("true")) return true;
+        if (literal("false")) return false;
+        if (literal("null")) return false;
+        wrong_type(path, "Expected true or false");
+        return false;
+    }
+
+    void assign_text(string& out, string_view text) {
+        out.assign(text);
+    }
+
+    // Views into the input are kept as they are; anything else was built in a scratch buffer
+    void assign_text(string_view& out, string_view text) {
+        if (text.data() >= begin_ && text.data() + text.size() <= end_) {
+            out = text;
+        } else {
+            unescaped_->emplace_back(text);
+            out = unescaped_->back();
+        }
+    }
+
+    template <typename Text>
+    void parse_text(Text& out, const char* path) {
+        skip_whitespace();
+        if (literal("null")) {
+            out = Text();
+        } else if (peek() != '"') {
+            wrong_type(path, "Expected a string");
+        } else {
+            assign_text(out, parse_string(valueScratch_));
+        }
+    }
+
+    // close_approach_date, decoded to its day number; null reads as the epoch day
+    void parse_date_field(Date& out, const char* path) {
+        skip_whitespace();
+        if (literal("null")) {
+            out = Date();
+        } else if (peek() != '"') {
+            wrong_type(path, "Expected a date");
+        } else {
+            const char* at = p_ + 1;
+            if (!parse_date(parse_string(valueScratch_), out)) field_error(path, at, "Invalid date");
+        }
+    }
+
+    // Function to skip any value without looking at its contents beyond what the grammar needs
+    void skip_value() {
+        char c = peek();
+        if (c == '"') {
+            parse_string(valueScratch_);
+        } else if (c == '{') {
+            for_each_member([&](string_view) { skip_value(); });
+        } else if (c == '[') {
+            for_each_element([&](size_t) { skip_value(); });
+        } else if (!literal("true") && !literal("false") && !literal("null")) {
+            number_token();
+        }
+    }
+
+    void parse_dates(Feed& feed) {
+        for_each_member([&](string_view date) {
+            feed.dates.emplace_back();
+            assign_text(feed.dates.back(), date);
+            const auto& feedDate = feed.dates.back();
+            const char* dayStart = p_;
+            for_each_element([&](size_t) {
+                const char* objectStart = p_;
+                feed.records.emplace_back();
+                auto& record = feed.records.back();
+                record.feed_date = feedDate;
+                parse_neo(record);
+                if (!recordFailed_ && record.id.empty()) {
+                    field_error("id", objectStart, "Missing id");
+                }
+                if (recordFailed_) {
+                    feed.malformed.push_back(std::move(recordError_));
+                    feed.records.pop_back();
+                    recordFailed_ = false;
+                }
+            });
+            note_day_text(feed, string_view(dayStart, static_cast<size_t>(p_ - dayStart)));
+        });
+    }
+
+    template <typename Record>
+    void parse_neo(Record& record) {
+        for_each_member([&](string_view key) {
+            if (key == "id") parse_text(record.id, "id");
+            else if (key == "name") parse_text(record.name, "name");
+            else if (key == "nasa_jpl_url") parse_text(record.nasa_jpl_url, "nasa_jpl_url");
+            else if (key == "absolute_magnitude_h") record.absolute_magnitude_h = parse_number_field("absolute_magnitude_h");
+            else if (key == "estimated_diameter") parse_diameters(record);
+            else if (key == "is_potentially_hazardous_asteroid") {
+                record.is_potentially_hazardous = parse_bool("is_potentially_hazardous_asteroid");
+            } else if (key == "is_sentry_object") record.is_sentry_object = parse_bool("is_sentry_object");
+            else if (key == "close_approach_data") {
+                // Only the first close approach is kept, matching the rest of the program
+                for_each_element([&](size_t index) {
+                    if (index == 0) parse_approach(record.approach);
+                    else skip_value();
+                });
+            } else {
+                skip_value();
+            }
+        });
+    }
+
+    template <typename Record>
+    void parse_diameters(Record& record) {
+        for_each_member([&](string_view unit) {
+            double* minField = nullptr;
+            double* maxField = nullptr;
+            const char* minPath = nullptr;
+            const char* maxPath = nullptr;
+            if (unit == "kilometers") {
+                minField = &record.diameter_km_min;
+                maxField = &record.diameter_km_max;
+                minPath = "estimated_diameter.kilometers.estimated_diameter_min";
+                maxPath = "estimated_diameter.kilometers.estimated_diameter_max";
+            } else if (unit == "meters") {
+                minField = &record.diameter_m_min;
+                maxField = &record.diameter_m_max;
+                minPath = "estimated_diameter.meters.estimated_diameter_min";
+                maxPath = "estimated_diameter.meters.estimated_diameter_max";
+            } else {
+                skip_value();
+                return;
+            }
+            for_each_member([&](string_view bound) {
+                if (bound == "estimated_diameter_min") *minField = parse_number_field(minPath);
+                else if (bound == "estimated_diameter_max") *maxField = parse_number_field(maxPath);
+                else skip_value();
+            });
+        });
+    }
+
+    template <typename Approach>
+    void parse_approach(Approach& approach) {
+        for_each_member([&](string_view key) {
+            if (key == "close_approach_date") parse_date_field(approach.date, "close_approach_data.0.close_approach_date");
+            else if (key == "close_approach_date_full") {
+                parse_text(approach.date_full, "close_approach_data.0.close_approach_date_full");
+            } else if (key == "epoch_date_close_approach") approach.epoch_ms = parse_epoch();
+            else if (key == "orbiting_body") parse_text(approach.orbiting_body, "close_approach_data.0.orbiting_body");
+            else if (key == "relative_velocity") {
+                for_each_member([&](string_view unit) {
+                    if (unit == "kilometers_per_second") {
+                        approach.velocity_km_s = parse_number_field("close_approach_data.0.relative_velocity.kilometers_per_second");
+                    } else if (unit == "kilometers_per_hour") {
+                        approach.velocity_km_h = parse_number_field("close_approach_data.0.relative_velocity.kilometers_per_hour");
+                    } else {
+                        skip_value();
+                    }
+                });
+            } else if (key == "miss_distance") {
+                for_each_member([&](string_view unit) {
+                    if (unit == "astronomical") approach.miss_au = parse_number_field("close_approach_data.0.miss_distance.astronomical");
+                    else if (unit == "lunar") approach.miss_lunar = parse_number_field("close_approach_data.0.miss_distance.lunar");
+                    else if (unit == "kilometers") approach.miss_km = parse_number_field("close_approach_data.0.miss_distance.kilometers");
+                    else if (unit == "miles") approach.miss_miles = parse_number_field("close_approach_data.0.miss_distance.miles");
+                    else skip_value();
+                });
+            } else {
+                skip_value();
+            }
+        });
+    }
+
+    int64_t parse_epoch() {
+        const char* path = "close_approach_data.0.epoch_date_close_approach";
+        const char* at = peek() == '"' ? p_ + 1 : p_;
+        string_view text;
+        int64_t value = 0;
+        if (numeric_text(path, text) && !parse_feed_integer(text, value)) {
+            field_error(path, at, "Invalid integer");
+        }
+        return value;
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    string valueScratch_;   // unescaped string value
+    deque<string>* unescaped_;
+    bool recordFailed_ = false;
+    DecodeError recordError_;   // first bad value of the current record
+};
+
+} // namespace
+
+DecodedFeed decode_feed(string_view body) {
+    return FeedDecoder<DecodedFeed>(body).decode();
+}
+
+FeedView decode_feed_view(string_view body, deque<string>& unescaped) {
+    return FeedDecoder<FeedView>(body, &unescaped).decode();
+}
+
+StreamedFeed::StreamedFeed()
+    : parser_([this](NeoRecord&& record) { decoded_.records.push_back(std::move(record)); }) {}
+
+void StreamedFeed::feed(const char* data, size_t size) {
+    text_.append(data, size);
+    parser_.feed(data, size);
+}
+
+void StreamedFeed::finish() {
+    parser_.finish();
+    decoded_.element_count = 0;
+    decoded_.dates.clear();
+    for (const auto& day : parser_.days()) {
+        decoded_.dates.push_back(day.date);
+        decoded_.element_count += static_cast<int64_t>(day.objects);
+    }
+    decoded_.malformed = parser_.malformed();
+}
+
+bool load_feed_file(const string& filename, DecodedFeed& feed) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    feed = decode_feed(file.contents());
+    return true;
+}
+
+bool MappedFeed::load(const string& filename) {
+    feed_ = FeedView();
+    unescaped_.clear();
+    if (!file_.open(filename)) {
+        return false;
+    }
+    feed_ = decode_feed_view(file_.contents(), unescaped_);
+    return true;
+}
+
+NeoRecord to_record(const NeoRecordView& view) {
+    NeoRecord record;
+    record.feed_date = view.feed_date;
+    record.id = view.id;
+    record.name = view.name;
+    record.nasa_jpl_url = view.nasa_jpl_url;
+    record.absolute_magnitude_h = view.absolute_magnitude_h;
+    record.diameter_km_min = view.diameter_km_min;
+    record.diameter_km_max = view.diameter_km_max;
+    record.diameter_m_min = view.diameter_m_min;
+    record.diameter_m_max = view.diameter_m_max;
+    record.is_potentially_hazardous = view.is_potentially_hazardous;
+    record.is_sentry_object = view.is_sentry_object;
+    record.approach.date = view.approach.date;
+    record.approach.date_full = view.approach.date_full;
+    record.approach.epoch_ms = view.approach.epoch_ms;
+    record.approach.velocity_km_s = view.approach.velocity_km_s;
+    record.approach.velocity_km_h = view.approach.velocity_km_h;
+    record.approach.miss_au = view.approach.miss_au;
+    record.approach.miss_lunar = view.approach.miss_lunar;
+    record.approach.miss_km = view.approach.miss_km;
+    record.approach.miss_miles = view.approach.miss_miles;
+    record.approach.orbiting_body = view.approach.orbiting_body;
+    return record;
+}
+
+vector<const NeoRecord*> records_for_date(const DecodedFeed& feed, const string& date) {
+    vector<const NeoRecord*> records;
+    for (const auto& record : feed.records) {
+        if (record.feed_date == date) records.push_back(&record);
+    }
+    return records;
+}
+
+bool has_date(const DecodedFeed& feed, const string& date) {
+    return find(feed.dates.begin(), feed.dates.end(), date) != feed.dates.end();
+}
+
+vector<const NeoRecordView*> records_for_date(const FeedView& feed, string_view date) {
+    vector<const NeoRecordView*> records;
+    for (const auto& record : feed.records) {
+        if (record.feed_date == date) records.push_back(&record);
+    }
+    return records;
+}
+
+bool has_date(const FeedView& feed, string_view date) {
+    return find(feed.dates.begin(), feed.dates.end(), date) != feed.dates.end();
+}
+
+string_view day_text(const FeedView& feed, string_view date) {
+    auto found = find(feed.dates.begin(), feed.dates.end(), date);
+    return found == feed.dates.end() ? string_view() : feed.day_texts[found - feed.dates.begin()];
+}
@@ -0,0 +1,108 @@
+#ifndef FEED_DECODER_H
+#define FEED_DECODER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decode_result.h"
+#include "feed_stream.h"
+#include "mapped_file.h"
+#include "neo_record.h"
+
+// A whole feed document decoded into typed records
+struct DecodedFeed {
+    int64_t element_count = 0;
+    std::vector<std::string> dates;    // keys of near_earth_objects, in document order
+    std::vector<NeoRecord> records;    // every object, grouped by date in document order
+    std::vector<DecodeError> malformed;   // objects skipped for a bad or missing field
+};
+
+// Decodes a complete NeoWs feed document straight into NeoRecords. The decoder knows the feed
+// schema: it walks the text once, fills the record fields as their keys come up and skips
+// everything else without building a DOM. An object with a missing id or a value of the wrong
+// type (e.g. a velocity that is not a number) is left out and listed in malformed; only broken
+// JSON structure throws JsonStreamError.
+DecodedFeed decode_feed(std::string_view body);
+
+// The same, with every text field viewing the document instead of copying it
+struct FeedView {
+    int64_t element_count = 0;
+    std::vector<std::string_view> dates;
+    std::vector<std::string_view> day_texts;   // raw JSON array of each date, parallel to dates
+    std::vector<NeoRecordView> records;
+    std::vector<DecodeError> malformed;
+};
+
+// Decodes a feed without copying its text. Views point into body, or into `unescaped` for
+// strings that had escape sequences; both must outlive the result.
+FeedView decode_feed_view(std::string_view body, std::deque<std::string>& unescaped);
+
+// A feed arriving in chunks (a download, an inflating cache entry): keeps the text and decodes
+// records as each object closes, so the DecodedFeed is ready as soon as the last chunk is in.
+// element_count is the number of objects seen; the offsets in days() index text().
+class StreamedFeed {
+public:
+    StreamedFeed();
+    StreamedFeed(const StreamedFeed&) = delete;
+    StreamedFeed& operator=(const StreamedFeed&) = delete;
+
+    // Appends a chunk; JsonStreamError when the text so far is not a feed
+    void feed(const char* data, size_t size);
+
+    // Ends the document; JsonStreamError when it is incomplete
+    void finish();
+
+    const std::string& text() const { return text_; }
+    const std::vector<FeedDaySpan>& days() const { return parser_.days(); }
+
+    // Moves the text or the decoded feed out; call after finish()
+    std::string take_text() { return std::move(text_); }
+    DecodedFeed take_feed() { return std::move(decoded_); }
+
+private:
+    std::string text_;
+    DecodedFeed decoded_;
+    FeedStreamParser parser_;
+};
+
+// Reads and decodes a feed document saved on disk (e.g. data.json); false when it cannot be read
+bool load_feed_file(const std::string& filename, DecodedFeed& feed);
+
+// A feed file mapped into memory and decoded in place. Every string_view in feed() points into
+// the mapping (or the handle's own unescaped strings) and stays valid until the handle is
+// destroyed or loads another file.
+class MappedFeed {
+public:
+    MappedFeed() = default;
+    MappedFeed(const MappedFeed&) = delete;
+    MappedFeed& operator=(const MappedFeed&) = delete;
+
+    // Maps and decodes filename; false when it cannot be read, JsonStreamError when malformed
+    bool load(const std::string& filename);
+
+    const FeedView& feed() const { return feed_; }
+
+private:
+    MappedFile file_;
+    std::deque<std::string> unescaped_;
+    FeedView feed_;
+};
+
+// Copies a record out of its document
+NeoRecord to_record(const NeoRecordView& view);
+
+// Records of one date in document order; empty when the date is missing or has no objects
+std::vector<const NeoRecord*> records_for_date(const DecodedFeed& feed, const std::string& date);
+
+// True when near_earth_objects has a key for the date
+bool has_date(const DecodedFeed& feed, const std::string& date);
+
+std::vector<const NeoRecordView*> records_for_date(const FeedView& feed, std::string_view date);
+bool has_date(const FeedView& feed, std::string_view date);
+
+// Raw JSON array of one date's objects; empty when the date is missing
+std::string_view day_text(const FeedView& feed, std::string_view date);
+
+#endif // FEED_DECODER_H
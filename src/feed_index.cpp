@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <cstring>
+#include "fast_number.h"
+#include "feed_index.h"
+#include "feed_stream.h"
+#include "platform_config.h"
+
+using namespace std;
+
+namespace {
+
+// Characters that end a number or literal
+bool ends_scalar(char c) {
+    return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Minimal JSON walker for the structural pass and for cursor paths. It finds string ends and
+// matching brackets and nothing more; values are left as raw text.
+class StructureScanner {
+public:
+    StructureScanner(string_view text, size_t baseOffset)
+        : begin_(text.data()), p_(text.data()), end_(text.data() + text.size()), baseOffset_(baseOffset) {}
+
+    size_t offset() const { return baseOffset_ + static_cast<size_t>(p_ - begin_); }
+
+    [[noreturn]] void fail(const string& msg) const {
+        throw JsonStreamError(msg, offset());
+    }
+
+    void skip_whitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) ++p_;
+    }
+
+    char peek() {
+        skip_whitespace();
+        if (p_ == end_) fail("Unexpected end of input");
+        return *p_;
+    }
+
+    void expect(char c) {
+        if (peek() != c) fail(string("Expected '") + c + "'");
+        ++p_;
+    }
+
+    bool at_end() {
+        skip_whitespace();
+        return p_ == end_;
+    }
+
+    // Function to step over a string; returns its raw contents without the quotes
+    string_view scan_string() {
+        if (peek() != '"') fail("Expected a string");
+        const char* start = ++p_;
+        while (true) {
+            const char* quote = static_cast<const char*>(memchr(p_, '"', static_cast<size_t>(end_ - p_)));
+            if (quote == nullptr) {
+                p_ = end_;
+                fail("Unterminated string");
+            }
+            // The quote is escaped only when an odd number of backslashes precede it
+            const char* backslash = quote;
+            while (backslash > start && backslash[-1] == '\\') --backslash;
+            p_ = quote + 1;
+            if ((quote - backslash) % 2 == 0) {
+                return string_view(start, static_cast<size_t>(quote - start));
+            }
+        }
+    }
+
+    // Function to step over any value; returns its raw text
+    string_view skip_value() {
+        char c = peek();
+        const char* start = p_;
+        if (c == '"') {
+            scan_string();
+        } else if (c == '{' || c == '[') {
+            skip_nested();
+        } else {
+            while (p_ < end_ && !ends_scalar(*p_)) ++p_;
+            if (p_ == start) fail("Expected a value");
+        }
+        return string_view(start, static_cast<size_t>(p_ - start));
+    }
+
+    // Calls onKey for every member of the object at the cursor until it returns false; onKey
+    // must consume the value when it returns true
+    template <typename OnKey>
+    void for_each_member(OnKey onKey) {
+        expect('{');
+        if (peek() == '}') {
+            ++p_;
+            return;
+        }
+        while (true) {
+            string_view key = scan_string();
+            expect(':');
+            skip_whitespace();
+            if (!onKey(key)) return;
+            char next = peek();
+            ++p_;
+            if (next == '}') return;
+            if (next != ',') fail("Expected ',' or '}'");
+        }
+    }
+
+    // Same for the elements of an array, with their index
+    template <typename OnElement>
+    void for_each_element(OnElement onElement) {
+        expect('[');
+        if (peek() == ']') {
+            ++p_;
+            return;
+        }
+        for (size_t index = 0;; ++index) {
+            skip_whitespace();
+            if (!onElement(index)) return;
+            char next = peek();
+            ++p_;
+            if (next == ']') return;
+            if (next != ',') fail("Expected ',' or ']'");
+        }
+    }
+
+private:
+    // Bracket matching that only looks inside strings to find where they end
+    void skip_nested() {
+        size_t depth = 0;
+        while (p_ < end_) {
+            char c = *p_;
+            if (c == '"') {
+                scan_string();
+                continue;
+            }
+            ++p_;
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return;
+            }
+        }
+        fail("Unbalanced brackets");
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    size_t baseOffset_;
+};
+
+bool is_null(string_view raw) {
+    return raw.empty() || raw == "null";
+}
+
+} // namespace
+
+FeedIndex::FeedIndex(string_view document) : document_(document) {
+    StructureScanner scanner(document, 0);
+    scanner.for_each_member([&](string_view key) {
+        if (key != "near_earth_objects") {
+            scanner.skip_value();
+            return true;
+        }
+        scanner.for_each_member([&](string_view date) {
+            uint32_t dateIndex = static_cast<uint32_t>(dates_.size());
+            dates_.push_back(date);
+            dateFirstObject_.push_back(objects_.size());
+            scanner.for_each_element([&](size_t) {
+                IndexedObject object{dateIndex, 0, members_.size(), scanner.offset()};
+                scanner.for_each_member([&](string_view memberKey) {
+                    size_t valueBegin = scanner.offset();
+                    scanner.skip_value();
+                    members_.push_back({memberKey, valueBegin, scanner.offset()});
+                    ++object.member_count;
+                    return true;
+                });
+                objects_.push_back(object);
+                return true;
+            });
+            return true;
+        });
+        return true;
+    });
+    if (!scanner.at_end()) scanner.fail("Unexpected data after the document");
+    dateFirstObject_.push_back(objects_.size());
+}
+
+bool FeedIndex::has_date(string_view date) const {
+    return find(dates_.begin(), dates_.end(), date) != dates_.end();
+}
+
+vector<NeoCursor> FeedIndex::objects(string_view date) const {
+    vector<NeoCursor> cursors;
+    auto found = find(dates_.begin(), dates_.end(), date);
+    if (found == dates_.end()) {
+        return cursors;
+    }
+    size_t dateIndex = static_cast<size_t>(found - dates_.begin());
+    for (size_t i = dateFirstObject_[dateIndex]; i < dateFirstObject_[dateIndex + 1]; ++i) {
+        cursors.emplace_back(*this, i);
+    }
+    return cursors;
+}
+
+string_view FeedIndex::member(size_t object, string_view key) const {
+    const IndexedObject& indexed = objects_[object];
+    for (size_t i = indexed.first_member; i < indexed.first_member + indexed.member_count; ++i) {
+        if (members_[i].key == key) {
+            return document_.substr(members_[i].value_begin, members_[i].value_end - members_[i].value_begin);
+        }
+    }
+    return string_view();
+}
+
+string_view NeoCursor::feed_date() const {
+    return index_->dates_[index_->objects_[object_].date];
+}
+
+size_t NeoCursor::offset() const {
+    return index_->objects_[object_].offset;
+}
+
+size_t NeoCursor::offset_of(string_view value) const {
+    return value.empty() ? offset() : static_cast<size_t>(value.data() - index_->document_.data());
+}
+
+// Function to follow a dotted path: the first step uses the index, the rest scan only the
+// value found so far
+string_view NeoCursor::raw(string_view path) const {
+    size_t dot = path.find('.');
+    string_view value = index_->member(object_, path.substr(0, dot));
+    while (dot != string_view::npos && !value.empty()) {
+        path.remove_prefix(dot + 1);
+        dot = path.find('.');
+        string_view step = path.substr(0, dot);
+
+        size_t valueOffset = static_cast<size_t>(value.data() - index_->document_.data());
+        StructureScanner scanner(value, valueOffset);
+        string_view found;
+        if (value.front() == '{') {
+            scanner.for_each_member([&](string_view key) {
+                string_view memberValue = scanner.skip_value();
+                if (key == step) found = memberValue;
+                return key != step;
+            });
+        } else if (value.front() == '[') {
+            size_t wanted = static_cast<size_t>(parse_feed_integer(step));
+            scanner.for_each_element([&](size_t index) {
+                string_view element = scanner.skip_value();
+                if (index == wanted) found = element;
+                return index != wanted;
+            });
+        }
+        value = found;
+    }
+    return value;
+}
+
+string NeoCursor::text(string_view path) const {
+    return decode_text(raw(path));
+}
+
+double NeoCursor::number(string_view path) const {
+    string_view value = raw(path);
+    double number = 0.0;
+    if (!decode_number(value, number)) {
+        throw JsonStreamError("Invalid number in feed: " + string(value), offset_of(value));
+    }
+    return number;
+}
+
+bool NeoCursor::flag(string_view path) const {
+    return raw(path) == "true";
+}
+
+string decode_text(string_view raw) {
+    if (is_null(raw)) {
+        return string();
+    }
+    if (raw.front() != '"') {
+        return string(raw);
+    }
+    string_view contents = raw.substr(1, raw.size() - 2);
+    if (contents.find('\\') == string_view::npos) {
+        return string(contents);
+    }
+    // Escapes are rare in the feed; let the JSON library undo them
+    return json::parse(raw.begin(), raw.end()).get<string>();
+}
+
+bool decode_number(string_view raw, double& value) {
+    if (is_null(raw)) {
+        value = 0.0;
+        return true;
+    }
+    if (raw.front() == '"') {
+        raw = raw.substr(1, raw.size() - 2);
+    }
+    return parse_decimal(raw, value);
+}
+
+bool decode_integer(string_view raw, int64_t& value) {
+    if (is_null(raw)) {
+        value = 0;
+        return true;
+    }
+    return parse_feed_integer(raw, value);
+}
+
+double decode_number(string_view raw) {
+    double value = 0.0;
+    if (!decode_number(raw, value)) {
+        throw invalid_argument("Invalid number in feed: " + string(raw));
+    }
+    return value;
+}
+
+int64_t decode_integer(string_view raw) {
+    int64_t value = 0;
+    if (!decode_integer(raw, value)) {
+        throw invalid_argument("Invalid integer in feed: " + string(raw));
+    }
+    return value;
+}
+
+bool decode_flag(string_view raw) {
+    return raw == "true";
+}
+
+Date decode_date(string_view raw) {
+    Date value;
+    if (!decode_date(raw, value)) {
+        throw invalid_argument("Invalid date in feed: " + string(raw));
+    }
+    return value;
+}
+
+bool decode_text(string_view raw, string& value) {
+    if (!raw.empty() && raw.front() != '"' && !is_null(raw)) {
+        return false;
+    }
+    value = decode_text(raw);
+    return true;
+}
+
+bool decode_flag(string_view raw, bool& value) {
+    if (!raw.empty() && raw != "true" && raw != "false" && !is_null(raw)) {
+        return false;
+    }
+    value = raw == "true";
+    return true;
+}
+
+bool decode_date(string_view raw, Date& value) {
+    if (is_null(raw)) {
+        value = Date();
+        return true;
+    }
+    // Dates have no escapes, so the quoted text is the date itself
+    if (raw.size() < 2 || raw.front() != '"') {
+        return false;
+    }
+    return parse_date(raw.substr(1, raw.size() - 2), value);
+}
+
+FieldExtractor::FieldExtractor(const vector<string>& paths) : pathCount_(paths.size()) {
+    nodes_.emplace_back();
+    for (size_t slot = 0; slot < paths.size(); ++slot) {
+        size_t node = 0;
+        string_view path = paths[slot];
+        while (true) {
+            size_t dot = path.find('.');
+            string step(path.substr(0, dot));
+            size_t child = NO_NODE;
+            for (size_t candidate : nodes_[node].children) {
+                if (nodes_[candidate].key == step) child = candidate;
+            }
+            if (child == NO_NODE) {
+                child = nodes_.size();
+                Node created;
+                created.key = step;
+                nodes_.push_back(created);
+                nodes_[node].children.push_back(child);
+            }
+            node = child;
+            if (dot == string_view::npos) break;
+            path.remove_prefix(dot + 1);
+        }
+        nodes_[node].slot = slot;
+    }
+}
+
+void FieldExtractor::extract(const NeoCursor& neo, vector<string_view>& values) {
+    values.assign(pathCount_, string_view());
+    const FeedIndex& index = *neo.index_;
+    const FeedIndex::IndexedObject& object = index.objects_[neo.object_];
+    const FeedIndex::Member* members = index.members_.data() + object.first_member;
+
+    // Top-level members come straight from the index: try the position seen on earlier objects,
+    // then search by key
+    for (size_t child : nodes_[0].children) {
+        Node& node = nodes_[child];
+        size_t ordinal = node.position;
+        if (ordinal >= object.member_count || members[ordinal].key != node.key) {
+            ordinal = NO_NODE;
+            for (size_t m = 0; m < object.member_count; ++m) {
+                if (members[m].key == node.key) ordinal = m;
+            }
+            if (ordinal == NO_NODE) continue;
+            if (node.position != NO_NODE) ++fallbacks_;
+            node.position = ordinal;
+        }
+        const FeedIndex::Member& member = members[ordinal];
+        found(child, index.document_.substr(member.value_begin, member.value_end - member.value_begin),
+              static_cast<size_t>(member.value_begin), values);
+    }
+}
+
+// Function to record a matched value and, for inner nodes, extract its children in one scan
+void FieldExtractor::found(size_t node, string_view value, size_t offset, vector<string_view>& values) {
+    if (nodes_[node].slot != NO_NODE) {
+        values[nodes_[node].slot] = value;
+    }
+    if (nodes_[node].children.empty() || value.empty() || (value.front() != '{' && value.front() != '[')) {
+        return;
+    }
+
+    StructureScanner scanner(value, offset);
+    size_t remaining = nodes_[node].children.size();
+    auto visit = [&](size_t ordinal, string_view key) {
+        size_t child = match(node, ordinal, key);
+        size_t valueOffset = scanner.offset();
+        string_view childValue = scanner.skip_value();
+        if (child != NO_NODE) {
+            found(child, childValue, valueOffset, values);
+            --remaining;
+        }
+        return remaining > 0;
+    };
+    if (value.front() == '{') {
+        size_t ordinal = 0;
+        scanner.for_each_member([&](string_view key) { return visit(ordinal++, key); });
+    } else {
+        scanner.for_each_element([&](size_t element) { return visit(element, to_string(element)); });
+    }
+}
+
+// The child of node for the member at this ordinal, checking the resolved position first
+size_t FieldExtractor::match(size_t node, size_t ordinal, string_view key) {
+    for (size_t child : nodes_[node].children) {
+        if (nodes_[child].position == ordinal && nodes_[child].key == key) return child;
+    }
+    for (size_t child : nodes_[node].children) {
+        if (nodes_[child].key == key) {
+            if (nodes_[child].position != NO_NODE) ++fallbacks_;
+            nodes_[child].position = ordinal;
+            return child;
+        }
+    }
+    return NO_NODE;
+}
+
+const vector<string>& neo_record_paths() {
+    // In NeoRecordPath order
+    static const vector<string> paths = {
+        "id",
+        "name",
+        "nasa_jpl_url",
+        "absolute_magnitude_h",
+        "estimated_diameter.kilometers.estimated_diameter_min",
+        "estimated_diameter.kilometers.estimated_diameter_max",
+        "estimated_diameter.meters.estimated_diameter_min",
+        "estimated_diameter.meters.estimated_diameter_max",
+        "is_potentially_hazardous_asteroid",
+        "is_sentry_object",
+        // Only the first close approach is kept, matching the rest of the program
+        "close_approach_data.0.close_approach_date",
+        "close_approach_data.0.close_approach_date_full",
+        "close_approach_data.0.epoch_date_close_approach",
+        "close_approach_data.0.relative_velocity.kilometers_per_second",
+        "close_approach_data.0.relative_velocity.kilometers_per_hour",
+        "close_approach_data.0.miss_distance.astronomical",
+        "close_approach_data.0.miss_distance.lunar",
+        "close_approach_data.0.miss_distance.kilometers",
+        "close_approach_data.0.miss_distance.miles",
+        "close_approach_data.0.orbiting_body",
+    };
+    return paths;
+}
+
+RecordExtractor::RecordExtractor() : fields_(neo_record_paths()) {}
+
+DecodeResult<NeoRecord> RecordExtractor::try_extract(const NeoCursor& neo) {
+    fields_.extract(neo, values_);
+    NeoRecord record;
+    // Only the first bad field is reported; the rest of the record is decoded regardless
+    NeoRecordPath badPath = PATH_ID;
+    const char* badMessage = nullptr;
+    auto check = [&](bool decoded, NeoRecordPath path, const char* message) {
+        if (!decoded && !badMessage) {
+            badPath = path;
+            badMessage = message;
+        }
+    };
+    auto text = [&](NeoRecordPath path, string& out) { check(decode_text(values_[path], out), path, "Expected a string"); };
+    auto number = [&](NeoRecordPath path, double& out) { check(decode_number(values_[path], out), path, "Invalid number"); };
+    auto flag = [&](NeoRecordPath path, bool& out) { check(decode_flag(values_[path], out), path, "Expected true or false"); };
+    record.feed_date = neo.feed_date();
+    text(PATH_ID, record.id);
+    text(PATH_NAME, record.name);
+    text(PATH_JPL_URL, record.nasa_jpl_url);
+    number(PATH_MAGNITUDE, record.absolute_magnitude_h);
+    number(PATH_DIAMETER_KM_MIN, record.diameter_km_min);
+    number(PATH_DIAMETER_KM_MAX, record.diameter_km_max);
+    number(PATH_DIAMETER_M_MIN, record.diameter_m_min);
+    number(PATH_DIAMETER_M_MAX, record.diameter_m_max);
+    flag(PATH_HAZARDOUS, record.is_potentially_hazardous);
+    flag(PATH_SENTRY, record.is_sentry_object);
+    CloseApproach& first = record.approach;
+    check(decode_date(values_[PATH_APPROACH_DATE], first.date), PATH_APPROACH_DATE, "Invalid date");
+    text(PATH_APPROACH_DATE_FULL, first.date_full);
+    check(decode_integer(values_[PATH_EPOCH], first.epoch_ms), PATH_EPOCH, "Invalid integer");
+    number(PATH_VELOCITY_KM_S, first.velocity_km_s);
+    number(PATH_VELOCITY_KM_H, first.velocity_km_h);
+    number(PATH_MISS_AU, first.miss_au);
+    number(PATH_MISS_LUNAR, first.miss_lunar);
+    number(PATH_MISS_KM, first.miss_km);
+    number(PATH_MISS_MILES, first.miss_miles);
+    text(PATH_ORBITING_BODY, first.orbiting_body);
+    check(!record.id.empty(), PATH_ID, "Missing id");
+    if (badMessage) {
+        return DecodeError{neo.offset_of(values_[badPath]), neo_record_paths()[badPath], badMessage};
+    }
+    return record;
+}
+
+NeoRecord RecordExtractor::extract(const NeoCursor& neo) {
+    DecodeResult<NeoRecord> result = try_extract(neo);
+    if (!result) {
+        throw JsonStreamError(result.error().message + " (" + result.error().path + ")", result.error().offset);
+    }
+    return std::move(result.value());
+}
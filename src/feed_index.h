@@ -0,0 +1,188 @@
+#ifndef FEED_INDEX_H
+#define FEED_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decode_result.h"
+#include "neo_record.h"
+
+class FeedIndex;
+class FieldExtractor;
+
+// Lazy access to one NEO of an indexed feed. Nothing is decoded until a field is asked for;
+// each accessor decodes just that value from the document text.
+class NeoCursor {
+public:
+    NeoCursor(const FeedIndex& index, size_t object) : index_(&index), object_(object) {}
+
+    std::string_view feed_date() const;
+
+    // Byte offset of the object in the document
+    size_t offset() const;
+
+    // Byte offset of a value returned by raw() or FieldExtractor; the object's offset when the
+    // value is missing
+    size_t offset_of(std::string_view value) const;
+
+    // Raw JSON text of a member value, following a dotted path through objects and arrays
+    // (e.g. "close_approach_data.0.miss_distance.kilometers"); empty when the path is missing
+    std::string_view raw(std::string_view path) const;
+
+    // Decoded values at a path: strings are unescaped, numbers may be sent as strings, and
+    // missing values or null read as empty / 0 / false
+    std::string text(std::string_view path) const;
+    double number(std::string_view path) const;
+    bool flag(std::string_view path) const;
+
+    std::string id() const { return text("id"); }
+    std::string name() const { return text("name"); }
+    bool is_potentially_hazardous() const { return flag("is_potentially_hazardous_asteroid"); }
+
+private:
+    friend class FieldExtractor;
+
+    const FeedIndex* index_;
+    size_t object_;
+};
+
+// Structural index of a feed document, built in one quick pass that validates nothing beyond
+// nesting and string boundaries. It records where each date's objects start and end and where
+// every top-level member of each object is, so NeoCursor can find a field without scanning the
+// rest of the document. The document text must outlive the index.
+class FeedIndex {
+public:
+    // Throws JsonStreamError when the structure is broken
+    explicit FeedIndex(std::string_view document);
+
+    const std::vector<std::string_view>& dates() const { return dates_; }
+    size_t object_count() const { return objects_.size(); }
+    bool has_date(std::string_view date) const;
+
+    // Cursors over one date's objects in document order; empty when the date is missing
+    std::vector<NeoCursor> objects(std::string_view date) const;
+    NeoCursor object(size_t index) const { return NeoCursor(*this, index); }
+
+private:
+    friend class NeoCursor;
+    friend class FieldExtractor;
+
+    struct Member {
+        std::string_view key;      // raw key text; NeoWs keys have no escapes
+        size_t value_begin;
+        size_t value_end;
+    };
+    struct IndexedObject {
+        uint32_t date;             // index into dates_
+        uint32_t member_count;
+        size_t first_member;       // index into members_
+        size_t offset;             // where the object starts in the document
+    };
+
+    // Raw value of a top-level member of an object; empty when missing
+    std::string_view member(size_t object, std::string_view key) const;
+
+    std::string_view document_;
+    std::vector<std::string_view> dates_;
+    std::vector<size_t> dateFirstObject_;   // objects of date i are [dateFirstObject_[i], dateFirstObject_[i + 1])
+    std::vector<IndexedObject> objects_;
+    std::vector<Member> members_;
+};
+
+// Decoding of raw values as NeoCursor does it: strings unescaped, numbers possibly sent as
+// strings, missing or null values read as empty / 0 / false. decode_number and decode_integer
+// throw std::invalid_argument on text that is not a number. The two-argument forms check the
+// value's type as well and return false, leaving value untouched, when it does not fit.
+// decode_date reads a YYYY-MM-DD string; a missing or null date reads as the epoch day.
+std::string decode_text(std::string_view raw);
+double decode_number(std::string_view raw);
+int64_t decode_integer(std::string_view raw);
+bool decode_flag(std::string_view raw);
+Date decode_date(std::string_view raw);
+bool decode_text(std::string_view raw, std::string& value);
+bool decode_number(std::string_view raw, double& value);
+bool decode_integer(std::string_view raw, int64_t& value);
+bool decode_flag(std::string_view raw, bool& value);
+bool decode_date(std::string_view raw, Date& value);
+
+// A fixed set of dotted paths compiled into a tree, so that all of them are read from an object
+// in one pass: every nested object on the way is scanned once for all the paths below it. The
+// member position each key had on the first object is remembered and checked first on the
+// next ones; when an object's layout differs the key is searched for instead (and counted as
+// a fallback), so a changed schema costs speed, never correctness. Not thread-safe; use one
+// extractor per thread.
+class FieldExtractor {
+public:
+    explicit FieldExtractor(const std::vector<std::string>& paths);
+
+    // Raw values of the paths in declaration order; empty where a path is missing
+    void extract(const NeoCursor& neo, std::vector<std::string_view>& values);
+
+    // Lookups where the remembered position did not hold
+    uint64_t fallbacks() const { return fallbacks_; }
+
+private:
+    static constexpr size_t NO_NODE = static_cast<size_t>(-1);
+
+    struct Node {
+        std::string key;           // member name, or element index for arrays
+        size_t position = NO_NODE; // member position seen on earlier objects
+        size_t slot = NO_NODE;     // output slot when a declared path ends here
+        std::vector<size_t> children;
+    };
+
+    void found(size_t node, std::string_view value, size_t offset, std::vector<std::string_view>& values);
+    size_t match(size_t node, size_t ordinal, std::string_view key);
+
+    size_t pathCount_;
+    std::vector<Node> nodes_;      // nodes_[0] is the object itself
+    uint64_t fallbacks_ = 0;
+};
+
+// Paths of every NeoRecord field, and their slots in what FieldExtractor returns for them
+const std::vector<std::string>& neo_record_paths();
+enum NeoRecordPath {
+    PATH_ID,
+    PATH_NAME,
+    PATH_JPL_URL,
+    PATH_MAGNITUDE,
+    PATH_DIAMETER_KM_MIN,
+    PATH_DIAMETER_KM_MAX,
+    PATH_DIAMETER_M_MIN,
+    PATH_DIAMETER_M_MAX,
+    PATH_HAZARDOUS,
+    PATH_SENTRY,
+    PATH_APPROACH_DATE,
+    PATH_APPROACH_DATE_FULL,
+    PATH_EPOCH,
+    PATH_VELOCITY_KM_S,
+    PATH_VELOCITY_KM_H,
+    PATH_MISS_AU,
+    PATH_MISS_LUNAR,
+    PATH_MISS_KM,
+    PATH_MISS_MILES,
+    PATH_ORBITING_BODY,
+};
+
+// Every NeoRecord field through one compiled FieldExtractor
+class RecordExtractor {
+public:
+    RecordExtractor();
+
+    // The record, or the offset and path of its first field that does not hold a value of the
+    // field's type (or of a missing id)
+    DecodeResult<NeoRecord> try_extract(const NeoCursor& neo);
+
+    // Throws JsonStreamError where try_extract returns an error
+    NeoRecord extract(const NeoCursor& neo);
+
+    uint64_t fallbacks() const { return fields_.fallbacks(); }
+
+private:
+    FieldExtractor fields_;
+    std::vector<std::string_view> values_;
+};
+
+#endif // FEED_INDEX_H
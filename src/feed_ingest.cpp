@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include "feed_ingest.h"
+#include "latency_recorder.h"
+#include "mapped_file.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Malformed records listed by format_ingest_report; the rest are only counted
+const size_t MALFORMED_SHOWN = 10;
+
+// One file's result, kept in the buffer of the worker that decoded it
+template<typename Feed>
+struct DecodedFile {
+    size_t index = 0;              // position in the sorted path list
+    Feed feed;
+    uint64_t bytes = 0;
+    double ms = 0.0;
+    string error;                  // empty on success
+};
+
+// Shell-style match of * and ? against a whole file name
+bool wildcard_match(const string& name, const string& mask) {
+    size_t n = 0, m = 0;
+    size_t starMask = string::npos, starName = 0;
+    while (n < name.size()) {
+        if (m < mask.size() && (mask[m] == '?' || mask[m] == name[n])) {
+            ++n;
+            ++m;
+        } else if (m < mask.size() && mask[m] == '*') {
+            starMask = m++;
+            starName = n;
+        } else if (starMask != string::npos) {
+            // Let the last * swallow one more character and retry
+            m = starMask + 1;
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (m < mask.size() && mask[m] == '*') ++m;
+    return m == mask.size();
+}
+
+template<typename Feed, typename Decode>
+DecodedFile<Feed> decode_file(size_t index, const string& path, const Decode& decode) {
+    DecodedFile<Feed> result;
+    result.index = index;
+    Clock::time_point started = Clock::now();
+    MappedFile file;
+    if (!file.open(path)) {
+        result.error = "Could not open file";
+    } else {
+        try {
+            result.feed = decode(file.contents());
+            result.bytes = file.contents().size();
+        } catch (const exception& e) {
+            result.error = e.what();
+        }
+    }
+    result.ms = chrono::duration<double, milli>(Clock::now() - started).count();
+    return result;
+}
+
+// Function to decode the files on a worker pool; the results come back in path order
+template<typename Feed, typename Decode>
+vector<DecodedFile<Feed>> decode_files(const vector<string>& paths, size_t threads, const Decode& decode) {
+    // Workers claim files by index; each keeps what it decoded in its own buffer until the merge
+    atomic<size_t> nextFile{0};
+    vector<vector<DecodedFile<Feed>>> buffers(threads);
+    vector<thread> workers;
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            for (size_t i = nextFile++; i < paths.size(); i = nextFile++) {
+                buffers[w].push_back(decode_file<Feed>(i, paths[i], decode));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    vector<DecodedFile<Feed>> files(paths.size());
+    for (auto& buffer : buffers) {
+        for (auto& file : buffer) files[file.index] = std::move(file);
+    }
+    return files;
+}
+
+// First and one-past-last record of each date; a feed's records are grouped by date
+map<string, pair<size_t, size_t>> date_ranges(const DecodedFeed& feed) {
+    map<string, pair<size_t, size_t>> ranges;
+    for (const auto& date : feed.dates) {
+        ranges.emplace(date, make_pair(size_t(0), size_t(0)));
+    }
+    size_t begin = 0;
+    for (size_t i = 1; i <= feed.records.size(); ++i) {
+        if (i == feed.records.size() || feed.records[i].feed_date != feed.records[begin].feed_date) {
+            ranges[feed.records[begin].feed_date] = make_pair(begin, i);
+            begin = i;
+        }
+    }
+    return ranges;
+}
+
+const vector<string>& feed_dates(const DecodedFeed& feed) {
+    return feed.dates;
+}
+
+const vector<string>& feed_dates(const ProjectedCatalog& catalog) {
+    return catalog.dates();
+}
+
+const vector<DecodeError>& feed_malformed(const DecodedFeed& feed) {
+    return feed.malformed;
+}
+
+const vector<DecodeError>& feed_malformed(const ProjectedCatalog& catalog) {
+    return catalog.malformed();
+}
+
+// Function to tally the decoded files into the report and pick the file that supplies each date:
+// the first one in path order. Maps each date to its file and its position in that file's dates.
+template<typename Feed>
+map<string, pair<size_t, size_t>> choose_sources(const vector<string>& paths, const vector<DecodedFile<Feed>>& files,
+                                                 IngestReport& report) {
+    LatencyRecorder latency(max<size_t>(1, paths.size()));
+    map<string, pair<size_t, size_t>> sourceOf;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const DecodedFile<Feed>& file = files[i];
+        latency.record(file.ms);
+        report.file_max_ms = max(report.file_max_ms, file.ms);
+        if (!file.error.empty()) {
+            report.failures.push_back({paths[i], file.error});
+            continue;
+        }
+        ++report.files;
+        report.bytes += file.bytes;
+        for (const auto& error : feed_malformed(file.feed)) {
+            report.malformed.push_back({paths[i], error});
+        }
+        const vector<string>& dates = feed_dates(file.feed);
+        for (size_t d = 0; d < dates.size(); ++d) {
+            if (!sourceOf.emplace(dates[d], make_pair(i, d)).second) ++report.duplicate_days;
+        }
+    }
+    report.file_p50_ms = latency.percentile(0.50);
+    report.file_p95_ms = latency.percentile(0.95);
+    return sourceOf;
+}
+
+size_t worker_count(const IngestOptions& options, size_t files) {
+    size_t threads = options.threads > 0 ? options.threads : max(1u, thread::hardware_concurrency());
+    return max<size_t>(1, min(threads, files));
+}
+
+} // namespace
+
+vector<string> expand_feed_paths(const string& pattern) {
+    fs::path target(pattern);
+    fs::path directory;
+    string mask;
+    error_code ec;
+    if (fs::is_directory(target, ec)) {
+        directory = target;
+        mask = "*.json";
+    } else {
+        directory = target.has_parent_path() ? target.parent_path() : fs::path(".");
+        mask = target.filename().string();
+        if (mask.find_first_of("*?") == string::npos) {
+            return fs::is_regular_file(target, ec) ? vector<string>{pattern} : vector<string>{};
+        }
+    }
+
+    vector<string> paths;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && wildcard_match(it->path().filename().string(), mask)) {
+            paths.push_back(it->path().string());
+        }
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+DecodedFeed ingest_feed_files(const vector<string>& paths, const IngestOptions& options, IngestReport& report) {
+    report = IngestReport();
+    report.threads = worker_count(options, paths.size());
+    Clock::time_point started = Clock::now();
+    auto files = decode_files<DecodedFeed>(paths, report.threads, [](string_view body) { return decode_feed(body); });
+    auto sourceOf = choose_sources(paths, files, report);
+
+    // ISO dates sort chronologically, so map order is date order
+    vector<map<string, pair<size_t, size_t>>> ranges(paths.size());
+    DecodedFeed catalog;
+    for (const auto& [date, source] : sourceOf) {
+        DecodedFeed& feed = files[source.first].feed;
+        if (ranges[source.first].empty()) ranges[source.first] = date_ranges(feed);
+        const auto& [begin, end] = ranges[source.first][date];
+        catalog.dates.push_back(date);
+        for (size_t r = begin; r < end; ++r) {
+            catalog.records.push_back(std::move(feed.records[r]));
+        }
+    }
+    catalog.element_count = static_cast<int64_t>(catalog.records.size());
+
+    report.records = catalog.records.size();
+    report.days = catalog.dates.size();
+    report.wall_ms = chrono::duration<double, milli>(Clock::now() - started).count();
+    return catalog;
+}
+
+ProjectedCatalog ingest_projected_files(const vector<string>& paths, const IngestOptions& options,
+                                        const ProjectionOptions& projection, IngestReport& report) {
+    report = IngestReport();
+    report.threads = worker_count(options, paths.size());
+    Clock::time_point started = Clock::now();
+    auto files = decode_files<ProjectedCatalog>(paths, report.threads, [&projection](string_view body) {
+        ProjectedCatalog catalog(projection);
+        catalog.add_feed(body);
+        return catalog;
+    });
+    auto sourceOf = choose_sources(paths, files, report);
+
+    ProjectedCatalog catalog(projection);
+    for (const auto& [date, source] : sourceOf) {
+        catalog.append_day(files[source.first].feed, source.second);
+    }
+
+    report.records = catalog.size();
+    report.days = catalog.dates().size();
+    report.wall_ms = chrono::duration<double, milli>(Clock::now() - started).count();
+    return catalog;
+}
+
+string format_ingest_report(const IngestReport& report) {
+    ostringstream out;
+    double seconds = max(report.wall_ms, 1e-3) / 1000.0;
+    out << fixed << setprecision(1);
+    out << "Ingested " << report.files << " files (" << setprecision(2) << report.bytes / 1e6 << " MB) on "
+        << report.threads << " threads in " << setprecision(1) << report.wall_ms << " ms: " << report.files / seconds
+        << " files/s, " << report.bytes / 1e6 / seconds << " MB/s" << endl;
+    out << setprecision(2) << "Per-file parse latency: p50 " << report.file_p50_ms << " ms, p95 " << report.file_p95_ms
+        << " ms, max " << report.file_max_ms << " ms" << endl;
+    out << report.records << " records over " << report.days << " days";
+    if (report.duplicate_days > 0) {
+        out << " (" << report.duplicate_days << " duplicate days taken from the earlier file)";
+    }
+    out << "." << endl;
+    for (const auto& failure : report.failures) {
+        out << "Skipped " << failure.path << ": " << failure.error << endl;
+    }
+    if (!report.malformed.empty()) {
+        out << "Skipped " << report.malformed.size() << " malformed records";
+        if (report.malformed.size() > MALFORMED_SHOWN) out << ", the first " << MALFORMED_SHOWN;
+        out << ":" << endl;
+        for (size_t i = 0; i < report.malformed.size() && i < MALFORMED_SHOWN; ++i) {
+            out << "  " << report.malformed[i].path << ": " << describe(report.malformed[i].error) << endl;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,64 @@
+#ifndef FEED_INGEST_H
+#define FEED_INGEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "feed_decoder.h"
+#include "neo_projection.h"
+
+// How a bulk ingest runs
+struct IngestOptions {
+    size_t threads = 0;            // 0: one per hardware thread
+};
+
+// A file that could not be read or decoded; the ingest carries on without it
+struct IngestFailure {
+    std::string path;
+    std::string error;
+};
+
+// A record left out of the catalog because a field was missing or not of its type
+struct IngestMalformed {
+    std::string path;              // file the record is in
+    DecodeError error;
+};
+
+// What one ingest did and how fast
+struct IngestReport {
+    size_t threads = 0;
+    size_t files = 0;              // files decoded successfully
+    uint64_t bytes = 0;            // size of those files
+    size_t records = 0;            // records in the merged catalog
+    size_t days = 0;               // dates in the merged catalog
+    size_t duplicate_days = 0;     // days already supplied by an earlier file, dropped
+    double wall_ms = 0.0;
+    double file_p50_ms = 0.0;      // per-file map + decode latency
+    double file_p95_ms = 0.0;
+    double file_max_ms = 0.0;
+    std::vector<IngestFailure> failures;
+    std::vector<IngestMalformed> malformed;   // skipped records of the decoded files
+};
+
+// Files named by a directory (every *.json in it) or a wildcard pattern in the last path
+// component (e.g. archive/feed-2023-*.json), sorted by path
+std::vector<std::string> expand_feed_paths(const std::string& pattern);
+
+// Decodes the files on a pool of worker threads. Each worker keeps the feeds it decoded in its
+// own buffer; afterwards they are merged into one catalog ordered by date. A date that appears
+// in several files is taken from the first of them in path order, so the result does not
+// depend on thread timing.
+DecodedFeed ingest_feed_files(const std::vector<std::string>& paths, const IngestOptions& options,
+                              IngestReport& report);
+
+// Same ingest into a projected catalog: each worker keeps only the configured fields of its
+// files, so memory follows the projection rather than the feed
+ProjectedCatalog ingest_projected_files(const std::vector<std::string>& paths, const IngestOptions& options,
+                                        const ProjectionOptions& projection, IngestReport& report);
+
+// Renders throughput (files/s, MB/s), latency percentiles, failures and the first few skipped
+// records
+std::string format_ingest_report(const IngestReport& report);
+
+#endif // FEED_INGEST_H
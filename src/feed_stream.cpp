@@ -0,0 +1,536 @@
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include "feed_stream.h"
+#include "fast_number.h"
+
+using namespace std;
+
+namespace {
+
+bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+// Checks the JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool is_valid_number(string_view text) {
+    size_t i = 0, n = text.size();
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < n && text[i] >= '0' && text[i] <= '9') ++i;
+        return i > start;
+    };
+    if (i < n && text[i] == '-') ++i;
+    if (i < n && text[i] == '0') {
+        ++i;
+    } else if (!digits()) {
+        return false;
+    }
+    if (i < n && text[i] == '.') {
+        ++i;
+        if (!digits()) return false;
+    }
+    if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        if (i < n && (text[i] == '+' || text[i] == '-')) ++i;
+        if (!digits()) return false;
+    }
+    return i == n;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// JsonPushParser
+
+JsonPushParser::JsonPushParser(JsonEventHandler& handler) : handler_(handler) {}
+
+void JsonPushParser::fail(const string& msg, const char* p) const {
+    size_t position = offset_ + (p && chunkStart_ ? static_cast<size_t>(p - chunkStart_) : 0);
+    throw JsonStreamError(msg, position);
+}
+
+void JsonPushParser::value_finished() {
+    state_ = containers_.empty() ? State::Done : State::AfterValue;
+}
+
+void JsonPushParser::close_container(const char* p) {
+    char c = *p;
+    char expected = c == '}' ? '{' : '[';
+    if (containers_.empty() || containers_.back() != expected) {
+        fail(string("Unexpected '") + c + "'", p);
+    }
+    containers_.pop_back();
+    tokenStart_ = offset_ + static_cast<size_t>(p - chunkStart_);
+    if (c == '}') {
+        handler_.end_object();
+    } else {
+        handler_.end_array();
+    }
+    value_finished();
+}
+
+void JsonPushParser::emit_string(string_view text) {
+    if (stringIsKey_) {
+        handler_.key(text);
+        state_ = State::Colon;
+    } else {
+        handler_.string_value(text);
+        value_finished();
+    }
+}
+
+void JsonPushParser::emit_number(string_view text) {
+    if (!is_valid_number(text)) {
+        throw JsonStreamError("Invalid number '" + string(text) + "'", tokenStart_);
+    }
+    handler_.number_value(text);
+    value_finished();
+}
+
+void JsonPushParser::emit_literal() {
+    if (token_ == "true") {
+        handler_.boolean_value(true);
+    } else if (token_ == "false") {
+        handler_.boolean_value(false);
+    } else if (token_ == "null") {
+        handler_.null_value();
+    } else {
+        throw JsonStreamError("Invalid literal '" + token_ + "'", tokenStart_);
+    }
+    token_.clear();
+    value_finished();
+}
+
+void JsonPushParser::append_unicode_escape() {
+    unsigned cp = unicodeValue_;
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        highSurrogate_ = cp;   // wait for the low half
+        return;
+    }
+    if (cp >= 0xDC00 && cp <= 0xDFFF && highSurrogate_) {
+        cp = 0x10000 + ((highSurrogate_ - 0xD800) << 10) + (cp - 0xDC00);
+    }
+    highSurrogate_ = 0;
+    append_utf8(token_, cp);
+}
+
+// Function to scan string contents; returns false when the chunk ends inside the string
+bool JsonPushParser::scan_string(const char*& p, const char* end) {
+    // Fast path: nothing carried over and the whole string sits in this chunk without escapes
+    if (token_.empty() && !inEscape_ && unicodeDigits_ < 0) {
+        const char* q = p;
+        while (q < end && *q != '"' && *q != '\\' && static_cast<unsigned char>(*q) >= 0x20) ++q;
+        if (q < end && *q == '"') {
+            const char* start = p;
+            p = q + 1;
+            emit_string(string_view(start, static_cast<size_t>(q - start)));
+            return true;
+        }
+        token_.append(p, q);
+        p = q;
+    }
+
+    while (p < end) {
+        char c = *p++;
+        if (unicodeDigits_ >= 0) {
+            unsigned digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else fail("Invalid \\u escape", p - 1);
+            unicodeValue_ = unicodeValue_ * 16 + digit;
+            if (++unicodeDigits_ == 4) {
+                append_unicode_escape();
+                unicodeDigits_ = -1;
+            }
+            continue;
+        }
+        if (inEscape_) {
+            inEscape_ = false;
+            switch (c) {
+                case '"': token_ += '"'; break;
+                case '\\': token_ += '\\'; break;
+                case '/': token_ += '/'; break;
+                case 'b': token_ += '\b'; break;
+                case 'f': token_ += '\f'; break;
+                case 'n': token_ += '\n'; break;
+                case 'r': token_ += '\r'; break;
+                case 't': token_ += '\t'; break;
+                case 'u': unicodeDigits_ = 0; unicodeValue_ = 0; break;
+                default: fail("Invalid escape sequence", p - 1);
+            }
+            continue;
+        }
+        if (c == '\\') {
+            inEscape_ = true;
+        } else if (c == '"') {
+            string text;
+            text.swap(token_);
+            emit_string(text);
+            return true;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fail("Control character in string", p - 1);
+        } else {
+            const char* run = p - 1;
+            while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) ++p;
+            token_.append(run, p);
+        }
+    }
+    return false;
+}
+
+// Function to scan a number; returns false when the chunk ends inside the number
+bool JsonPushParser::scan_number(const char*& p, const char* end) {
+    const char* start = p;
+    while (p < end && is_number_char(*p)) ++p;
+    if (p == end) {
+        token_.append(start, p);
+        return false;
+    }
+    if (token_.empty()) {
+        emit_number(string_view(start, static_cast<size_t>(p - start)));
+    } else {
+        token_.append(start, p);
+        string text;
+        text.swap(token_);
+        emit_number(text);
+    }
+    return true;
+}
+
+void JsonPushParser::feed(const char* data, size_t size) {
+    chunkStart_ = data;
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p < end) {
+        switch (state_) {
+            case State::String:
+                scan_string(p, end);
+                continue;
+            case State::Number:
+                scan_number(p, end);
+                continue;
+            case State::Literal:
+                while (p < end && *p >= 'a' && *p <= 'z') token_ += *p++;
+                if (p < end) emit_literal();
+                continue;
+            default:
+                break;
+        }
+
+        char c = *p;
+        if (is_whitespace(c)) {
+            ++p;
+            continue;
+        }
+
+        switch (state_) {
+            case State::Value:
+            case State::FirstValueOrEnd:
+                if (c == ']' && state_ == State::FirstValueOrEnd) {
+                    close_container(p);
+                    ++p;
+                } else if (c == '{') {
+                    tokenStart_ = offset_ + static_cast<size_t>(p - chunkStart_);
+                    containers_.push_back('{');
+                    handler_.start_object();
+                    state_ = State::KeyOrEnd;
+                    ++p;
+                } else if (c == '[') {
+                    tokenStart_ = offset_ + static_cast<size_t>(p - chunkStart_);
+                    containers_.push_back('[');
+                    handler_.start_array();
+                    state_ = State::FirstValueOrEnd;
+                    ++p;
+                } else if (c == '"') {
+                    stringIsKey_ = false;
+                    state_ = State::String;
+                    ++p;
+                    tokenStart_ = offset_ + static_cast<size_t>(p - chunkStart_);
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    state_ = State::Number;
+                    tokenStart_ = offset_ + static_cast<size_t>(p - chunkStart_);
+                } else if (c == 't' || c == 'f' || c == 'n') {
+                    state_ = State::Literal;
+                    tokenStart_ = offset_ + static_cast<size_t>(p - chunkStart_);
+                } else {
+                    fail(string("Unexpected character '") + c + "'", p);
+                }
+                break;
+            case State::KeyOrEnd:
+            case State::Key:
+                if (c == '}' && state_ == State::KeyOrEnd) {
+                    close_container(p);
+                } else if (c == '"') {
+                    stringIsKey_ = true;
+                    state_ = State::String;
+                } else {
+                    fail("Expected object key", p);
+                }
+                ++p;
+                break;
+            case State::Colon:
+                if (c != ':') fail("Expected ':'", p);
+                state_ = State::Value;
+                ++p;
+                break;
+            case State::AfterValue:
+                if (c == ',') {
+                    state_ = containers_.back() == '{' ? State::Key : State::Value;
+                } else if (c == '}' || c == ']') {
+                    close_container(p);
+                } else {
+                    fail("Expected ',' or end of container", p);
+                }
+                ++p;
+                break;
+            case State::Done:
+                fail("Unexpected data after end of document", p);
+            default:
+                break;
+        }
+    }
+    offset_ += size;
+    chunkStart_ = nullptr;
+}
+
+void JsonPushParser::finish() {
+    if (state_ == State::Number && !token_.empty()) {
+        string text;
+        text.swap(token_);
+        emit_number(text);
+    } else if (state_ == State::Literal) {
+        emit_literal();
+    }
+    if (state_ != State::Done) {
+        throw JsonStreamError("Unexpected end of input", offset_);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// NeoRecordBuilder
+
+NeoRecordBuilder::NeoRecordBuilder(RecordSink sink) : sink_(std::move(sink)) {}
+
+size_t NeoRecordBuilder::next_position() {
+    if (!frames_.empty() && frames_.back().isArray) {
+        return frames_.back().nextIndex++;
+    }
+    return 0;
+}
+
+void NeoRecordBuilder::open(bool isArray) {
+    size_t position = next_position();
+    bool inArray = !frames_.empty() && frames_.back().isArray;
+    frames_.push_back({isArray, inArray ? string() : pendingKey_, position, 0});
+}
+
+bool NeoRecordBuilder::in_feed_map() const {
+    return frames_.size() == 2 && frames_[1].key == "near_earth_objects" && !frames_[1].isArray;
+}
+
+void NeoRecordBuilder::start_object() {
+    // A record is an object inside near_earth_objects[date]: root / map / date array / record
+    bool startsRecord = !in_record() && frames_.size() == 3 && frames_[1].key == "near_earth_objects" &&
+                        !frames_[1].isArray && frames_[2].isArray;
+    open(false);
+    if (startsRecord) {
+        ++days_.back().objects;
+        recordDepth_ = frames_.size();
+        current_ = NeoRecord();
+        current_.feed_date = frames_[2].key;
+        recordStart_ = parser_ ? parser_->value_offset() : 0;
+        recordFailed_ = false;
+    }
+}
+
+void NeoRecordBuilder::end_object() {
+    if (in_record() && frames_.size() == recordDepth_) {
+        recordDepth_ = 0;
+        if (!recordFailed_ && current_.id.empty()) {
+            recordFailed_ = true;
+            recordError_ = DecodeError{recordStart_, "id", "Missing id"};
+        }
+        if (recordFailed_) {
+            malformed_.push_back(std::move(recordError_));
+        } else {
+            ++emitted_;
+            sink_(std::move(current_));
+        }
+    }
+    frames_.pop_back();
+}
+
+// Function to remember the first bad value of the current record, with the path to it
+void NeoRecordBuilder::field_error(const char* message) {
+    if (recordFailed_) return;
+    recordFailed_ = true;
+    string path;
+    for (size_t i = recordDepth_; i < frames_.size(); ++i) {
+        path += frames_[i - 1].isArray ? to_string(frames_[i].position) : frames_[i].key;
+        path += '.';
+    }
+    recordError_.path = path + pendingKey_;
+    recordError_.offset = parser_ ? parser_->value_offset() : 0;
+    recordError_.message = message;
+}
+
+void NeoRecordBuilder::assign_number(double& out, string_view text) {
+    if (!parse_decimal(text, out)) field_error("Invalid number");
+}
+
+void NeoRecordBuilder::start_array() {
+    if (in_feed_map()) {
+        days_.push_back({pendingKey_, parser_ ? parser_->value_offset() : 0, 0, 0});
+    }
+    open(true);
+}
+
+void NeoRecordBuilder::end_array() {
+    frames_.pop_back();
+    if (in_feed_map()) {
+        days_.back().end = parser_ ? parser_->value_offset() + 1 : 0;
+    }
+}
+
+void NeoRecordBuilder::key(string_view name) {
+    pendingKey_.assign(name.data(), name.size());
+}
+
+void NeoRecordBuilder::string_value(string_view value) {
+    next_position();
+    if (in_record()) assign(value, true);
+}
+
+void NeoRecordBuilder::number_value(string_view raw) {
+    next_position();
+    if (in_record()) assign(raw, false);
+}
+
+void NeoRecordBuilder::boolean_value(bool value) {
+    next_position();
+    if (in_record()) assign_flag(value);
+}
+
+void NeoRecordBuilder::null_value() {
+    next_position();
+}
+
+void NeoRecordBuilder::assign_text(string& out, string_view text, bool isString) {
+    if (isString) out.assign(text);
+    else field_error("Expected a string");
+}
+
+void NeoRecordBuilder::assign_date(Date& out, string_view text, bool isString) {
+    if (!isString) field_error("Expected a date");
+    else if (!parse_date(text, out)) field_error("Invalid date");
+}
+
+// Function to route a scalar inside the current record to its typed field
+void NeoRecordBuilder::assign(string_view text, bool isString) {
+    const string& field = pendingKey_;
+    size_t depth = frames_.size() - recordDepth_;   // containers opened inside the record
+
+    if (depth == 0) {
+        if (field == "id") assign_text(current_.id, text, isString);
+        else if (field == "name") assign_text(current_.name, text, isString);
+        else if (field == "nasa_jpl_url") assign_text(current_.nasa_jpl_url, text, isString);
+        else if (field == "absolute_magnitude_h") assign_number(current_.absolute_magnitude_h, text);
+        else if (field == "is_potentially_hazardous_asteroid" || field == "is_sentry_object") {
+            field_error("Expected true or false");
+        }
+        return;
+    }
+
+    const Frame& outer = frames_[recordDepth_];
+    if (outer.key == "estimated_diameter" && depth == 2) {
+        const string& unit = frames_[recordDepth_ + 1].key;
+        bool isMin = field == "estimated_diameter_min";
+        if (!isMin && field != "estimated_diameter_max") return;
+        if (unit == "kilometers") assign_number(isMin ? current_.diameter_km_min : current_.diameter_km_max, text);
+        else if (unit == "meters") assign_number(isMin ? current_.diameter_m_min : current_.diameter_m_max, text);
+        return;
+    }
+
+    // Only the first close approach is kept, matching the rest of the program
+    if (outer.key != "close_approach_data" || !outer.isArray || depth < 2 ||
+        frames_[recordDepth_ + 1].position != 0) {
+        return;
+    }
+    CloseApproach& approach = current_.approach;
+    if (depth == 2) {
+        if (field == "close_approach_date") assign_date(approach.date, text, isString);
+        else if (field == "close_approach_date_full") assign_text(approach.date_full, text, isString);
+        else if (field == "epoch_date_close_approach" && !parse_feed_integer(text, approach.epoch_ms)) {
+            field_error("Invalid integer");
+        }
+        else if (field == "orbiting_body") assign_text(approach.orbiting_body, text, isString);
+    } else if (depth == 3) {
+        const string& group = frames_[recordDepth_ + 2].key;
+        if (group == "relative_velocity") {
+            if (field == "kilometers_per_second") assign_number(approach.velocity_km_s, text);
+            else if (field == "kilometers_per_hour") assign_number(approach.velocity_km_h, text);
+        } else if (group == "miss_distance") {
+            if (field == "astronomical") assign_number(approach.miss_au, text);
+            else if (field == "lunar") assign_number(approach.miss_lunar, text);
+            else if (field == "kilometers") assign_number(approach.miss_km, text);
+            else if (field == "miles") assign_number(approach.miss_miles, text);
+        }
+    }
+}
+
+void NeoRecordBuilder::assign_flag(bool value) {
+    if (frames_.size() != recordDepth_) return;
+    if (pendingKey_ == "is_potentially_hazardous_asteroid") current_.is_potentially_hazardous = value;
+    else if (pendingKey_ == "is_sentry_object") current_.is_sentry_object = value;
+}
+
+void append_utf8(string& out, unsigned cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool parse_feed_integer(string_view text, int64_t& value) {
+    int64_t parsed = 0;
+    auto result = from_chars(text.data(), text.data() + text.size(), parsed);
+    if (result.ec != errc() || result.ptr != text.data() + text.size()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+int64_t parse_feed_integer(string_view text) {
+    int64_t value = 0;
+    if (!parse_feed_integer(text, value)) {
+        throw invalid_argument("Invalid integer in feed: " + string(text));
+    }
+    return value;
+}
+
+double parse_feed_number(string_view text) {
+    double value = 0.0;
+    if (!parse_decimal(text, value)) {
+        throw invalid_argument("Invalid number in feed: " + string(text));
+    }
+    return value;
+}
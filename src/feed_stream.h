@@ -0,0 +1,190 @@
+#ifndef FEED_STREAM_H
+#define FEED_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decode_result.h"
+#include "neo_record.h"
+
+// Thrown when streamed JSON is malformed; offset is the byte position in the whole stream
+class JsonStreamError : public std::runtime_error {
+public:
+    JsonStreamError(const std::string& msg, size_t offset)
+        : std::runtime_error(msg + " at byte " + std::to_string(offset)), offset_(offset) {}
+    size_t offset() const { return offset_; }
+private:
+    size_t offset_;
+};
+
+// SAX-style receiver for JsonPushParser. String views are only valid during the call.
+// Numbers are passed as their raw text so the receiver decides how to convert them.
+class JsonEventHandler {
+public:
+    virtual ~JsonEventHandler() = default;
+    virtual void start_object() = 0;
+    virtual void end_object() = 0;
+    virtual void start_array() = 0;
+    virtual void end_array() = 0;
+    virtual void key(std::string_view name) = 0;
+    virtual void string_value(std::string_view value) = 0;
+    virtual void number_value(std::string_view raw) = 0;
+    virtual void boolean_value(bool value) = 0;
+    virtual void null_value() = 0;
+};
+
+// Incremental JSON parser: accepts the document in arbitrary chunks (e.g. straight from a cURL
+// write callback) and emits events as soon as each token is complete. Tokens split across
+// chunks are buffered; everything else is reported as views into the chunk.
+class JsonPushParser {
+public:
+    explicit JsonPushParser(JsonEventHandler& handler);
+
+    // Consumes the next chunk; throws JsonStreamError on malformed input
+    void feed(const char* data, size_t size);
+
+    // Signals end of input; throws if the document is incomplete
+    void finish();
+
+    size_t bytes_consumed() const { return offset_; }
+
+    // Stream offset where the value being reported starts (a string's contents, a number, a literal,
+    // or a container's '{' or '['), or of the closing '}' or ']' in end_object/end_array; valid
+    // during the event
+    size_t value_offset() const { return tokenStart_; }
+
+private:
+    enum class State { Value, FirstValueOrEnd, KeyOrEnd, Key, Colon, AfterValue, String, Number, Literal, Done };
+
+    void value_finished();
+    void close_container(const char* p);
+    bool scan_string(const char*& p, const char* end);
+    bool scan_number(const char*& p, const char* end);
+    void emit_string(std::string_view text);
+    void emit_number(std::string_view text);
+    void emit_literal();
+    void append_unicode_escape();
+    [[noreturn]] void fail(const std::string& msg, const char* p) const;
+
+    JsonEventHandler& handler_;
+    State state_ = State::Value;
+    std::vector<char> containers_;   // '{' or '[' for every open container
+    std::string token_;              // partial token carried over between chunks
+    bool stringIsKey_ = false;
+    bool inEscape_ = false;
+    int unicodeDigits_ = -1;         // >= 0 while reading the hex digits of \uXXXX
+    unsigned unicodeValue_ = 0;
+    unsigned highSurrogate_ = 0;
+    size_t offset_ = 0;              // bytes consumed before the current chunk
+    size_t tokenStart_ = 0;          // stream offset of the value token being read
+    const char* chunkStart_ = nullptr;
+};
+
+// One date of near_earth_objects as it appeared in the stream: the offsets of its array's '['
+// and just past its ']', and how many objects the array held (malformed ones included)
+struct FeedDaySpan {
+    std::string date;
+    size_t begin = 0;
+    size_t end = 0;
+    size_t objects = 0;
+};
+
+// Builds typed NEO records from feed events and hands each one over as soon as its object in
+// near_earth_objects[date] closes, so no DOM is ever materialized. A record with a missing id
+// or a number field that does not hold a number is not handed over; it is listed in malformed()
+// with the offset and path of the first bad value, and the stream carries on.
+class NeoRecordBuilder : public JsonEventHandler {
+public:
+    using RecordSink = std::function<void(NeoRecord&&)>;
+
+    explicit NeoRecordBuilder(RecordSink sink);
+
+    void start_object() override;
+    void end_object() override;
+    void start_array() override;
+    void end_array() override;
+    void key(std::string_view name) override;
+    void string_value(std::string_view value) override;
+    void number_value(std::string_view raw) override;
+    void boolean_value(bool value) override;
+    void null_value() override;
+
+    size_t records_emitted() const { return emitted_; }
+    const std::vector<DecodeError>& malformed() const { return malformed_; }
+
+    // Every date seen so far, in document order; offsets need track_offsets()
+    const std::vector<FeedDaySpan>& days() const { return days_; }
+
+    // Takes value offsets for malformed() from the parser feeding this builder
+    void track_offsets(const JsonPushParser& parser) { parser_ = &parser; }
+
+private:
+    struct Frame {
+        bool isArray;
+        std::string key;     // key the container was opened under ("" for array elements)
+        size_t position;     // index inside the parent array (0 inside objects)
+        size_t nextIndex;    // index the next element will get, for arrays
+    };
+
+    void open(bool isArray);
+    bool in_record() const { return recordDepth_ != 0; }
+    bool in_feed_map() const;
+    size_t next_position();
+    void assign(std::string_view text, bool isString);
+    void assign_flag(bool value);
+    void assign_text(std::string& out, std::string_view text, bool isString);
+    void assign_number(double& out, std::string_view text);
+    void assign_date(Date& out, std::string_view text, bool isString);
+    void field_error(const char* message);
+
+    RecordSink sink_;
+    std::vector<Frame> frames_;
+    std::string pendingKey_;
+    size_t recordDepth_ = 0;   // frames_.size() of the record object while one is open
+    NeoRecord current_;
+    size_t emitted_ = 0;
+    const JsonPushParser* parser_ = nullptr;
+    size_t recordStart_ = 0;         // offset of the current record's '{'
+    bool recordFailed_ = false;
+    DecodeError recordError_;        // first bad value of the current record
+    std::vector<DecodeError> malformed_;
+    std::vector<FeedDaySpan> days_;
+};
+
+// Push parser and record builder wired together: feed chunks in, records come out
+class FeedStreamParser {
+public:
+    explicit FeedStreamParser(NeoRecordBuilder::RecordSink sink) : builder_(std::move(sink)), parser_(builder_) {
+        builder_.track_offsets(parser_);
+    }
+
+    void feed(const char* data, size_t size) { parser_.feed(data, size); }
+    void finish() { parser_.finish(); }
+
+    size_t records_emitted() const { return builder_.records_emitted(); }
+    size_t bytes_consumed() const { return parser_.bytes_consumed(); }
+    const std::vector<DecodeError>& malformed() const { return builder_.malformed(); }
+    const std::vector<FeedDaySpan>& days() const { return builder_.days(); }
+
+private:
+    NeoRecordBuilder builder_;
+    JsonPushParser parser_;
+};
+
+// Converts a JSON number or numeric string (NeoWs encodes most numbers as strings) to double
+double parse_feed_number(std::string_view text);
+
+// Converts an integral JSON number (e.g. epoch_date_close_approach); throws on anything else
+int64_t parse_feed_integer(std::string_view text);
+
+// The same without throwing: false (and value untouched) when text is not an integer
+bool parse_feed_integer(std::string_view text, int64_t& value);
+
+// Appends the UTF-8 encoding of a code point, for decoding \uXXXX escapes
+void append_utf8(std::string& out, unsigned cp);
+
+#endif // FEED_STREAM_H
@@ -1,33 +1,13 @@
 #include <iostream>
 #include <fstream>
-#include <curl/curl.h>
 #include <cstdlib>
 #include "get_data.h"
+#include "mapped_file.h"
+#include "neo_fetcher.h"
 #include <exception>
 
 using namespace std;
 
-// Custom Exceptions for file not found and API request errors
-class FileNotFoundException : public std::exception {
-private:
-    std::string message_;
-public:
-    FileNotFoundException(const std::string& msg) : message_(msg) {}
-    const char* what() const noexcept override {
-        return message_.c_str();
-    }
-};
-
-class ApiRequestException : public std::exception {
-private:
-    std::string message_;
-public:
-    ApiRequestException(const std::string& msg) : message_(msg) {}
-    const char* what() const noexcept override {
-        return message_.c_str();
-    }
-};
-
 // Function to load environment variables from a file
 void loadEnvFile(const string& filename) {
     ifstream file(filename);
@@ -59,109 +39,116 @@ size_t WriteCallback(void* contents, size_t size, size_t nmemb, string* s) {
     return totalSize;
 }
 
-// Function to fetch NEO data from NASA API
-string fetch_neo_data(const string& date, const string& apiKey) {
-    CURL* curl;
-    CURLcode res;
-    string neo_data;
-
+// Callback function to hand each received chunk straight to a parser
+size_t StreamWriteCallback(void* contents, size_t size, size_t nmemb, StreamSink* sink) {
+    size_t totalSize = size * nmemb;
     try {
-        curl = curl_easy_init();
-        if (curl) {
-            string baseUrl = "https://api.nasa.gov/neo/rest/v1/feed";
-            string url = baseUrl + "?start_date=" + date + "&end_date=" + date + "&api_key=" + apiKey;
-
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &neo_data);
-
-            res = curl_easy_perform(curl);
-            if (res != CURLE_OK) {
-                throw ApiRequestException("cURL error: " + string(curl_easy_strerror(res)));
-            }
-
-            curl_easy_cleanup(curl);
-        } else {
-            throw ApiRequestException("Failed to initialize cURL");
-        }
-
-    } catch (const ApiRequestException& e) {
-        // Ensure we clean up resources properly
-        if (curl) {
-            curl_easy_cleanup(curl);
-        }
-        // Rethrow the caught exception to the higher level
-        throw;
+        sink->onChunk(static_cast<const char*>(contents), totalSize);
+    } catch (...) {
+        // Exceptions must not cross cURL's C frames: remember it and abort the transfer
+        sink->error = current_exception();
+        return 0;
     }
-
-    return neo_data;
+    return totalSize;
 }
 
+// Function to fetch NEO data from NASA API (pooled handles keep connections warm between calls)
+string fetch_neo_data(const string& date, const string& apiKey) {
+    return shared_fetcher().fetch_feed_day(date, apiKey).body;
+}
 
-// Function to load data from a local JSON file
+// Function to load data from a local JSON file, parsing it straight from a read-only mapping
 bool load_from_file(json& jsonData, const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.open(filename)) {
         throw FileNotFoundException("Could not open file: " + filename);
     }
-
-    try {
-        file >> jsonData;
-    } catch (const exception& e) {
-        file.close();
-        throw;  // Rethrow to allow higher-level handling
-    }
-
-    file.close();
+    string_view contents = file.contents();
+    jsonData = json::parse(contents.begin(), contents.end());
     return true;
 }
 
 // Function to output NEO data (for debugging purposes)
 void output_neo_data(const json& neo) {
-    try {
-        // Extract basic information
-        string id = neo["id"];
-        string name = neo["name"];
-        string nasa_jpl_url = neo["nasa_jpl_url"];
-        double absolute_magnitude = neo["absolute_magnitude_h"];
-
-        cout << "NEO ID: " << id << endl;
-        cout << "Name: " << name << endl;
-        cout << "NASA JPL URL: " << nasa_jpl_url << endl;
-        cout << "Absolute Magnitude (H): " << absolute_magnitude << endl;
-
-        // Extract diameter information
-        auto diameter = neo["estimated_diameter"];
-        cout << "\nEstimated Diameter:" << endl;
-        cout << "Kilometers: " << diameter["kilometers"]["estimated_diameter_min"] << " - "
-             << diameter["kilometers"]["estimated_diameter_max"] << " km" << endl;
-        cout << "Meters: " << diameter["meters"]["estimated_diameter_min"] << " - "
-             << diameter["meters"]["estimated_diameter_max"] << " m" << endl;
-
-        // Check if it's potentially hazardous
-        bool is_potentially_hazardous = neo["is_potentially_hazardous_asteroid"];
-        cout << "\nIs Potentially Hazardous: " << (is_potentially_hazardous ? "Yes" : "No") << endl;
-
-        // Extract close approach data
-        auto close_approach = neo["close_approach_data"][0];  // Get the first close approach data
-        cout << "\nClose Approach Data:" << endl;
-        cout << "Close Approach Date: " << close_approach["close_approach_date"] << endl;
-        cout << "Full Close Approach Date: " << close_approach["close_approach_date_full"] << endl;
-        cout << "Relative Velocity (km/s): " << close_approach["relative_velocity"]["kilometers_per_second"] << " km/s" << endl;
-        cout << "Relative Velocity (km/h): " << close_approach["relative_velocity"]["kilometers_per_hour"] << " km/h" << endl;
-        cout << "Miss Distance (Astronomical): " << close_approach["miss_distance"]["astronomical"] << " au" << endl;
-        cout << "Miss Distance (Lunar): " << close_approach["miss_distance"]["lunar"] << " lunar distances" << endl;
-        cout << "Miss Distance (Kilometers): " << close_approach["miss_distance"]["kilometers"] << " km" << endl;
-        cout << "Miss Distance (Miles): " << close_approach["miss_distance"]["miles"] << " miles" << endl;
-        cout << "Orbiting Body: " << close_approach["orbiting_body"] << endl;
-
-        // Check if it's a Sentry object
-        bool is_sentry_object = neo["is_sentry_object"];
-        cout << "\nIs Sentry Object: " << (is_sentry_object ? "Yes" : "No") << endl;
-
-    } catch (const exception&) {
-        throw;  // Rethrow exception for higher-level handling
-    }
+    // Extract basic information
+    string id = neo["id"];
+    string name = neo["name"];
+    string nasa_jpl_url = neo["nasa_jpl_url"];
+    double absolute_magnitude = neo["absolute_magnitude_h"];
+
+    cout << "NEO ID: " << id << endl;
+    cout << "Name: " << name << endl;
+    cout << "NASA JPL URL: " << nasa_jpl_url << endl;
+    cout << "Absolute Magnitude (H): " << absolute_magnitude << endl;
+
+    // Extract diameter information
+    auto diameter = neo["estimated_diameter"];
+    cout << "\nEstimated Diameter:" << endl;
+    cout << "Kilometers: " << diameter["kilometers"]["estimated_diameter_min"] << " - "
+         << diameter["kilometers"]["estimated_diameter_max"] << " km" << endl;
+    cout << "Meters: " << diameter["meters"]["estimated_diameter_min"] << " - "
+         << diameter["meters"]["estimated_diameter_max"] << " m" << endl;
+
+    // Check if it's potentially hazardous
+    bool is_potentially_hazardous = neo["is_potentially_hazardous_asteroid"];
+    cout << "\nIs Potentially Hazardous: " << (is_potentially_hazardous ? "Yes" : "No") << endl;
+
+    // Extract close approach data
+    auto close_approach = neo["close_approach_data"][0];  // Get the first close approach data
+    cout << "\nClose Approach Data:" << endl;
+    cout << "Close Approach Date: " << close_approach["close_approach_date"] << endl;
+    cout << "Full Close Approach Date: " << close_approach["close_approach_date_full"] << endl;
+    cout << "Relative Velocity (km/s): " << close_approach["relative_velocity"]["kilometers_per_second"] << " km/s" << endl;
+    cout << "Relative Velocity (km/h): " << close_approach["relative_velocity"]["kilometers_per_hour"] << " km/h" << endl;
+    cout << "Miss Distance (Astronomical): " << close_approach["miss_distance"]["astronomical"] << " au" << endl;
+    cout << "Miss Distance (Lunar): " << close_approach["miss_distance"]["lunar"] << " lunar distances" << endl;
+    cout << "Miss Distance (Kilometers): " << close_approach["miss_distance"]["kilometers"] << " km" << endl;
+    cout << "Miss Distance (Miles): " << close_approach["miss_distance"]["miles"] << " miles" << endl;
+    cout << "Orbiting Body: " << close_approach["orbiting_body"] << endl;
+
+    // Check if it's a Sentry object
+    bool is_sentry_object = neo["is_sentry_object"];
+    cout << "\nIs Sentry Object: " << (is_sentry_object ? "Yes" : "No") << endl;
+}
+
+// Function to output a projected NEO exactly as output_neo_data prints it from the feed JSON
+template <typename Catalog>
+void output_projected_neo(const Catalog& catalog, size_t index) {
+    // Quoted values and diameters go through json so they print as the original does
+    auto quoted = [](const string& text) { return json(text).dump(); };
+    cout << "NEO ID: " << catalog.id(index) << endl;
+    cout << "Name: " << catalog.name(index) << endl;
+    cout << "NASA JPL URL: " << catalog.nasa_jpl_url(index) << endl;
+    cout << "Absolute Magnitude (H): " << catalog.absolute_magnitude_h(index) << endl;
+
+    cout << "\nEstimated Diameter:" << endl;
+    cout << "Kilometers: " << json(catalog.diameter_km_min(index)) << " - " << json(catalog.diameter_km_max(index))
+         << " km" << endl;
+    cout << "Meters: " << json(catalog.diameter_m_min(index)) << " - " << json(catalog.diameter_m_max(index))
+         << " m" << endl;
+
+    cout << "\nIs Potentially Hazardous: " << (catalog.is_potentially_hazardous(index) ? "Yes" : "No") << endl;
+
+    cout << "\nClose Approach Data:" << endl;
+    cout << "Close Approach Date: " << quoted(catalog.close_approach_date(index)) << endl;
+    cout << "Full Close Approach Date: " << quoted(catalog.close_approach_date_full(index)) << endl;
+    cout << "Relative Velocity (km/s): " << quoted(catalog.decimal_text(ProjectedCatalog::VELOCITY_KM_S, index)) << " km/s" << endl;
+    cout << "Relative Velocity (km/h): " << quoted(catalog.decimal_text(ProjectedCatalog::VELOCITY_KM_H, index)) << " km/h" << endl;
+    cout << "Miss Distance (Astronomical): " << quoted(catalog.decimal_text(ProjectedCatalog::MISS_AU, index)) << " au" << endl;
+    cout << "Miss Distance (Lunar): " << quoted(catalog.decimal_text(ProjectedCatalog::MISS_LUNAR, index)) << " lunar distances" << endl;
+    cout << "Miss Distance (Kilometers): " << quoted(catalog.decimal_text(ProjectedCatalog::MISS_KM, index)) << " km" << endl;
+    cout << "Miss Distance (Miles): " << quoted(catalog.decimal_text(ProjectedCatalog::MISS_MILES, index)) << " miles" << endl;
+    cout << "Orbiting Body: " << quoted(catalog.orbiting_body(index)) << endl;
+
+    cout << "\nIs Sentry Object: " << (catalog.is_sentry_object(index) ? "Yes" : "No") << endl;
+}
+
+void output_neo_data(const ProjectedCatalog& catalog, size_t index) {
+    output_projected_neo(catalog, index);
+}
+
+void output_neo_data(const CatalogSnapshot& snapshot, size_t index) {
+    output_projected_neo(snapshot, index);
 }
 
 // Function to validate menu choice (3 tries allowed)
@@ -208,4 +195,70 @@ json process_neo_data(const json& jsonData, const string& selectedDate) {
 
     cout << "\nSelect a NEO by number: ";
     return neos[validateMenuChoice(1, neos.size()) - 1]; // Use validateMenuChoice for input validation.
-}
\ No newline at end of file
+}
+
+// Function to list the NEOs of a date, by name, and return the one the user picks
+template <typename Item, typename NameOf, typename ToRecord>
+optional<NeoRecord> select_record(bool hasDate, const vector<Item>& neos, const string& selectedDate, NameOf nameOf,
+                                  ToRecord toRecord) {
+    if (!hasDate) {
+        cout << "No NEO data found for the selected date: " << selectedDate << endl;
+        return nullopt;
+    }
+
+    if (neos.empty()) {
+        cout << "No NEOs found for the selected date: " << selectedDate << endl;
+        return nullopt;
+    }
+
+    cout << "\nThere are " << neos.size() << " NEOs for the date " << selectedDate << ".\n";
+    for (size_t i = 0; i < neos.size(); i++) {
+        // Quoted and escaped the way the JSON listing printed names
+        cout << i + 1 << ". " << json(nameOf(neos[i])).dump() << endl;
+    }
+
+    cout << "\nSelect a NEO by number: ";
+    return toRecord(neos[validateMenuChoice(1, neos.size()) - 1]);
+}
+
+optional<NeoRecord> select_neo_record(const DecodedFeed& feed, const string& selectedDate) {
+    return select_record(has_date(feed, selectedDate), records_for_date(feed, selectedDate), selectedDate,
+                         [](const NeoRecord* record) { return record->name; },
+                         [](const NeoRecord* record) { return *record; });
+}
+
+optional<NeoRecord> select_neo_record(const FeedView& feed, const string& selectedDate) {
+    return select_record(has_date(feed, selectedDate), records_for_date(feed, selectedDate), selectedDate,
+                         [](const NeoRecordView* record) { return string(record->name); },
+                         [](const NeoRecordView* record) { return to_record(*record); });
+}
+
+optional<NeoRecord> select_neo_record(const CatalogSnapshot& snapshot, const string& selectedDate) {
+    // The date is found by binary search over the sorted day numbers; only the chosen object is
+    // read in full
+    Date wanted;
+    vector<size_t> neos;
+    size_t d = parse_date(selectedDate, wanted) ? snapshot.find_date(wanted) : snapshot.date_count();
+    bool hasDate = d < snapshot.date_count();
+    if (hasDate) {
+        for (size_t i = snapshot.date_begin(d); i < snapshot.date_begin(d + 1); ++i) neos.push_back(i);
+    }
+    return select_record(hasDate, neos, selectedDate, [&](size_t index) { return string(snapshot.name(index)); },
+                         [&](size_t index) { return snapshot.record(index); });
+}
+
+optional<NeoRecord> select_neo_record(const FeedIndex& index, const string& selectedDate) {
+    // Only the names are decoded for the listing; the chosen object is decoded in full. A record
+    // that does not decode is reported and nothing is selected, so the caller can ask again.
+    RecordExtractor extractor;
+    return select_record(index.has_date(selectedDate), index.objects(selectedDate), selectedDate,
+                         [](const NeoCursor& cursor) { return cursor.name(); },
+                         [&](const NeoCursor& cursor) -> optional<NeoRecord> {
+                             DecodeResult<NeoRecord> record = extractor.try_extract(cursor);
+                             if (!record) {
+                                 cerr << "Could not decode the selected NEO: " << describe(record.error()) << endl;
+                                 return nullopt;
+                             }
+                             return std::move(record.value());
+                         });
+}
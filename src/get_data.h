@@ -3,6 +3,35 @@
 
 #include "platform_config.h" // Assuming platform-specific configurations
 #include <string>
+#include <exception>
+#include <functional>
+#include <optional>
+#include "catalog_snapshot.h"
+#include "feed_decoder.h"
+#include "feed_index.h"
+#include "neo_projection.h"
+#include "neo_record.h"
+
+// Custom Exceptions for file not found and API request errors
+class FileNotFoundException : public std::exception {
+private:
+    std::string message_;
+public:
+    FileNotFoundException(const std::string& msg) : message_(msg) {}
+    const char* what() const noexcept override {
+        return message_.c_str();
+    }
+};
+
+class ApiRequestException : public std::exception {
+private:
+    std::string message_;
+public:
+    ApiRequestException(const std::string& msg) : message_(msg) {}
+    const char* what() const noexcept override {
+        return message_.c_str();
+    }
+};
 
 // Function declarations
 
@@ -15,14 +44,34 @@ bool load_from_file(nlohmann::json& jsonData, const std::string& filename);
 // Callback for writing API response data into a string
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s);
 
+// Receives API response data chunk by chunk as cURL delivers it
+struct StreamSink {
+    std::function<void(const char*, size_t)> onChunk;
+    std::exception_ptr error;  // set when onChunk throws; the transfer is aborted
+};
+
+// Callback for forwarding API response data to a StreamSink without buffering the body
+size_t StreamWriteCallback(void* contents, size_t size, size_t nmemb, StreamSink* sink);
+
 // Outputs the Near-Earth Object data to the console
 void output_neo_data(const nlohmann::json& neo);
 
+// Same output for an object of a projected catalog; fields the catalog dropped print empty
+void output_neo_data(const ProjectedCatalog& catalog, size_t index);
+void output_neo_data(const CatalogSnapshot& snapshot, size_t index);
+
 // Processes the NEO data for a specific date
 nlohmann::json process_neo_data(const nlohmann::json& jsonData, const std::string& selectedDate);
 
+// Same listing and selection as process_neo_data, over records from decode_feed
+std::optional<NeoRecord> select_neo_record(const DecodedFeed& feed, const std::string& selectedDate);
+std::optional<NeoRecord> select_neo_record(const FeedView& feed, const std::string& selectedDate);
+std::optional<NeoRecord> select_neo_record(const FeedIndex& index, const std::string& selectedDate);
+std::optional<NeoRecord> select_neo_record(const CatalogSnapshot& snapshot, const std::string& selectedDate);
+
 // Fetches NEO data from NASA's API for a specific date
 std::string fetch_neo_data(const std::string& date, const std::string& apiKey);
+
 int validateMenuChoice(int min, int max);
 
 #endif // GET_DATA_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <cmath>
+#include "latency_recorder.h"
+
+using namespace std;
+
+LatencyRecorder::LatencyRecorder(size_t window) : window_(max<size_t>(window, 1)) {
+    samples_.reserve(window_);
+}
+
+void LatencyRecorder::record(double ms) {
+    lock_guard<mutex> lock(mutex_);
+    if (samples_.size() < window_) {
+        samples_.push_back(ms);
+    } else {
+        samples_[next_] = ms;
+        next_ = (next_ + 1) % samples_.size();
+    }
+    ++count_;
+}
+
+// Function to pick the nearest-rank sample for quantile q
+double LatencyRecorder::percentile(double q) const {
+    vector<double> sorted;
+    {
+        lock_guard<mutex> lock(mutex_);
+        sorted = samples_;
+    }
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(ceil(clamp(q, 0.0, 1.0) * sorted.size()));
+    size_t index = rank == 0 ? 0 : rank - 1;
+    nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+uint64_t LatencyRecorder::count() const {
+    lock_guard<mutex> lock(mutex_);
+    return count_;
+}
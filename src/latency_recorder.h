@@ -0,0 +1,30 @@
+#ifndef LATENCY_RECORDER_H
+#define LATENCY_RECORDER_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Keeps the most recent latency samples (milliseconds) in a ring and reports percentiles over
+// them. Safe to use from several threads.
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(size_t window = 1024);
+
+    void record(double ms);
+
+    // Sample at quantile q (0..1) of the current window, or 0 when nothing was recorded
+    double percentile(double q) const;
+
+    // Samples recorded since construction, including ones that left the window
+    uint64_t count() const;
+
+private:
+    size_t window_;
+    mutable std::mutex mutex_;
+    std::vector<double> samples_;
+    size_t next_ = 0;
+    uint64_t count_ = 0;
+};
+
+#endif // LATENCY_RECORDER_H
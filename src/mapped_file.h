@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// A whole file mapped read-only into memory. Pages are read by the OS as they are first
+// touched, so nothing is copied up front and untouched parts of a large file cost nothing.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file, replacing any previous mapping; false when it cannot be opened or mapped
+    bool open(const std::string& path);
+
+    // Unmaps the file; views into contents() become invalid
+    void close();
+
+    // The mapped bytes; empty before open() and for empty files
+    std::string_view contents() const { return std::string_view(data_, size_); }
+    bool is_open() const { return open_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#if defined(_WIN32) || defined(_WIN64)
+    void* mapping_ = nullptr;   // HANDLE of the file mapping object
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include "neo_client.h"
+#include "calendar.h"
+#include "get_data.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+namespace {
+
+// Builds a single-day feed document around one date's array of objects, so a day split out of a
+// wider window caches like a response to a one-day request
+string single_day_document(const string& date, string_view neosText, size_t objects) {
+    string document = "{\"element_count\":" + to_string(objects) + ",\"near_earth_objects\":{\"" + date + "\":";
+    document.append(neosText.data(), neosText.size());
+    document += "}}";
+    return document;
+}
+
+// Fills in a FeedDay from a response whose 200 body went to a StreamedFeed
+FeedDay complete_day(FetchResult response, StreamedFeed& body) {
+    FeedDay day;
+    day.response = std::move(response);
+    if (day.response.status == 200) {
+        body.finish();
+        day.response.body = body.take_text();
+        day.feed = body.take_feed();
+    }
+    day.decoded = true;
+    return day;
+}
+
+// Network latencies needed before their p95 replaces LatencyOptions::initial_hedge_ms
+const uint64_t MIN_HEDGE_SAMPLES = 20;
+
+double elapsed_ms(Clock::time_point since) {
+    return chrono::duration<double, milli>(Clock::now() - since).count();
+}
+
+uint64_t wire_size(const FetchResult& result) {
+    return static_cast<uint64_t>(result.timing.wire_bytes + result.timing.header_bytes);
+}
+
+} // namespace
+
+NeoClient::NeoClient(RequestScheduler& scheduler, ResponseCache& cache, string apiKey, LatencyOptions latency)
+    : scheduler_(scheduler), cache_(cache), apiKey_(std::move(apiKey)), latency_(std::move(latency)) {}
+
+NeoClient::~NeoClient() {
+    // Window fetches still queued are dropped; the ones already running finish storing their page
+    vector<WindowFetch> windows;
+    {
+        lock_guard<mutex> lock(windowsMutex_);
+        for (const auto& [day, window] : pendingDays_) {
+            windows.push_back(window);
+        }
+    }
+    for (auto& window : windows) {
+        scheduler_.cancel(window.url);
+        window.done.wait();
+    }
+    lock_guard<mutex> lock(refreshMutex_);
+    for (auto& refresh : refreshes_) {
+        refresh.wait();
+    }
+}
+
+FetchResult NeoClient::get_feed_day(const string& date, RequestPriority priority) {
+    return lookup(date, priority, false)->response;
+}
+
+shared_ptr<const FeedDay> NeoClient::get_feed_records(const string& date, RequestPriority priority) {
+    shared_ptr<const FeedDay> day = lookup(date, priority, true);
+    if (day->decoded) {
+        return day;
+    }
+    // Joined a get_feed_day call, which left the body undecoded
+    auto decoded = make_shared<FeedDay>(*day);
+    if (decoded->response.status == 200) {
+        decoded->feed = decode_feed(decoded->response.body);
+    }
+    decoded->decoded = true;
+    return decoded;
+}
+
+shared_ptr<const FeedDay> NeoClient::lookup(const string& date, RequestPriority priority, bool decode) {
+    Clock::time_point started = Clock::now();
+    shared_ptr<const FeedDay> day =
+        flights_.run(date, [&] { return make_shared<const FeedDay>(load_feed_day(date, priority, decode)); });
+    if (priority == RequestPriority::Interactive) {
+        lookupLatency_.record(elapsed_ms(started));
+        lock_guard<mutex> lock(statsMutex_);
+        ++lookupStats_.lookups;
+    }
+    return day;
+}
+
+LookupStats NeoClient::lookup_stats() const {
+    LookupStats stats;
+    {
+        lock_guard<mutex> lock(statsMutex_);
+        stats = lookupStats_;
+    }
+    stats.p50_ms = lookupLatency_.percentile(0.50);
+    stats.p99_ms = lookupLatency_.percentile(0.99);
+    stats.hedge_budget_ms = hedge_budget_ms();
+    return stats;
+}
+
+// Function to serve a feed day from the cache, falling back to a scheduled request
+FeedDay NeoClient::load_feed_day(const string& date, RequestPriority priority, bool decode) {
+    FeedDay day;
+    if (load_cached(date, decode, day)) {
+        return day;
+    }
+    // A window fetch covering the date stores it shortly; its failure leaves the lookup to itself
+    if (wait_for_window(date, priority) && load_cached(date, decode, day)) {
+        return day;
+    }
+
+    if (priority == RequestPriority::Interactive) {
+        return fetch_bounded(date);
+    }
+    // Network responses are always parsed, which is what tells an empty day from an error
+    StreamedRequest request = submit_streamed(build_feed_url({date, date}, apiKey_), priority);
+    day = complete_day(request.response.get(), *request.body);
+    store_day(date, day);
+    return day;
+}
+
+// Function to answer a lookup from a remembered empty day or the response cache
+bool NeoClient::load_cached(const string& date, bool decode, FeedDay& day) {
+    string endpoint = neo_feed_base_url();
+    if (cache_.is_negative(endpoint, date)) {
+        day.response.body = single_day_document(date, "[]", 0);
+        day.response.status = 200;
+        day.response.from_cache = true;
+        day.feed.dates.push_back(date);
+        day.decoded = true;
+        return true;
+    }
+    if (decode) {
+        StreamedFeed cached;
+        if (cache_.stream(endpoint, date, [&cached](const char* data, size_t size) { cached.feed(data, size); })) {
+            cached.finish();
+            day.response.body = cached.take_text();
+            day.response.status = 200;
+            day.response.from_cache = true;
+            day.feed = cached.take_feed();
+            day.decoded = true;
+            return true;
+        }
+    } else if (auto cached = cache_.get(endpoint, date)) {
+        day.response.body = std::move(*cached);
+        day.response.status = 200;
+        day.response.from_cache = true;
+        return true;
+    }
+    return false;
+}
+
+// Function to wait for a window fetch that covers date, pulling it ahead of background work for an
+// interactive lookup; false when there is none or it failed
+bool NeoClient::wait_for_window(const string& date, RequestPriority priority) {
+    WindowFetch window;
+    {
+        lock_guard<mutex> lock(windowsMutex_);
+        auto found = pendingDays_.find(date);
+        if (found == pendingDays_.end()) {
+            return false;
+        }
+        window = found->second;
+    }
+    ++windowWaits_;
+    if (priority == RequestPriority::Interactive) {
+        scheduler_.promote(window.url);
+    }
+    try {
+        window.done.get();
+        return true;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+NeoClient::WindowFetch NeoClient::fetch_window(const FeedWindow& window, RequestPriority priority) {
+    vector<string> days;
+    for (Date day : DateRange(parse_date(window.start_date), parse_date(window.end_date))) {
+        days.push_back(format_date(day));
+    }
+    WindowFetch fetch;
+    fetch.url = build_feed_url(window, apiKey_);
+    auto request = make_shared<StreamedRequest>(submit_streamed(fetch.url, priority));
+
+    // The page is stored as soon as it completes, whether or not anyone waits on it
+    fetch.done = async(launch::async, [this, request, window, url = fetch.url, days] {
+        size_t objects = 0;
+        exception_ptr error;
+        try {
+            FetchResult result = request->response.get();
+            if (result.status != 200) {
+                throw ApiRequestException("HTTP " + to_string(result.status) + " for feed window " +
+                                          window.start_date + " to " + window.end_date);
+            }
+            request->body->finish();
+            objects = store_days(*request->body, wire_size(result));
+        } catch (...) {
+            error = current_exception();
+        }
+        forget_window(url, days);
+        if (error) {
+            rethrow_exception(error);
+        }
+        return objects;
+    }).share();
+
+    lock_guard<mutex> lock(windowsMutex_);
+    for (const auto& day : days) {
+        pendingDays_[day] = fetch;
+    }
+    return fetch;
+}
+
+void NeoClient::forget_window(const string& url, const vector<string>& days) {
+    lock_guard<mutex> lock(windowsMutex_);
+    for (const auto& day : days) {
+        auto found = pendingDays_.find(day);
+        if (found != pendingDays_.end() && found->second.url == url) {
+            pendingDays_.erase(found);
+        }
+    }
+}
+
+// Function to answer an interactive cache miss within the latency budget
+FeedDay NeoClient::fetch_bounded(const string& date) {
+    string url = build_feed_url({date, date}, apiKey_);
+    Clock::time_point started = Clock::now();
+    StreamedRequest first = submit_streamed(url, RequestPriority::Interactive, make_shared<CompletionSignal>());
+
+    // Race the request against a local copy; unless the network already answered, the copy wins
+    // and the request carries on in the background to refresh the cache
+    FeedDay local;
+    if (latency_.race_local && local_copy(date, local) &&
+        first.response.wait_for(chrono::seconds(0)) != future_status::ready) {
+        refresh_in_background(date, std::move(first));
+        lock_guard<mutex> lock(statsMutex_);
+        ++lookupStats_.local_wins;
+        return local;
+    }
+
+    FeedDay day = await_hedged(url, std::move(first));
+    networkLatency_.record(elapsed_ms(started));
+    store_day(date, day);
+    return day;
+}
+
+NeoClient::StreamedRequest NeoClient::submit_streamed(const string& url, RequestPriority priority,
+                                                      shared_ptr<CompletionSignal> signal) {
+    auto body = make_shared<StreamedFeed>();
+    function<void()> onDone;
+    if (signal) {
+        onDone = [signal] {
+            // Taking the mutex orders the notification after the waiter's check of the futures
+            { lock_guard<mutex> lock(signal->mutex); }
+            signal->finished.notify_all();
+        };
+    }
+    future<FetchResult> response = scheduler_.submit(
+        url, apiKey_, priority, [body](const char* data, size_t size) { body->feed(data, size); }, std::move(onDone));
+    return {std::move(response), std::move(body), std::move(signal)};
+}
+
+// Function to wait for a request, sending a duplicate once it exceeds the hedge budget, and
+// return whichever copy succeeds first
+FeedDay NeoClient::await_hedged(const string& url, StreamedRequest first) {
+    double budget = hedge_budget_ms();
+    if (budget <= 0 || first.response.wait_for(chrono::duration<double, milli>(budget)) == future_status::ready) {
+        return complete_day(first.response.get(), *first.body);
+    }
+
+    StreamedRequest second = submit_streamed(url, RequestPriority::Interactive, first.signal);
+    {
+        lock_guard<mutex> lock(statsMutex_);
+        ++lookupStats_.hedged;
+    }
+    auto ready = [](const future<FetchResult>& response) {
+        return response.wait_for(chrono::seconds(0)) == future_status::ready;
+    };
+    {
+        unique_lock<mutex> lock(first.signal->mutex);
+        first.signal->finished.wait(lock, [&] { return ready(first.response) || ready(second.response); });
+    }
+
+    // A copy fails when it throws or answers anything but 200 (a 429 the scheduler gave up on, a
+    // 5xx); the other copy then gets its chance, and an error is returned only when both fail
+    auto attempt = [](StreamedRequest& request, FeedDay& day, exception_ptr& error) {
+        try {
+            day = complete_day(request.response.get(), *request.body);
+            return day.response.status == 200;
+        } catch (...) {
+            error = current_exception();
+            return false;
+        }
+    };
+    bool firstReady = ready(first.response);
+    StreamedRequest& earlier = firstReady ? first : second;
+    StreamedRequest& later = firstReady ? second : first;
+    FeedDay earlierDay, laterDay;
+    exception_ptr earlierError, laterError;
+    bool answered = attempt(earlier, earlierDay, earlierError);
+    if (answered || attempt(later, laterDay, laterError)) {
+        // The hedge won when the answer came from the duplicate
+        if (answered != firstReady) {
+            lock_guard<mutex> lock(statsMutex_);
+            ++lookupStats_.hedge_wins;
+        }
+        return std::move(answered ? earlierDay : laterDay);
+    }
+
+    // Both failed: an HTTP status tells the caller more than a transport error
+    if (!laterError) {
+        return laterDay;
+    }
+    if (!earlierError) {
+        return earlierDay;
+    }
+    rethrow_exception(laterError);
+}
+
+// Function to find a local answer for a date: an expired cache entry, or the snapshot file
+bool NeoClient::local_copy(const string& date, FeedDay& result) {
+    if (auto stale = cache_.get_stale(neo_feed_base_url(), date)) {
+        result.response.body = std::move(*stale);
+        result.feed = decode_feed(result.response.body);
+    } else {
+        call_once(snapshotLoaded_, [this] {
+            try {
+                snapshot_.load(latency_.snapshot_path);
+            } catch (const exception&) {
+                // A damaged snapshot is no worse than a missing one
+            }
+        });
+        // Only the requested day's slice of the mapping is parsed
+        string_view dayText = day_text(snapshot_.feed(), date);
+        if (dayText.empty()) {
+            return false;
+        }
+        StreamedFeed day;
+        string prefix = "{\"near_earth_objects\":{\"" + date + "\":";
+        day.feed(prefix.data(), prefix.size());
+        day.feed(dayText.data(), dayText.size());
+        day.feed("}}", 2);
+        day.finish();
+        result.feed = day.take_feed();
+        result.response.body = single_day_document(date, dayText, static_cast<size_t>(result.feed.element_count));
+    }
+    result.response.status = 200;
+    result.response.from_cache = true;
+    result.decoded = true;
+    return true;
+}
+
+void NeoClient::refresh_in_background(const string& date, StreamedRequest pending) {
+    lock_guard<mutex> lock(refreshMutex_);
+    // Forget refreshes that already finished so the list stays short
+    refreshes_.erase(remove_if(refreshes_.begin(), refreshes_.end(),
+                               [](future<void>& refresh) {
+                                   return refresh.wait_for(chrono::seconds(0)) == future_status::ready;
+                               }),
+                     refreshes_.end());
+    refreshes_.push_back(async(launch::async, [this, date, request = std::move(pending)]() mutable {
+        try {
+            store_day(date, complete_day(request.response.get(), *request.body));
+        } catch (const exception&) {
+            // The caller already has its answer; a failed refresh just leaves the old copy in place
+        }
+    }));
+}
+
+// Function to cache a day the API answered; a day it listed with no objects is remembered as empty
+// instead, for the negative TTL
+void NeoClient::store_day(const string& date, const FeedDay& day) {
+    const FetchResult& result = day.response;
+    if (result.status != 200 || result.body.empty()) {
+        return;   // a 403, 429 or 5xx says nothing about the date
+    }
+    if (day.feed.element_count == 0 && has_date(day.feed, date)) {
+        cache_.put_negative(neo_feed_base_url(), date);
+        record_transfer(date, wire_size(result), result.body.size(), 0);
+        return;
+    }
+    size_t diskBytes = cache_.put(neo_feed_base_url(), date, result.body);
+    record_transfer(date, wire_size(result), result.body.size(), diskBytes);
+}
+
+double NeoClient::hedge_budget_ms() const {
+    if (latency_.hedge_after_ms >= 0) {
+        return static_cast<double>(latency_.hedge_after_ms);
+    }
+    if (networkLatency_.count() < MIN_HEDGE_SAMPLES) {
+        return static_cast<double>(latency_.initial_hedge_ms);
+    }
+    return networkLatency_.percentile(0.95);
+}
+
+// Function to pull a date range into the cache without blocking interactive lookups
+size_t NeoClient::backfill(const string& startDate, const string& endDate, int maxConcurrent) {
+    string endpoint = neo_feed_base_url();
+    vector<FeedWindow> missing;
+    for (const auto& window : split_into_windows(startDate, endDate)) {
+        for (const auto& day : split_into_windows(window.start_date, window.end_date, 1)) {
+            if (!cache_.contains(endpoint, day.start_date)) {
+                missing.push_back(window);
+                break;
+            }
+        }
+    }
+
+    vector<string> urls;
+    for (const auto& window : missing) {
+        urls.push_back(build_feed_url(window, apiKey_));
+    }
+    vector<FetchResult> pages = scheduler_.fetch_all(urls, apiKey_, RequestPriority::Background, maxConcurrent);
+
+    // Every page that arrived is stored before a failed window is reported
+    string failure;
+    for (size_t i = 0; i < pages.size(); ++i) {
+        string window = missing[i].start_date + " to " + missing[i].end_date;
+        if (pages[i].status != 200) {
+            if (failure.empty()) failure = "HTTP " + to_string(pages[i].status) + " for feed window " + window;
+            continue;
+        }
+        try {
+            store_page(pages[i]);
+        } catch (const exception& e) {
+            if (failure.empty()) failure = "Feed window " + window + " is not a feed: " + e.what();
+        }
+    }
+    if (!failure.empty()) {
+        throw ApiRequestException(failure);
+    }
+    return missing.size();
+}
+
+size_t NeoClient::store_page(const FetchResult& page) {
+    StreamedFeed streamed;
+    streamed.feed(page.body.data(), page.body.size());
+    streamed.finish();
+    return store_days(streamed, wire_size(page));
+}
+
+// Function to cache every day of a feed page on its own, cutting each date's array out of the
+// page text at the offsets the parser recorded
+size_t NeoClient::store_days(const StreamedFeed& page, uint64_t pageWire) {
+    string endpoint = neo_feed_base_url();
+    string_view text = page.text();
+    size_t objects = 0;
+    vector<pair<string, string>> days;
+    uint64_t totalBytes = 0;
+    for (const auto& span : page.days()) {
+        objects += span.objects;
+        days.emplace_back(span.date, single_day_document(span.date, text.substr(span.begin, span.end - span.begin),
+                                                         span.objects));
+        totalBytes += days.back().second.size();
+    }
+
+    for (const auto& [date, day] : days) {
+        size_t diskBytes = cache_.put(endpoint, date, day);
+        uint64_t wireShare = totalBytes == 0 ? 0 : pageWire * day.size() / totalBytes;
+        record_transfer(date, wireShare, day.size(), diskBytes);
+    }
+    return objects;
+}
+
+void NeoClient::record_transfer(const string& date, uint64_t wireBytes, uint64_t bodyBytes, uint64_t diskBytes) {
+    lock_guard<mutex> lock(statsMutex_);
+    DayTransferStats& day = transferStats_[date];
+    day.wire_bytes += wireBytes;
+    day.body_bytes += bodyBytes;
+    day.disk_bytes += diskBytes;
+}
+
+map<string, DayTransferStats> NeoClient::transfer_stats() const {
+    lock_guard<mutex> lock(statsMutex_);
+    return transferStats_;
+}
+
+LatencyOptions latency_options_from_env() {
+    LatencyOptions options;
+    if (const char* hedge = getenv("NEO_HEDGE_MS")) {
+        if (*hedge) options.hedge_after_ms = strtol(hedge, nullptr, 10);
+    }
+    if (const char* race = getenv("NEO_RACE_LOCAL")) {
+        options.race_local = string(race) != "0";
+    }
+    return options;
+}
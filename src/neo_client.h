@@ -0,0 +1,169 @@
+#ifndef NEO_CLIENT_H
+#define NEO_CLIENT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "feed_decoder.h"
+#include "latency_recorder.h"
+#include "neo_fetcher.h"
+#include "request_scheduler.h"
+#include "response_cache.h"
+#include "single_flight.h"
+
+// Bytes spent on one feed day: on the wire (headers plus encoded body), after decoding, and in the
+// compressed cache. Days fetched as part of a wider window get a share of its wire bytes
+// proportional to their size.
+struct DayTransferStats {
+    uint64_t wire_bytes = 0;
+    uint64_t body_bytes = 0;
+    uint64_t disk_bytes = 0;
+};
+
+// How interactive lookups that miss the cache bound their latency
+struct LatencyOptions {
+    long hedge_after_ms = -1;        // send a duplicate request after this long; -1 = observed p95, 0 = never
+    long initial_hedge_ms = 1000;    // budget used until enough latencies were observed for a p95
+    bool race_local = true;          // answer from an expired cache entry or the snapshot while the network refreshes
+    std::string snapshot_path = "data.json";
+};
+
+// Counters and latency percentiles of interactive lookups
+struct LookupStats {
+    uint64_t lookups = 0;
+    uint64_t hedged = 0;          // lookups that sent a duplicate request
+    uint64_t hedge_wins = 0;      // ... and got their answer from the duplicate
+    uint64_t local_wins = 0;      // answered from a local copy while the network refreshed the cache
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double hedge_budget_ms = 0.0; // budget currently in effect
+};
+
+// One feed day with its records decoded. A response other than a 200 has no records.
+struct FeedDay {
+    FetchResult response;
+    DecodedFeed feed;
+    bool decoded = false;     // feed was filled in; get_feed_day leaves cache hits undecoded
+};
+
+// Entry point for feed lookups: serves from the response cache when it can and otherwise queues
+// the request on the rate-limit-aware scheduler, caching successful responses. Concurrent lookups
+// of the same date share one request. A date the API answers with an empty list is remembered as
+// empty and answered locally until the negative TTL passes; errors and throttling never are.
+// Network responses are decoded while they download, cache hits as they are read; no DOM is built.
+// Interactive lookups that miss the cache are latency-bounded: a slow request is hedged with a
+// duplicate, and a local copy (expired cache entry or snapshot file) answers first when one exists.
+class NeoClient {
+public:
+    NeoClient(RequestScheduler& scheduler, ResponseCache& cache, std::string apiKey,
+              LatencyOptions latency = LatencyOptions());
+    ~NeoClient();
+
+    NeoClient(const NeoClient&) = delete;
+    NeoClient& operator=(const NeoClient&) = delete;
+
+    // Returns the feed for one date; FetchResult::from_cache tells which path served it
+    FetchResult get_feed_day(const std::string& date, RequestPriority priority = RequestPriority::Interactive);
+
+    // The same, decoded into records
+    std::shared_ptr<const FeedDay> get_feed_records(const std::string& date,
+                                                    RequestPriority priority = RequestPriority::Interactive);
+
+    // Hedging, racing and p50/p99 latency of interactive lookups
+    LookupStats lookup_stats() const;
+
+    // Lookups that waited on another caller's in-flight request, or on a window fetch covering
+    // their date, instead of issuing their own
+    uint64_t coalesced_requests() const { return flights_.coalesced() + windowWaits_; }
+
+    // A feed window requested as one background transfer. done yields the number of objects once
+    // every day of the page is in the cache, and fails when the request does (cancelled, HTTP error).
+    struct WindowFetch {
+        std::string url;
+        std::shared_future<size_t> done;
+    };
+
+    // Queues one request for a whole window and returns at once. Until it completes, lookups of its
+    // days wait for it instead of sending their own request, and an interactive lookup moves it
+    // ahead of queued background work. The page is stored as soon as it completes, so the caller
+    // only needs to wait on done for the object count or the error.
+    WindowFetch fetch_window(const FeedWindow& window, RequestPriority priority = RequestPriority::Background);
+
+    // Fetches every uncached date of [startDate, endDate] as background work: the uncached
+    // feed-sized windows go out as one curl_multi range fetch, at most maxConcurrent at a time,
+    // and each day of every page that arrives is stored in the cache. Returns the number of windows
+    // fetched; ApiRequestException names the first window that failed, after the others are stored.
+    size_t backfill(const std::string& startDate, const std::string& endDate, int maxConcurrent = 4);
+
+    // Splits a fetched feed page into single-day documents and stores each in the cache.
+    // Returns the number of objects on the page; JsonStreamError when the page is not a feed.
+    size_t store_page(const FetchResult& page);
+
+    // Transfer and storage sizes per feed day fetched by this client, ordered by date
+    std::map<std::string, DayTransferStats> transfer_stats() const;
+
+    RequestScheduler& scheduler() { return scheduler_; }
+    ResponseCache& cache() { return cache_; }
+    const std::string& api_key() const { return apiKey_; }
+
+private:
+    // Notified by the scheduler as each request of a lookup finishes, so the lookup can wait for
+    // the first of several
+    struct CompletionSignal {
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    // A request whose body is decoded while it downloads; the scheduler's worker shares the decoder
+    struct StreamedRequest {
+        std::future<FetchResult> response;
+        std::shared_ptr<StreamedFeed> body;
+        std::shared_ptr<CompletionSignal> signal;   // may be null
+    };
+
+    std::shared_ptr<const FeedDay> lookup(const std::string& date, RequestPriority priority, bool decode);
+    FeedDay load_feed_day(const std::string& date, RequestPriority priority, bool decode);
+    bool load_cached(const std::string& date, bool decode, FeedDay& day);
+    bool wait_for_window(const std::string& date, RequestPriority priority);
+    void forget_window(const std::string& url, const std::vector<std::string>& days);
+    FeedDay fetch_bounded(const std::string& date);
+    StreamedRequest submit_streamed(const std::string& url, RequestPriority priority,
+                                    std::shared_ptr<CompletionSignal> signal = nullptr);
+    FeedDay await_hedged(const std::string& url, StreamedRequest first);
+    bool local_copy(const std::string& date, FeedDay& result);
+    void refresh_in_background(const std::string& date, StreamedRequest pending);
+    void store_day(const std::string& date, const FeedDay& day);
+    size_t store_days(const StreamedFeed& page, uint64_t pageWire);
+    double hedge_budget_ms() const;
+    void record_transfer(const std::string& date, uint64_t wireBytes, uint64_t bodyBytes, uint64_t diskBytes);
+
+    RequestScheduler& scheduler_;
+    ResponseCache& cache_;
+    std::string apiKey_;
+    SingleFlight<std::string, std::shared_ptr<const FeedDay>> flights_;
+    std::mutex windowsMutex_;
+    std::map<std::string, WindowFetch> pendingDays_;   // date -> window fetch that will store it
+    std::atomic<uint64_t> windowWaits_{0};
+    mutable std::mutex statsMutex_;
+    std::map<std::string, DayTransferStats> transferStats_;
+
+    LatencyOptions latency_;
+    LatencyRecorder lookupLatency_;    // every interactive lookup, cache hits included
+    LatencyRecorder networkLatency_;   // interactive lookups answered by the API; drives the hedge budget
+    LookupStats lookupStats_;          // counters only; percentiles are filled in by lookup_stats()
+    std::once_flag snapshotLoaded_;
+    MappedFeed snapshot_;
+    std::mutex refreshMutex_;
+    std::vector<std::future<void>> refreshes_;
+};
+
+// Builds latency options from NEO_HEDGE_MS and NEO_RACE_LOCAL, falling back to the defaults
+LatencyOptions latency_options_from_env();
+
+#endif // NEO_CLIENT_H
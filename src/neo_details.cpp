@@ -0,0 +1,291 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include "neo_details.h"
+#include "feed_stream.h"
+#include "get_data.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// NeoWs sends most numbers as strings and omits fields it has no value for
+double number_field(const json& object, const char* key) {
+    auto found = object.find(key);
+    if (found == object.end() || found->is_null()) return 0.0;
+    if (found->is_number()) return found->get<double>();
+    if (found->is_string()) return parse_feed_number(found->get_ref<const string&>());
+    return 0.0;
+}
+
+string string_field(const json& object, const char* key) {
+    auto found = object.find(key);
+    return found != object.end() && found->is_string() ? found->get<string>() : "";
+}
+
+CloseApproach approach_from_json(const json& approach) {
+    CloseApproach result;
+    // A missing or unreadable date is left at the epoch day
+    parse_date(string_field(approach, "close_approach_date"), result.date);
+    result.date_full = string_field(approach, "close_approach_date_full");
+    result.epoch_ms = approach.value("epoch_date_close_approach", int64_t(0));
+    const json& velocity = approach.value("relative_velocity", json::object());
+    result.velocity_km_s = number_field(velocity, "kilometers_per_second");
+    result.velocity_km_h = number_field(velocity, "kilometers_per_hour");
+    const json& miss = approach.value("miss_distance", json::object());
+    result.miss_au = number_field(miss, "astronomical");
+    result.miss_lunar = number_field(miss, "lunar");
+    result.miss_km = number_field(miss, "kilometers");
+    result.miss_miles = number_field(miss, "miles");
+    result.orbiting_body = string_field(approach, "orbiting_body");
+    return result;
+}
+
+} // namespace
+
+NeoDetail parse_neo_detail(const json& object) {
+    NeoDetail detail;
+    detail.id = string_field(object, "id");
+    detail.name = string_field(object, "name");
+    detail.nasa_jpl_url = string_field(object, "nasa_jpl_url");
+    detail.absolute_magnitude_h = number_field(object, "absolute_magnitude_h");
+    if (object.contains("estimated_diameter")) {
+        const json& km = object["estimated_diameter"].value("kilometers", json::object());
+        detail.diameter_km_min = number_field(km, "estimated_diameter_min");
+        detail.diameter_km_max = number_field(km, "estimated_diameter_max");
+    }
+    detail.is_potentially_hazardous = object.value("is_potentially_hazardous_asteroid", false);
+    detail.is_sentry_object = object.value("is_sentry_object", false);
+
+    if (object.contains("orbital_data")) {
+        const json& orbit = object["orbital_data"];
+        detail.orbit.orbit_id = string_field(orbit, "orbit_id");
+        if (orbit.contains("orbit_class")) {
+            detail.orbit.orbit_class = string_field(orbit["orbit_class"], "orbit_class_type");
+        }
+        detail.orbit.epoch_osculation = number_field(orbit, "epoch_osculation");
+        detail.orbit.eccentricity = number_field(orbit, "eccentricity");
+        detail.orbit.semi_major_axis_au = number_field(orbit, "semi_major_axis");
+        detail.orbit.inclination_deg = number_field(orbit, "inclination");
+        detail.orbit.ascending_node_longitude_deg = number_field(orbit, "ascending_node_longitude");
+        detail.orbit.perihelion_argument_deg = number_field(orbit, "perihelion_argument");
+        detail.orbit.mean_anomaly_deg = number_field(orbit, "mean_anomaly");
+        detail.orbit.perihelion_distance_au = number_field(orbit, "perihelion_distance");
+        detail.orbit.aphelion_distance_au = number_field(orbit, "aphelion_distance");
+        detail.orbit.orbital_period_days = number_field(orbit, "orbital_period");
+        detail.orbit.minimum_orbit_intersection_au = number_field(orbit, "minimum_orbit_intersection");
+    }
+
+    if (object.contains("close_approach_data")) {
+        for (const auto& approach : object["close_approach_data"]) {
+            detail.approaches.push_back(approach_from_json(approach));
+        }
+    }
+    return detail;
+}
+
+json detail_to_json(const NeoDetail& detail) {
+    json orbit = {
+        {"orbit_id", detail.orbit.orbit_id},
+        {"orbit_class", detail.orbit.orbit_class},
+        {"epoch_osculation", detail.orbit.epoch_osculation},
+        {"e", detail.orbit.eccentricity},
+        {"a", detail.orbit.semi_major_axis_au},
+        {"i", detail.orbit.inclination_deg},
+        {"node", detail.orbit.ascending_node_longitude_deg},
+        {"peri", detail.orbit.perihelion_argument_deg},
+        {"M", detail.orbit.mean_anomaly_deg},
+        {"q", detail.orbit.perihelion_distance_au},
+        {"Q", detail.orbit.aphelion_distance_au},
+        {"period", detail.orbit.orbital_period_days},
+        {"moid", detail.orbit.minimum_orbit_intersection_au},
+    };
+    json approaches = json::array();
+    for (const auto& approach : detail.approaches) {
+        approaches.push_back({format_date(approach.date), approach.date_full, approach.epoch_ms, approach.velocity_km_s,
+                              approach.velocity_km_h, approach.miss_au, approach.miss_lunar, approach.miss_km,
+                              approach.miss_miles, approach.orbiting_body});
+    }
+    return {
+        {"id", detail.id},
+        {"name", detail.name},
+        {"url", detail.nasa_jpl_url},
+        {"h", detail.absolute_magnitude_h},
+        {"d_min", detail.diameter_km_min},
+        {"d_max", detail.diameter_km_max},
+        {"hazardous", detail.is_potentially_hazardous},
+        {"sentry", detail.is_sentry_object},
+        {"orbit", orbit},
+        {"approaches", approaches},
+    };
+}
+
+NeoDetail detail_from_json(const json& stored) {
+    NeoDetail detail;
+    detail.id = stored.at("id").get<string>();
+    detail.name = stored.at("name").get<string>();
+    detail.nasa_jpl_url = stored.at("url").get<string>();
+    detail.absolute_magnitude_h = stored.at("h").get<double>();
+    detail.diameter_km_min = stored.at("d_min").get<double>();
+    detail.diameter_km_max = stored.at("d_max").get<double>();
+    detail.is_potentially_hazardous = stored.at("hazardous").get<bool>();
+    detail.is_sentry_object = stored.at("sentry").get<bool>();
+
+    const json& orbit = stored.at("orbit");
+    detail.orbit.orbit_id = orbit.at("orbit_id").get<string>();
+    detail.orbit.orbit_class = orbit.at("orbit_class").get<string>();
+    detail.orbit.epoch_osculation = orbit.at("epoch_osculation").get<double>();
+    detail.orbit.eccentricity = orbit.at("e").get<double>();
+    detail.orbit.semi_major_axis_au = orbit.at("a").get<double>();
+    detail.orbit.inclination_deg = orbit.at("i").get<double>();
+    detail.orbit.ascending_node_longitude_deg = orbit.at("node").get<double>();
+    detail.orbit.perihelion_argument_deg = orbit.at("peri").get<double>();
+    detail.orbit.mean_anomaly_deg = orbit.at("M").get<double>();
+    detail.orbit.perihelion_distance_au = orbit.at("q").get<double>();
+    detail.orbit.aphelion_distance_au = orbit.at("Q").get<double>();
+    detail.orbit.orbital_period_days = orbit.at("period").get<double>();
+    detail.orbit.minimum_orbit_intersection_au = orbit.at("moid").get<double>();
+
+    for (const auto& row : stored.at("approaches")) {
+        CloseApproach approach;
+        approach.date = parse_date(row.at(0).get<string>());
+        approach.date_full = row.at(1).get<string>();
+        approach.epoch_ms = row.at(2).get<int64_t>();
+        approach.velocity_km_s = row.at(3).get<double>();
+        approach.velocity_km_h = row.at(4).get<double>();
+        approach.miss_au = row.at(5).get<double>();
+        approach.miss_lunar = row.at(6).get<double>();
+        approach.miss_km = row.at(7).get<double>();
+        approach.miss_miles = row.at(8).get<double>();
+        approach.orbiting_body = row.at(9).get<string>();
+        detail.approaches.push_back(std::move(approach));
+    }
+    return detail;
+}
+
+DetailStore::DetailStore(string path) : path_(std::move(path)) {
+    ifstream file(path_);
+    string line;
+    size_t lineNumber = 0;
+    while (getline(file, line)) {
+        ++lineNumber;
+        if (line.empty()) continue;
+        try {
+            NeoDetail detail = detail_from_json(json::parse(line));
+            records_[detail.id] = std::move(detail);
+        } catch (const exception& e) {
+            // A crash mid-append can leave a torn last line; everything before it is still good
+            cerr << "Skipping unreadable detail record on line " << lineNumber << " of " << path_ << ": " << e.what()
+                 << endl;
+        }
+    }
+}
+
+bool DetailStore::contains(const string& id) const {
+    lock_guard<mutex> lock(mutex_);
+    return records_.count(id) > 0;
+}
+
+bool DetailStore::get(const string& id, NeoDetail& detail) const {
+    lock_guard<mutex> lock(mutex_);
+    auto found = records_.find(id);
+    if (found == records_.end()) {
+        return false;
+    }
+    detail = found->second;
+    return true;
+}
+
+void DetailStore::put(const NeoDetail& detail) {
+    string line = detail_to_json(detail).dump();
+    lock_guard<mutex> lock(mutex_);
+    ofstream file(path_, ios::app);
+    if (!file.is_open()) {
+        cerr << "Could not append to detail store " << path_ << endl;
+    } else {
+        file << line << '\n';
+    }
+    records_[detail.id] = detail;
+}
+
+size_t DetailStore::size() const {
+    lock_guard<mutex> lock(mutex_);
+    return records_.size();
+}
+
+void DetailStore::for_each(const function<void(const NeoDetail&)>& visit) const {
+    lock_guard<mutex> lock(mutex_);
+    for (const auto& [id, detail] : records_) {
+        visit(detail);
+    }
+}
+
+DetailLookup::DetailLookup(NeoClient& client, DetailStore& store) : client_(client), store_(store) {}
+
+// Function to resolve a batch of ids: dedupe, serve what the store has, fetch the rest together
+map<string, NeoDetail> DetailLookup::lookup(const vector<string>& ids, RequestPriority priority) {
+    map<string, NeoDetail> details;
+    vector<string> missing;
+    set<string> seen;
+    DetailLookupStats batch;
+    batch.requested = ids.size();
+    for (const auto& id : ids) {
+        if (!seen.insert(id).second) {
+            ++batch.duplicates;
+            continue;
+        }
+        NeoDetail detail;
+        if (store_.get(id, detail)) {
+            details.emplace(id, std::move(detail));
+            ++batch.from_store;
+        } else {
+            missing.push_back(id);
+        }
+    }
+
+    // Queue every missing id at once; the scheduler's workers bound how many run concurrently
+    vector<future<FetchResult>> pending;
+    for (const auto& id : missing) {
+        pending.push_back(client_.scheduler().submit(build_detail_url(id, client_.api_key()), client_.api_key(), priority));
+    }
+    for (size_t i = 0; i < missing.size(); ++i) {
+        try {
+            FetchResult result = pending[i].get();
+            if (result.status != 200) {
+                cerr << "Detail lookup for " << missing[i] << " failed with HTTP " << result.status << endl;
+                ++batch.failed;
+                continue;
+            }
+            NeoDetail detail = parse_neo_detail(json::parse(result.body));
+            store_.put(detail);
+            details.emplace(missing[i], std::move(detail));
+            ++batch.fetched;
+        } catch (const exception& e) {
+            cerr << "Detail lookup for " << missing[i] << " failed: " << e.what() << endl;
+            ++batch.failed;
+        }
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    stats_.requested += batch.requested;
+    stats_.duplicates += batch.duplicates;
+    stats_.from_store += batch.from_store;
+    stats_.fetched += batch.fetched;
+    stats_.failed += batch.failed;
+    return details;
+}
+
+DetailLookupStats DetailLookup::stats() const {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+string build_detail_url(const string& id, const string& apiKey) {
+    return neo_api_root() + "/neo/" + id + "?api_key=" + apiKey;
+}
+
+string default_detail_store_path(const CacheOptions& cacheOptions) {
+    return (fs::path(cacheOptions.directory) / "neo_details.jsonl").string();
+}
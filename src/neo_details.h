@@ -0,0 +1,111 @@
+#ifndef NEO_DETAILS_H
+#define NEO_DETAILS_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "neo_client.h"
+#include "neo_record.h"
+#include "platform_config.h"
+
+// Orbital elements from the orbital_data block of /neo/{id} (angles in degrees, distances in AU)
+struct OrbitalElements {
+    std::string orbit_id;
+    std::string orbit_class;             // e.g. "APO", "ATE", "AMO"
+    double epoch_osculation = 0.0;       // Julian date
+    double eccentricity = 0.0;
+    double semi_major_axis_au = 0.0;
+    double inclination_deg = 0.0;
+    double ascending_node_longitude_deg = 0.0;
+    double perihelion_argument_deg = 0.0;
+    double mean_anomaly_deg = 0.0;
+    double perihelion_distance_au = 0.0;
+    double aphelion_distance_au = 0.0;
+    double orbital_period_days = 0.0;
+    double minimum_orbit_intersection_au = 0.0;
+};
+
+// Everything /neo/{id} says about one object: the feed's summary fields, the orbit and the full
+// close-approach history
+struct NeoDetail {
+    std::string id;
+    std::string name;
+    std::string nasa_jpl_url;
+    double absolute_magnitude_h = 0.0;
+    double diameter_km_min = 0.0;
+    double diameter_km_max = 0.0;
+    bool is_potentially_hazardous = false;
+    bool is_sentry_object = false;
+    OrbitalElements orbit;
+    std::vector<CloseApproach> approaches;
+};
+
+// Builds a NeoDetail from a /neo/{id} response or a browse-page object
+NeoDetail parse_neo_detail(const json& object);
+
+// Converts a NeoDetail to and from the compact form kept by DetailStore
+json detail_to_json(const NeoDetail& detail);
+NeoDetail detail_from_json(const json& stored);
+
+// Id-keyed store of detail records. Records live in memory and in an append-only JSON-lines
+// file that is replayed on construction; a later line for the same id replaces an earlier one.
+// Safe to use from several threads.
+class DetailStore {
+public:
+    explicit DetailStore(std::string path);
+
+    bool contains(const std::string& id) const;
+    bool get(const std::string& id, NeoDetail& detail) const;
+    void put(const NeoDetail& detail);
+    size_t size() const;
+
+    // Calls visit for every record in id order, holding the store's lock
+    void for_each(const std::function<void(const NeoDetail&)>& visit) const;
+
+private:
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::map<std::string, NeoDetail> records_;
+};
+
+// Counters for a DetailLookup
+struct DetailLookupStats {
+    uint64_t requested = 0;    // ids passed in, duplicates included
+    uint64_t duplicates = 0;   // repeated ids within a batch
+    uint64_t from_store = 0;   // answered by the DetailStore
+    uint64_t fetched = 0;      // fetched from /neo/{id}
+    uint64_t failed = 0;       // unknown ids and failed requests
+};
+
+// Batched /neo/{id} lookups. A batch is deduplicated, checked against the store, and the
+// missing ids are queued on the scheduler together, so a batch takes about
+// ceil(missing / workers) round trips instead of one per id. Bulk batches should be looked up at
+// Background priority, where the worker count is the scheduler's background_workers.
+class DetailLookup {
+public:
+    DetailLookup(NeoClient& client, DetailStore& store);
+
+    // Returns the details of every id that could be resolved, keyed by id. Ids that are unknown to
+    // the API or whose request failed are left out and counted in stats().failed.
+    std::map<std::string, NeoDetail> lookup(const std::vector<std::string>& ids,
+                                            RequestPriority priority = RequestPriority::Interactive);
+
+    DetailLookupStats stats() const;
+
+private:
+    NeoClient& client_;
+    DetailStore& store_;
+    mutable std::mutex mutex_;
+    DetailLookupStats stats_;
+};
+
+// URL of the detail endpoint for one object
+std::string build_detail_url(const std::string& id, const std::string& apiKey);
+
+// Default location of the detail store, inside the response cache directory
+std::string default_detail_store_path(const CacheOptions& cacheOptions);
+
+#endif // NEO_DETAILS_H
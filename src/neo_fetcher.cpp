@@ -0,0 +1,409 @@
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include "neo_fetcher.h"
+#include "calendar.h"
+#include "get_data.h"
+
+using namespace std;
+
+namespace {
+
+// Microseconds for a curl_off_t timing value
+long long timing_info(CURL* easy, CURLINFO info) {
+    curl_off_t value = 0;
+    curl_easy_getinfo(easy, info, &value);
+    return static_cast<long long>(value);
+}
+
+// Header callback picking the X-RateLimit-* values out of the response headers
+size_t RateLimitHeaderCallback(char* buffer, size_t size, size_t nitems, FetchResult* result) {
+    size_t totalSize = size * nitems;
+    string line(buffer, totalSize);
+    auto colon = line.find(':');
+    if (colon != string::npos) {
+        string name = line.substr(0, colon);
+        transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        if (name == "x-ratelimit-limit") {
+            result->rate_limit.limit = strtol(line.c_str() + colon + 1, nullptr, 10);
+        } else if (name == "x-ratelimit-remaining") {
+            result->rate_limit.remaining = strtol(line.c_str() + colon + 1, nullptr, 10);
+        }
+    }
+    return totalSize;
+}
+
+// Routes a streamed body by status: a 200 goes chunk by chunk to the sink, anything else (a 429
+// to retry, an error page) is buffered into the result like fetch() does
+struct StatusGate {
+    CURL* easy;
+    StreamSink* sink;
+    string* errorBody;
+    long status = 0;
+};
+
+size_t StatusGateCallback(void* contents, size_t size, size_t nmemb, StatusGate* gate) {
+    if (gate->status == 0) {
+        curl_easy_getinfo(gate->easy, CURLINFO_RESPONSE_CODE, &gate->status);
+    }
+    if (gate->status == 200) {
+        return StreamWriteCallback(contents, size, nmemb, gate->sink);
+    }
+    return WriteCallback(contents, size, nmemb, gate->errorBody);
+}
+
+void ensure_curl_initialized() {
+    static once_flag initialized;
+    call_once(initialized, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+} // namespace
+
+NeoFetcher::NeoFetcher(const FetcherOptions& options) : options_(options), share_(nullptr) {
+    ensure_curl_initialized();
+    share_ = curl_share_init();
+    if (!share_) {
+        throw ApiRequestException("Failed to initialize cURL share handle");
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock_share);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock_share);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
+NeoFetcher::~NeoFetcher() {
+    for (CURL* easy : idleHandles_) {
+        curl_easy_cleanup(easy);
+    }
+    curl_share_cleanup(share_);
+}
+
+void NeoFetcher::lock_share(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<NeoFetcher*>(userptr)->shareLocks_[data].lock();
+}
+
+void NeoFetcher::unlock_share(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<NeoFetcher*>(userptr)->shareLocks_[data].unlock();
+}
+
+CURL* NeoFetcher::acquire_handle() {
+    {
+        lock_guard<mutex> lock(poolMutex_);
+        if (!idleHandles_.empty()) {
+            CURL* easy = idleHandles_.back();
+            idleHandles_.pop_back();
+            return easy;
+        }
+    }
+    CURL* easy = curl_easy_init();
+    if (!easy) {
+        throw ApiRequestException("Failed to initialize cURL");
+    }
+    return easy;
+}
+
+void NeoFetcher::release_handle(CURL* easy) {
+    {
+        lock_guard<mutex> lock(poolMutex_);
+        if (idleHandles_.size() < options_.pool_size) {
+            idleHandles_.push_back(easy);
+            return;
+        }
+    }
+    curl_easy_cleanup(easy);
+}
+
+// Function to (re)configure a pooled handle for the next request
+void NeoFetcher::prepare_handle(CURL* easy, const string& url, FetchResult* result) const {
+    // Reset clears per-request options but keeps the handle's live connections and caches
+    curl_easy_reset(easy);
+    curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &result->body);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, RateLimitHeaderCallback);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, result);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, options_.connect_timeout_ms);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, options_.timeout_ms);
+    curl_easy_setopt(easy, CURLOPT_DNS_CACHE_TIMEOUT, 300L);
+    if (options_.compressed) {
+        curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "gzip, deflate");
+    }
+    if (options_.keep_alive) {
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPIDLE, 60L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPINTVL, 30L);
+    } else {
+        curl_easy_setopt(easy, CURLOPT_FORBID_REUSE, 1L);
+    }
+    if (options_.http2) {
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        // Wait for an existing HTTP/2 connection to multiplex on rather than opening a new one
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    }
+}
+
+// Function to perform a single blocking request on a pooled handle
+FetchResult NeoFetcher::fetch(const string& url) {
+    FetchResult result;
+    CURL* easy = acquire_handle();
+    prepare_handle(easy, url, &result);
+
+    CURLcode res = curl_easy_perform(easy);
+    if (res != CURLE_OK) {
+        release_handle(easy);
+        throw ApiRequestException("cURL error: " + string(curl_easy_strerror(res)));
+    }
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &result.status);
+    result.timing = read_request_timing(easy);
+    release_handle(easy);
+    return result;
+}
+
+// Function to perform a request whose body goes to a streaming sink
+FetchResult NeoFetcher::fetch_streaming(const string& url, StreamSink& sink) {
+    FetchResult result;
+    CURL* easy = acquire_handle();
+    prepare_handle(easy, url, &result);
+    StatusGate gate{easy, &sink, &result.body};
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, StatusGateCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &gate);
+
+    CURLcode res = curl_easy_perform(easy);
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &result.status);
+    result.timing = read_request_timing(easy);
+    release_handle(easy);
+    if (sink.error) {
+        rethrow_exception(sink.error);
+    }
+    if (res != CURLE_OK) {
+        throw ApiRequestException("cURL error: " + string(curl_easy_strerror(res)));
+    }
+    return result;
+}
+
+FetchResult NeoFetcher::fetch_feed_day(const string& date, const string& apiKey) {
+    return fetch(build_feed_url({date, date}, apiKey));
+}
+
+// Function to run several transfers at once through the curl_multi interface
+vector<FetchResult> NeoFetcher::fetch_all(const vector<string>& urls, int maxConcurrent) {
+    vector<FetchResult> results(urls.size());
+    if (urls.empty()) {
+        return results;
+    }
+    size_t limit = static_cast<size_t>(max(1, maxConcurrent));
+
+    // Owns the multi handle and hands every attached easy handle back to the pool
+    struct MultiTransfer {
+        NeoFetcher& fetcher;
+        CURLM* multi;
+        vector<CURL*> active;
+
+        explicit MultiTransfer(NeoFetcher& owner) : fetcher(owner), multi(curl_multi_init()) {
+            if (!multi) {
+                throw ApiRequestException("Failed to initialize cURL multi handle");
+            }
+        }
+        ~MultiTransfer() {
+            for (CURL* easy : active) {
+                curl_multi_remove_handle(multi, easy);
+                fetcher.release_handle(easy);
+            }
+            curl_multi_cleanup(multi);
+        }
+        void finish(CURL* easy) {
+            curl_multi_remove_handle(multi, easy);
+            active.erase(find(active.begin(), active.end(), easy));
+            fetcher.release_handle(easy);
+        }
+    } transfer(*this);
+
+    if (options_.http2) {
+        curl_multi_setopt(transfer.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+
+    size_t next = 0;
+    auto startNext = [&]() {
+        CURL* easy = acquire_handle();
+        prepare_handle(easy, urls[next], &results[next]);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, reinterpret_cast<void*>(next));
+        curl_multi_add_handle(transfer.multi, easy);
+        transfer.active.push_back(easy);
+        ++next;
+    };
+    while (next < urls.size() && transfer.active.size() < limit) {
+        startNext();
+    }
+
+    while (!transfer.active.empty()) {
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(transfer.multi, &running);
+        if (mc != CURLM_OK) {
+            throw ApiRequestException("cURL multi error: " + string(curl_multi_strerror(mc)));
+        }
+
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(transfer.multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            CURL* easy = msg->easy_handle;
+            CURLcode res = msg->data.result;
+            char* privateData = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &privateData);
+            size_t index = reinterpret_cast<size_t>(privateData);
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &results[index].status);
+            results[index].timing = read_request_timing(easy);
+            transfer.finish(easy);
+
+            if (res != CURLE_OK) {
+                throw ApiRequestException("cURL error for " + urls[index] + ": " + string(curl_easy_strerror(res)));
+            }
+
+            // Keep the pipeline full: start the next transfer as soon as one finishes
+            if (next < urls.size()) {
+                startNext();
+            }
+        }
+
+        if (!transfer.active.empty()) {
+            mc = curl_multi_poll(transfer.multi, nullptr, 0, 1000, nullptr);
+            if (mc != CURLM_OK) {
+                throw ApiRequestException("cURL multi error: " + string(curl_multi_strerror(mc)));
+            }
+        }
+    }
+
+    return results;
+}
+
+NeoFetcher& shared_fetcher() {
+    static NeoFetcher fetcher([] {
+        FetcherOptions options;
+        const char* http2 = getenv("NEO_HTTP2");
+        options.http2 = http2 && string(http2) == "1";
+        const char* compression = getenv("NEO_COMPRESSION");
+        options.compressed = !(compression && string(compression) == "0");
+        return options;
+    }());
+    return fetcher;
+}
+
+RequestTiming read_request_timing(CURL* easy) {
+    RequestTiming timing;
+    timing.namelookup_us = timing_info(easy, CURLINFO_NAMELOOKUP_TIME_T);
+    timing.connect_us = timing_info(easy, CURLINFO_CONNECT_TIME_T);
+    timing.tls_us = timing_info(easy, CURLINFO_APPCONNECT_TIME_T);
+    timing.ttfb_us = timing_info(easy, CURLINFO_STARTTRANSFER_TIME_T);
+    timing.total_us = timing_info(easy, CURLINFO_TOTAL_TIME_T);
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &timing.new_connections);
+    // SIZE_DOWNLOAD counts the encoded bytes, so it stays the wire size when a body was gzipped
+    curl_off_t wireBytes = 0;
+    if (curl_easy_getinfo(easy, CURLINFO_SIZE_DOWNLOAD_T, &wireBytes) == CURLE_OK) {
+        timing.wire_bytes = static_cast<long long>(wireBytes);
+    }
+    curl_easy_getinfo(easy, CURLINFO_HEADER_SIZE, &timing.header_bytes);
+    return timing;
+}
+
+string describe_timing(const RequestTiming& timing) {
+    ostringstream out;
+    out << fixed << setprecision(1)
+        << "dns " << timing.namelookup_us / 1000.0 << " ms, "
+        << "connect " << timing.connect_us / 1000.0 << " ms, "
+        << "tls " << timing.tls_us / 1000.0 << " ms, "
+        << "ttfb " << timing.ttfb_us / 1000.0 << " ms, "
+        << "total " << timing.total_us / 1000.0 << " ms"
+        << (timing.new_connections == 0 ? " (reused connection)" : "");
+    return out.str();
+}
+
+// Function to get the feed endpoint, optionally redirected to a local stand-in server
+string neo_feed_base_url() {
+    const char* overrideUrl = getenv("NEO_API_BASE_URL");
+    if (overrideUrl && *overrideUrl) {
+        return overrideUrl;
+    }
+    return "https://api.nasa.gov/neo/rest/v1/feed";
+}
+
+string neo_api_root() {
+    string base = neo_feed_base_url();
+    const string suffix = "/feed";
+    if (base.size() >= suffix.size() && base.compare(base.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        base.erase(base.size() - suffix.size());
+    }
+    return base;
+}
+
+string build_feed_url(const FeedWindow& window, const string& apiKey) {
+    return neo_feed_base_url() + "?start_date=" + window.start_date + "&end_date=" + window.end_date +
+           "&api_key=" + apiKey;
+}
+
+// Function to split a date range into feed-sized windows
+vector<FeedWindow> split_into_windows(const string& startDate, const string& endDate, int maxDays) {
+    if (maxDays < 1) {
+        throw invalid_argument("Window size must be at least one day");
+    }
+    Date first = parse_date(startDate);
+    Date last = parse_date(endDate);
+    if (last < first) {
+        throw invalid_argument("End date " + endDate + " is before start date " + startDate);
+    }
+
+    vector<FeedWindow> windows;
+    for (Date day = first; day <= last; day += maxDays) {
+        Date windowEnd = min(day + (maxDays - 1), last);
+        windows.push_back({format_date(day), format_date(windowEnd)});
+    }
+    return windows;
+}
+
+// Function to run several transfers at once through the shared fetcher
+vector<string> fetch_urls_concurrently(const vector<string>& urls, int maxConcurrent) {
+    vector<FetchResult> results = shared_fetcher().fetch_all(urls, maxConcurrent);
+    vector<string> bodies;
+    bodies.reserve(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].status >= 400) {
+            throw ApiRequestException("HTTP " + to_string(results[i].status) + " for " + urls[i]);
+        }
+        bodies.push_back(std::move(results[i].body));
+    }
+    return bodies;
+}
+
+// Function to fetch and merge NEO data for a whole date range
+json fetch_neo_range(const string& startDate, const string& endDate, const string& apiKey, int maxConcurrent) {
+    vector<FeedWindow> windows = split_into_windows(startDate, endDate);
+    vector<string> urls;
+    urls.reserve(windows.size());
+    for (const auto& window : windows) {
+        urls.push_back(build_feed_url(window, apiKey));
+    }
+
+    vector<string> bodies = fetch_urls_concurrently(urls, maxConcurrent);
+
+    json merged;
+    merged["element_count"] = 0;
+    merged["near_earth_objects"] = json::object();
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        json page = json::parse(bodies[i]);
+        if (!page.contains("near_earth_objects")) {
+            throw ApiRequestException("Unexpected feed response for window " + windows[i].start_date);
+        }
+        for (auto& [date, neos] : page["near_earth_objects"].items()) {
+            merged["near_earth_objects"][date] = std::move(neos);
+        }
+        merged["element_count"] = merged["element_count"].get<int>() + page.value("element_count", 0);
+    }
+    return merged;
+}
@@ -0,0 +1,133 @@
+#ifndef NEO_FETCHER_H
+#define NEO_FETCHER_H
+
+#include "platform_config.h"
+#include "get_data.h"
+#include <curl/curl.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The feed endpoint only accepts ranges of up to 7 days per request
+const int MAX_FEED_WINDOW_DAYS = 7;
+
+// A single [start_date, end_date] request window (dates are YYYY-MM-DD)
+struct FeedWindow {
+    std::string start_date;
+    std::string end_date;
+};
+
+// Per-request timing reported by libcurl, in microseconds from the start of the request, plus
+// the transfer size
+struct RequestTiming {
+    long long namelookup_us = 0;
+    long long connect_us = 0;
+    long long tls_us = 0;     // TLS handshake done (0 for plain HTTP)
+    long long ttfb_us = 0;    // first response byte received
+    long long total_us = 0;
+    long new_connections = 0; // 0 when the request reused a pooled connection
+    long long wire_bytes = 0; // body bytes as received, before content decoding
+    long header_bytes = 0;
+};
+
+// Rate-limit state reported by the API in X-RateLimit-* response headers (-1 when absent)
+struct RateLimitInfo {
+    long limit = -1;
+    long remaining = -1;
+};
+
+// Result of one transfer
+struct FetchResult {
+    std::string body;
+    long status = 0;
+    RequestTiming timing;
+    RateLimitInfo rate_limit;
+    bool from_cache = false;  // served by a local cache without touching the network
+};
+
+// Settings for a NeoFetcher
+struct FetcherOptions {
+    size_t pool_size = 4;          // idle easy handles kept for reuse
+    bool keep_alive = true;        // TCP keep-alive probes on pooled connections
+    bool http2 = false;            // negotiate HTTP/2 and multiplex concurrent requests
+    bool compressed = true;        // ask for gzip/deflate bodies; libcurl decodes them transparently
+    long connect_timeout_ms = 10000;
+    long timeout_ms = 30000;
+};
+
+// Long-lived fetcher that owns a pool of reusable easy handles. All handles share one
+// DNS, TLS-session and connection cache, so back-to-back requests skip the setup cost.
+// Safe to use from several threads.
+class NeoFetcher {
+public:
+    explicit NeoFetcher(const FetcherOptions& options = FetcherOptions());
+    ~NeoFetcher();
+
+    NeoFetcher(const NeoFetcher&) = delete;
+    NeoFetcher& operator=(const NeoFetcher&) = delete;
+
+    // Performs a blocking GET; throws ApiRequestException on transport errors
+    FetchResult fetch(const std::string& url);
+
+    // Performs a blocking GET and hands a 200 body to sink chunk by chunk instead of buffering it;
+    // any other status is returned with its body buffered, as fetch() does. Exceptions thrown by
+    // the sink abort the transfer and are rethrown here.
+    FetchResult fetch_streaming(const std::string& url, StreamSink& sink);
+
+    // Fetches the feed for a single date
+    FetchResult fetch_feed_day(const std::string& date, const std::string& apiKey);
+
+    // Fetches all URLs through a curl_multi event loop with at most maxConcurrent transfers
+    // in flight. Results are returned in the same order as the URLs with their HTTP status, so one
+    // failed window does not abort the others; transport errors throw.
+    std::vector<FetchResult> fetch_all(const std::vector<std::string>& urls, int maxConcurrent);
+
+    const FetcherOptions& options() const { return options_; }
+
+private:
+    CURL* acquire_handle();
+    void release_handle(CURL* easy);
+    void prepare_handle(CURL* easy, const std::string& url, FetchResult* result) const;
+
+    static void lock_share(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock_share(CURL* handle, curl_lock_data data, void* userptr);
+
+    FetcherOptions options_;
+    CURLSH* share_;
+    std::mutex shareLocks_[CURL_LOCK_DATA_LAST];
+    std::mutex poolMutex_;
+    std::vector<CURL*> idleHandles_;
+};
+
+// Process-wide fetcher used by the free-function API (fetch_neo_data, fetch_neo_range)
+NeoFetcher& shared_fetcher();
+
+// Reads the timing libcurl recorded for the last transfer on a handle
+RequestTiming read_request_timing(CURL* easy);
+
+// Formats a timing breakdown as a single line, e.g. for console diagnostics
+std::string describe_timing(const RequestTiming& timing);
+
+// Returns the NeoWs feed URL; NEO_API_BASE_URL overrides it (e.g. a local stand-in server)
+std::string neo_feed_base_url();
+
+// Root of the NeoWs REST API (the feed URL without its trailing /feed)
+std::string neo_api_root();
+
+// Builds the feed URL for a single window
+std::string build_feed_url(const FeedWindow& window, const std::string& apiKey);
+
+// Splits [startDate, endDate] into consecutive windows of at most maxDays days
+std::vector<FeedWindow> split_into_windows(const std::string& startDate, const std::string& endDate,
+                                           int maxDays = MAX_FEED_WINDOW_DAYS);
+
+// Fetches all URLs concurrently with the shared fetcher and returns the bodies in URL order;
+// ApiRequestException names the first URL that answered with an HTTP error
+std::vector<std::string> fetch_urls_concurrently(const std::vector<std::string>& urls, int maxConcurrent);
+
+// Fetches NEO data for every date in [startDate, endDate] and merges all windows into one
+// document with a single near_earth_objects map
+nlohmann::json fetch_neo_range(const std::string& startDate, const std::string& endDate,
+                               const std::string& apiKey, int maxConcurrent = 4);
+
+#endif // NEO_FETCHER_H
@@ -0,0 +1,450 @@
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include "neo_projection.h"
+#include "feed_index.h"
+
+using namespace std;
+
+namespace {
+
+const int MAX_DECIMAL_DIGITS = 18;       // every 18-digit integer fits in an int64_t
+
+// Flag bits; the explicit ones say a rule did not hold and the value is in an explicit table
+const uint8_t FLAG_HAZARDOUS = 1 << 0;
+const uint8_t FLAG_SENTRY = 1 << 1;
+const uint8_t FLAG_ID_TEXT = 1 << 2;
+const uint8_t FLAG_URL_EXPLICIT = 1 << 3;
+const uint8_t FLAG_TIME_EXPLICIT = 1 << 4;
+const uint8_t FLAG_DIAMETERS_EXPLICIT = 1 << 5;
+const uint8_t FLAG_DECIMAL_EXPLICIT = 1 << 6;
+
+// Text and numeric fields and the field groups that decode them
+const pair<NeoRecordPath, uint32_t> TEXT_FIELDS[] = {
+    {PATH_NAME, FIELD_NAME},
+    {PATH_JPL_URL, FIELD_JPL_URL},
+    {PATH_APPROACH_DATE_FULL, FIELD_APPROACH_TIME},
+    {PATH_ORBITING_BODY, FIELD_ORBITING_BODY},
+};
+const pair<NeoRecordPath, uint32_t> NUMERIC_FIELDS[] = {
+    {PATH_MAGNITUDE, FIELD_MAGNITUDE | FIELD_DIAMETERS},
+    {PATH_DIAMETER_KM_MIN, FIELD_DIAMETERS},  {PATH_DIAMETER_KM_MAX, FIELD_DIAMETERS},
+    {PATH_DIAMETER_M_MIN, FIELD_DIAMETERS},   {PATH_DIAMETER_M_MAX, FIELD_DIAMETERS},
+    {PATH_VELOCITY_KM_S, FIELD_VELOCITY},     {PATH_VELOCITY_KM_H, FIELD_VELOCITY},
+    {PATH_MISS_AU, FIELD_MISS_DISTANCE},      {PATH_MISS_LUNAR, FIELD_MISS_DISTANCE},
+    {PATH_MISS_KM, FIELD_MISS_DISTANCE},      {PATH_MISS_MILES, FIELD_MISS_DISTANCE},
+};
+
+// Field names accepted by parse_projected_fields
+const pair<const char*, uint32_t> FIELD_NAMES[] = {
+    {"name", FIELD_NAME},           {"url", FIELD_JPL_URL},           {"magnitude", FIELD_MAGNITUDE},
+    {"diameters", FIELD_DIAMETERS}, {"flags", FIELD_FLAGS},           {"approach_time", FIELD_APPROACH_TIME},
+    {"velocity", FIELD_VELOCITY},   {"miss_distance", FIELD_MISS_DISTANCE}, {"orbiting_body", FIELD_ORBITING_BODY},
+};
+
+string_view unquoted(string_view raw) {
+    if (raw.size() >= 2 && raw.front() == '"') {
+        return raw.substr(1, raw.size() - 2);
+    }
+    return raw;
+}
+
+} // namespace
+
+uint32_t parse_projected_fields(const string& list) {
+    uint32_t fields = 0;
+    stringstream names(list);
+    string name;
+    while (getline(names, name, ',')) {
+        bool known = false;
+        for (const auto& [fieldName, field] : FIELD_NAMES) {
+            if (name == fieldName) {
+                fields |= field;
+                known = true;
+            }
+        }
+        if (!known) {
+            throw invalid_argument("Unknown projected field: " + name);
+        }
+    }
+    return fields;
+}
+
+string sbdb_lookup_url(string_view id) {
+    return "https://ssd.jpl.nasa.gov/tools/sbdb_lookup.html#/?sstr=" + string(id);
+}
+
+bool is_numeric_id(string_view text, uint32_t& id) {
+    if (text.empty() || text.size() > 10 || text[0] == '0') return false;
+    uint64_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<unsigned>(c - '0');
+    }
+    if (value > UINT32_MAX) return false;
+    id = static_cast<uint32_t>(value);
+    return true;
+}
+
+string scaled_decimal_text(int64_t scaled, unsigned scale) {
+    string digits = to_string(scaled < 0 ? -scaled : scaled);
+    if (scale > 0) {
+        if (digits.size() <= scale) digits.insert(0, scale + 1 - digits.size(), '0');
+        digits.insert(digits.size() - scale, 1, '.');
+    }
+    return scaled < 0 ? "-" + digits : digits;
+}
+
+ProjectedCatalog::ProjectedCatalog(ProjectionOptions options) : options_(options), dateFirst_{0} {}
+
+void ProjectedCatalog::add_feed(string_view body) {
+    FeedIndex index(body);
+    FieldExtractor fields(neo_record_paths());
+    vector<string_view> values;
+    for (const auto& date : index.dates()) {
+        uint32_t dateIndex = static_cast<uint32_t>(dates_.size());
+        dates_.emplace_back(date);
+        for (const NeoCursor& neo : index.objects(date)) {
+            fields.extract(neo, values);
+            DecodeError error;
+            if (!check_object(neo, values, error)) {
+                malformed_.push_back(std::move(error));
+                continue;
+            }
+            add_object(values, dateIndex);
+        }
+        dateFirst_.push_back(size());
+    }
+}
+
+// Function to check that the id and the kept fields hold values of their types, so add_object
+// cannot fail halfway
+bool ProjectedCatalog::check_object(const NeoCursor& neo, const vector<string_view>& values, DecodeError& error) const {
+    const vector<string>& paths = neo_record_paths();
+    auto bad = [&](NeoRecordPath path, const char* message) {
+        error = DecodeError{neo.offset_of(values[path]), paths[path], message};
+        return false;
+    };
+    string text;
+    for (const auto& [path, field] : TEXT_FIELDS) {
+        if (keeps(field) && !decode_text(values[path], text)) return bad(path, "Expected a string");
+    }
+    if (!decode_text(values[PATH_ID], text)) return bad(PATH_ID, "Expected a string");
+    if (text.empty()) return bad(PATH_ID, "Missing id");
+    bool flag = false;
+    if (keeps(FIELD_FLAGS)) {
+        if (!decode_flag(values[PATH_HAZARDOUS], flag)) return bad(PATH_HAZARDOUS, "Expected true or false");
+        if (!decode_flag(values[PATH_SENTRY], flag)) return bad(PATH_SENTRY, "Expected true or false");
+    }
+    double number = 0.0;
+    for (const auto& [path, field] : NUMERIC_FIELDS) {
+        if (keeps(field) && !decode_number(values[path], number)) return bad(path, "Invalid number");
+    }
+    if (keeps(FIELD_APPROACH_TIME)) {
+        int64_t epoch = 0;
+        Date date;
+        if (!decode_integer(values[PATH_EPOCH], epoch)) return bad(PATH_EPOCH, "Invalid integer");
+        if (!decode_date(values[PATH_APPROACH_DATE], date)) return bad(PATH_APPROACH_DATE, "Invalid date");
+    }
+    return true;
+}
+
+// Function to store one object's kept fields, checking each rule against the actual value
+void ProjectedCatalog::add_object(const vector<string_view>& values, uint32_t date) {
+    size_t index = size();
+    uint8_t flags = 0;
+    objectDates_.push_back(date);
+
+    string id = decode_text(values[PATH_ID]);
+    uint32_t numericId = 0;
+    if (!is_numeric_id(id, numericId)) {
+        flags |= FLAG_ID_TEXT;
+        explicitText_[explicit_key(index, SLOT_ID)] = id;
+    }
+    ids_.push_back(numericId);
+
+    if (keeps(FIELD_NAME)) {
+        names_ += decode_text(values[PATH_NAME]);
+        nameEnds_.push_back(static_cast<uint32_t>(names_.size()));
+    }
+    if (keeps(FIELD_JPL_URL)) {
+        string url = decode_text(values[PATH_JPL_URL]);
+        if (url != sbdb_lookup_url(id)) {
+            flags |= FLAG_URL_EXPLICIT;
+            explicitText_[explicit_key(index, SLOT_URL)] = url;
+        }
+    }
+    // The diameter rules need H even when H itself is not displayed
+    if (keeps(FIELD_MAGNITUDE | FIELD_DIAMETERS)) {
+        magnitudes_.push_back(decode_number(values[PATH_MAGNITUDE]));
+    }
+    if (keeps(FIELD_DIAMETERS)) {
+        const NeoRecordPath paths[] = {PATH_DIAMETER_KM_MIN, PATH_DIAMETER_KM_MAX, PATH_DIAMETER_M_MIN, PATH_DIAMETER_M_MAX};
+        for (int which = 0; which < 4; ++which) {
+            double actual = decode_number(values[paths[which]]);
+            if (actual != rule_diameter(index, which)) {
+                flags |= FLAG_DIAMETERS_EXPLICIT;
+                explicitNumbers_[explicit_key(index, SLOT_DIAMETER + which)] = actual;
+            }
+        }
+    }
+    if (keeps(FIELD_FLAGS)) {
+        if (decode_flag(values[PATH_HAZARDOUS])) flags |= FLAG_HAZARDOUS;
+        if (decode_flag(values[PATH_SENTRY])) flags |= FLAG_SENTRY;
+    }
+    if (keeps(FIELD_APPROACH_TIME)) {
+        int64_t epoch = decode_integer(values[PATH_EPOCH]);
+        epochs_.push_back(epoch);
+        Date date = decode_date(values[PATH_APPROACH_DATE]);
+        string dateFull = decode_text(values[PATH_APPROACH_DATE_FULL]);
+        if (date != date_of_epoch_ms(epoch) || dateFull != format_approach_time(epoch)) {
+            flags |= FLAG_TIME_EXPLICIT;
+            explicitNumbers_[explicit_key(index, SLOT_DATE)] = date.days;
+            explicitText_[explicit_key(index, SLOT_DATE_FULL)] = dateFull;
+        }
+    }
+
+    const NeoRecordPath decimalPaths[DECIMAL_FIELDS] = {PATH_VELOCITY_KM_S, PATH_VELOCITY_KM_H, PATH_MISS_AU,
+                                                        PATH_MISS_LUNAR,    PATH_MISS_KM,       PATH_MISS_MILES};
+    for (int field = 0; field < DECIMAL_FIELDS; ++field) {
+        bool kept = keeps(field <= VELOCITY_KM_H ? FIELD_VELOCITY : FIELD_MISS_DISTANCE);
+        if (!kept) continue;
+        string_view raw = values[decimalPaths[field]];
+        string_view text = raw == "null" ? string_view() : unquoted(raw);
+        // Plain decimals with at most 18 digits become scaled integers; anything else stays text
+        int64_t scaled = 0;
+        uint8_t scale = 0;
+        size_t digits = 0;
+        bool plain = !text.empty();
+        int64_t magnitude = 0;
+        size_t point = string_view::npos;
+        for (size_t i = (!text.empty() && text[0] == '-') ? 1 : 0; plain && i < text.size(); ++i) {
+            if (text[i] == '.' && point == string_view::npos) {
+                point = i;
+            } else if (text[i] >= '0' && text[i] <= '9' && ++digits <= MAX_DECIMAL_DIGITS) {
+                magnitude = magnitude * 10 + (text[i] - '0');
+            } else {
+                plain = false;
+            }
+        }
+        if (plain && digits > 0) {
+            scaled = text[0] == '-' ? -magnitude : magnitude;
+            scale = static_cast<uint8_t>(point == string_view::npos ? 0 : text.size() - point - 1);
+        }
+        decimalDigits_[field].push_back(scaled);
+        decimalScales_[field].push_back(scale);
+        // The check catches leading zeros, a trailing point, "-0" and the like
+        if (!plain || digits == 0 || decimal_text(static_cast<DecimalField>(field), index) != text) {
+            decimalScales_[field].back() = EXPLICIT_DECIMAL;
+            flags |= FLAG_DECIMAL_EXPLICIT;
+            explicitText_[explicit_key(index, SLOT_DECIMAL + field)] = string(text);
+        }
+    }
+
+    if (keeps(FIELD_ORBITING_BODY)) {
+        string body = decode_text(values[PATH_ORBITING_BODY]);
+        size_t code = 0;
+        while (code < bodyNames_.size() && bodyNames_[code] != body) ++code;
+        if (code == bodyNames_.size()) {
+            if (code > UINT8_MAX) throw invalid_argument("Too many orbiting bodies");
+            bodyNames_.push_back(body);
+        }
+        bodies_.push_back(static_cast<uint8_t>(code));
+    }
+    flags_.push_back(flags);
+}
+
+void ProjectedCatalog::append_day(const ProjectedCatalog& other, size_t date) {
+    uint32_t dateIndex = static_cast<uint32_t>(dates_.size());
+    dates_.push_back(other.dates_[date]);
+    for (size_t i = other.dateFirst_[date]; i < other.dateFirst_[date + 1]; ++i) {
+        copy_object(other, i, dateIndex);
+    }
+    dateFirst_.push_back(size());
+}
+
+void ProjectedCatalog::copy_object(const ProjectedCatalog& other, size_t from, uint32_t date) {
+    size_t index = size();
+    objectDates_.push_back(date);
+    ids_.push_back(other.ids_[from]);
+    flags_.push_back(other.flags_[from]);
+    if (keeps(FIELD_NAME)) {
+        names_.append(other.name(from));
+        nameEnds_.push_back(static_cast<uint32_t>(names_.size()));
+    }
+    if (keeps(FIELD_MAGNITUDE | FIELD_DIAMETERS)) magnitudes_.push_back(other.magnitudes_[from]);
+    if (keeps(FIELD_APPROACH_TIME)) epochs_.push_back(other.epochs_[from]);
+    for (int field = 0; field < DECIMAL_FIELDS; ++field) {
+        if (other.decimalDigits_[field].empty()) continue;
+        decimalDigits_[field].push_back(other.decimalDigits_[field][from]);
+        decimalScales_[field].push_back(other.decimalScales_[field][from]);
+    }
+    if (keeps(FIELD_ORBITING_BODY)) {
+        const string& body = other.bodyNames_[other.bodies_[from]];
+        size_t code = 0;
+        while (code < bodyNames_.size() && bodyNames_[code] != body) ++code;
+        if (code == bodyNames_.size()) {
+            if (code > UINT8_MAX) throw invalid_argument("Too many orbiting bodies");
+            bodyNames_.push_back(body);
+        }
+        bodies_.push_back(static_cast<uint8_t>(code));
+    }
+    if ((other.flags_[from] & ~(FLAG_HAZARDOUS | FLAG_SENTRY)) != 0) {
+        for (int slot = 0; slot < SLOT_DIAMETER + 4; ++slot) {
+            auto text = other.explicitText_.find(explicit_key(from, slot));
+            if (text != other.explicitText_.end()) explicitText_[explicit_key(index, slot)] = text->second;
+            auto number = other.explicitNumbers_.find(explicit_key(from, slot));
+            if (number != other.explicitNumbers_.end()) explicitNumbers_[explicit_key(index, slot)] = number->second;
+        }
+    }
+}
+
+const string& ProjectedCatalog::date_of(size_t index) const {
+    return dates_[objectDates_[index]];
+}
+
+string ProjectedCatalog::id(size_t index) const {
+    if (flags_[index] & FLAG_ID_TEXT) {
+        return explicitText_.at(explicit_key(index, SLOT_ID));
+    }
+    return to_string(ids_[index]);
+}
+
+string_view ProjectedCatalog::name(size_t index) const {
+    if (!keeps(FIELD_NAME)) return string_view();
+    size_t begin = index == 0 ? 0 : nameEnds_[index - 1];
+    return string_view(names_).substr(begin, nameEnds_[index] - begin);
+}
+
+string ProjectedCatalog::nasa_jpl_url(size_t index) const {
+    if (!keeps(FIELD_JPL_URL)) return string();
+    if (flags_[index] & FLAG_URL_EXPLICIT) {
+        return explicitText_.at(explicit_key(index, SLOT_URL));
+    }
+    return sbdb_lookup_url(id(index));
+}
+
+double ProjectedCatalog::absolute_magnitude_h(size_t index) const {
+    return keeps(FIELD_MAGNITUDE) ? magnitudes_[index] : 0.0;
+}
+
+// Function to apply the NeoWs diameter formula D = 1329 km / sqrt(albedo) * 10^(-H/5)
+double ProjectedCatalog::rule_diameter(size_t index, int which) const {
+    double albedo = which % 2 == 0 ? 0.25 : 0.05;
+    double unit = which < 2 ? 1.0 : 1000.0;
+    double diameter = 1329.0 / sqrt(albedo) * pow(10.0, -magnitudes_[index] / 5.0) * unit;
+    return round(diameter * 1e10) / 1e10;
+}
+
+double ProjectedCatalog::diameter(size_t index, int which) const {
+    if (!keeps(FIELD_DIAMETERS)) return 0.0;
+    if (flags_[index] & FLAG_DIAMETERS_EXPLICIT) {
+        auto found = explicitNumbers_.find(explicit_key(index, SLOT_DIAMETER + which));
+        if (found != explicitNumbers_.end()) return found->second;
+    }
+    return rule_diameter(index, which);
+}
+
+bool ProjectedCatalog::is_potentially_hazardous(size_t index) const {
+    return (flags_[index] & FLAG_HAZARDOUS) != 0;
+}
+
+bool ProjectedCatalog::is_sentry_object(size_t index) const {
+    return (flags_[index] & FLAG_SENTRY) != 0;
+}
+
+int64_t ProjectedCatalog::epoch_ms(size_t index) const {
+    return keeps(FIELD_APPROACH_TIME) ? epochs_[index] : 0;
+}
+
+Date ProjectedCatalog::close_approach_day(size_t index) const {
+    if (!keeps(FIELD_APPROACH_TIME)) return Date();
+    if (flags_[index] & FLAG_TIME_EXPLICIT) {
+        return Date(static_cast<int32_t>(explicitNumbers_.at(explicit_key(index, SLOT_DATE))));
+    }
+    return date_of_epoch_ms(epochs_[index]);
+}
+
+string ProjectedCatalog::close_approach_date(size_t index) const {
+    return keeps(FIELD_APPROACH_TIME) ? format_date(close_approach_day(index)) : string();
+}
+
+string ProjectedCatalog::close_approach_date_full(size_t index) const {
+    if (!keeps(FIELD_APPROACH_TIME)) return string();
+    if (flags_[index] & FLAG_TIME_EXPLICIT) {
+        return explicitText_.at(explicit_key(index, SLOT_DATE_FULL));
+    }
+    return format_approach_time(epochs_[index]);
+}
+
+string ProjectedCatalog::orbiting_body(size_t index) const {
+    return keeps(FIELD_ORBITING_BODY) ? bodyNames_[bodies_[index]] : string();
+}
+
+string ProjectedCatalog::decimal_text(DecimalField field, size_t index) const {
+    if (decimalDigits_[field].empty()) return string();
+    int64_t scaled = decimalDigits_[field][index];
+    size_t scale = decimalScales_[field][index];
+    if (scale == EXPLICIT_DECIMAL) {
+        return explicitText_.at(explicit_key(index, SLOT_DECIMAL + field));
+    }
+    return scaled_decimal_text(scaled, scale);
+}
+
+bool ProjectedCatalog::decimal_digits(DecimalField field, size_t index, int64_t& scaled, uint8_t& scale) const {
+    if (decimalDigits_[field].empty() || decimalScales_[field][index] == EXPLICIT_DECIMAL) return false;
+    scaled = decimalDigits_[field][index];
+    scale = decimalScales_[field][index];
+    return true;
+}
+
+double ProjectedCatalog::decimal_value(DecimalField field, size_t index) const {
+    // Through the text, so the value is rounded exactly as decoding the feed rounds it
+    string text = decimal_text(field, index);
+    return decode_number(text);
+}
+
+NeoRecord ProjectedCatalog::record(size_t index) const {
+    NeoRecord record;
+    record.feed_date = date_of(index);
+    record.id = id(index);
+    record.name = string(name(index));
+    record.nasa_jpl_url = nasa_jpl_url(index);
+    record.absolute_magnitude_h = absolute_magnitude_h(index);
+    record.diameter_km_min = diameter_km_min(index);
+    record.diameter_km_max = diameter_km_max(index);
+    record.diameter_m_min = diameter_m_min(index);
+    record.diameter_m_max = diameter_m_max(index);
+    record.is_potentially_hazardous = is_potentially_hazardous(index);
+    record.is_sentry_object = is_sentry_object(index);
+    CloseApproach& approach = record.approach;
+    approach.date = close_approach_day(index);
+    approach.date_full = close_approach_date_full(index);
+    approach.epoch_ms = epoch_ms(index);
+    approach.velocity_km_s = decimal_value(VELOCITY_KM_S, index);
+    approach.velocity_km_h = decimal_value(VELOCITY_KM_H, index);
+    approach.miss_au = decimal_value(MISS_AU, index);
+    approach.miss_lunar = decimal_value(MISS_LUNAR, index);
+    approach.miss_km = decimal_value(MISS_KM, index);
+    approach.miss_miles = decimal_value(MISS_MILES, index);
+    approach.orbiting_body = orbiting_body(index);
+    return record;
+}
+
+size_t ProjectedCatalog::memory_bytes() const {
+    // Rough per-node cost of the explicit tables: node, hash bucket and the value
+    const size_t HASH_NODE_BYTES = 48;
+    size_t bytes = sizeof(*this);
+    for (const auto& date : dates_) bytes += date.capacity();
+    bytes += dateFirst_.capacity() * sizeof(size_t) + objectDates_.capacity() * sizeof(uint32_t);
+    bytes += ids_.capacity() * sizeof(uint32_t) + names_.capacity() + nameEnds_.capacity() * sizeof(uint32_t);
+    bytes += magnitudes_.capacity() * sizeof(double) + flags_.capacity() + epochs_.capacity() * sizeof(int64_t);
+    for (int field = 0; field < DECIMAL_FIELDS; ++field) {
+        bytes += decimalDigits_[field].capacity() * sizeof(int64_t) + decimalScales_[field].capacity();
+    }
+    bytes += bodies_.capacity();
+    for (const auto& body : bodyNames_) bytes += sizeof(string) + body.capacity();
+    for (const auto& [key, text] : explicitText_) bytes += HASH_NODE_BYTES + text.capacity();
+    bytes += explicitNumbers_.size() * HASH_NODE_BYTES;
+    return bytes;
+}
@@ -0,0 +1,153 @@
+#ifndef NEO_PROJECTION_H
+#define NEO_PROJECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "decode_result.h"
+#include "neo_record.h"
+
+class NeoCursor;
+
+// Field groups a projected catalog can keep; everything else in the feed is dropped at ingest
+enum ProjectedField : uint32_t {
+    FIELD_NAME = 1u << 0,
+    FIELD_JPL_URL = 1u << 1,
+    FIELD_MAGNITUDE = 1u << 2,
+    FIELD_DIAMETERS = 1u << 3,      // km and m, min and max
+    FIELD_FLAGS = 1u << 4,          // potentially hazardous, sentry
+    FIELD_APPROACH_TIME = 1u << 5,  // epoch, date, full date
+    FIELD_VELOCITY = 1u << 6,       // km/s, km/h
+    FIELD_MISS_DISTANCE = 1u << 7,  // au, lunar, km, miles
+    FIELD_ORBITING_BODY = 1u << 8,
+    // What output_neo_data and Asteroid print
+    FIELDS_DISPLAYED = (1u << 9) - 1,
+};
+
+// Which fields to keep; the id is always kept
+struct ProjectionOptions {
+    uint32_t fields = FIELDS_DISPLAYED;
+};
+
+// Parses a comma-separated list such as "name,flags,velocity"; throws std::invalid_argument on
+// an unknown name
+uint32_t parse_projected_fields(const std::string& list);
+
+// nasa_jpl_url as NeoWs gives it for an id: the SBDB lookup page
+std::string sbdb_lookup_url(std::string_view id);
+
+// True for an id that is a plain decimal uint32 without leading zeros, as NeoWs ids are; such
+// ids are stored as numbers
+bool is_numeric_id(std::string_view text, uint32_t& id);
+
+// Text of a decimal kept as value * 10^scale, with exactly scale digits after the point
+std::string scaled_decimal_text(int64_t scaled, unsigned scale);
+
+// A catalog of NEOs stored column by column with only the configured fields. Fields the feed
+// repeats or that follow from others are stored as rules and rebuilt on access:
+//   - nasa_jpl_url is the SBDB lookup URL of the id
+//   - the four diameters follow from H with albedo 0.25 (min) and 0.05 (max), rounded to ten
+//     decimals as NeoWs does
+//   - close_approach_date is the UTC day of the epoch and close_approach_date_full its UTC time
+// Every rule is checked against the actual value when the object is added; a value the rule
+// does not reproduce exactly is kept explicitly, so reads always return what the feed said.
+// Numeric strings (velocities, miss distances) are kept as scaled integers, which reproduce
+// the original text digit for digit.
+class ProjectedCatalog {
+public:
+    explicit ProjectedCatalog(ProjectionOptions options = {});
+
+    const ProjectionOptions& options() const { return options_; }
+
+    // Adds every object of a feed document, grouped by date in document order. Objects with a
+    // missing id or a kept field of the wrong type (e.g. a velocity that is not a number) are
+    // skipped and listed in malformed(); broken JSON structure throws JsonStreamError.
+    void add_feed(std::string_view body);
+
+    const std::vector<DecodeError>& malformed() const { return malformed_; }
+
+    // Appends one date and its objects from another catalog with the same options
+    void append_day(const ProjectedCatalog& other, size_t date);
+
+    size_t size() const { return ids_.size(); }
+    const std::vector<std::string>& dates() const { return dates_; }
+
+    // Objects of date i are [date_begin(i), date_begin(i + 1))
+    size_t date_begin(size_t date) const { return dateFirst_[date]; }
+    const std::string& date_of(size_t index) const;
+
+    // Field access; fields that were not kept read as empty / 0 / false
+    std::string id(size_t index) const;
+    std::string_view name(size_t index) const;
+    std::string nasa_jpl_url(size_t index) const;
+    double absolute_magnitude_h(size_t index) const;
+    double diameter_km_min(size_t index) const { return diameter(index, 0); }
+    double diameter_km_max(size_t index) const { return diameter(index, 1); }
+    double diameter_m_min(size_t index) const { return diameter(index, 2); }
+    double diameter_m_max(size_t index) const { return diameter(index, 3); }
+    bool is_potentially_hazardous(size_t index) const;
+    bool is_sentry_object(size_t index) const;
+    int64_t epoch_ms(size_t index) const;
+    Date close_approach_day(size_t index) const;
+    std::string close_approach_date(size_t index) const;
+    std::string close_approach_date_full(size_t index) const;
+    std::string orbiting_body(size_t index) const;
+
+    // Numeric strings exactly as the feed wrote them, and their values
+    enum DecimalField { VELOCITY_KM_S, VELOCITY_KM_H, MISS_AU, MISS_LUNAR, MISS_KM, MISS_MILES, DECIMAL_FIELDS };
+    std::string decimal_text(DecimalField field, size_t index) const;
+    double decimal_value(DecimalField field, size_t index) const;
+
+    // The scaled integer behind decimal_text; false when the field was not kept or its text did
+    // not fit one and is stored as text
+    bool decimal_digits(DecimalField field, size_t index, int64_t& scaled, uint8_t& scale) const;
+
+    // Everything NeoRecord holds, rebuilt from the columns
+    NeoRecord record(size_t index) const;
+
+    // Heap and inline bytes held by the catalog
+    size_t memory_bytes() const;
+
+    // Values the rules did not reproduce and that had to be stored explicitly
+    size_t rule_exceptions() const { return explicitText_.size() + explicitNumbers_.size(); }
+
+private:
+    // Slots in the explicit-value tables for rule and decimal exceptions
+    enum ExplicitSlot { SLOT_ID, SLOT_URL, SLOT_DATE, SLOT_DATE_FULL, SLOT_DECIMAL, SLOT_DIAMETER = SLOT_DECIMAL + DECIMAL_FIELDS };
+
+    // Scale marking a numeric string kept as text
+    static constexpr uint8_t EXPLICIT_DECIMAL = 0xFF;
+
+    static uint64_t explicit_key(size_t index, int slot) { return static_cast<uint64_t>(index) * 32 + slot; }
+    bool keeps(uint32_t field) const { return (options_.fields & field) != 0; }
+    bool check_object(const NeoCursor& neo, const std::vector<std::string_view>& values, DecodeError& error) const;
+    void add_object(const std::vector<std::string_view>& values, uint32_t date);
+    double rule_diameter(size_t index, int which) const;
+    double diameter(size_t index, int which) const;    // km min, km max, m min, m max
+    void copy_object(const ProjectedCatalog& other, size_t index, uint32_t date);
+
+    ProjectionOptions options_;
+    std::vector<std::string> dates_;
+    std::vector<size_t> dateFirst_;          // one more entry than dates_
+    std::vector<uint32_t> objectDates_;
+
+    std::vector<uint32_t> ids_;              // numeric ids; explicit text for the rare others
+    std::string names_;                      // every name back to back
+    std::vector<uint32_t> nameEnds_;         // name i ends at nameEnds_[i]
+    std::vector<double> magnitudes_;
+    std::vector<uint8_t> flags_;
+    std::vector<int64_t> epochs_;
+    std::vector<int64_t> decimalDigits_[DECIMAL_FIELDS];   // value * 10^scale
+    std::vector<uint8_t> decimalScales_[DECIMAL_FIELDS];   // digits after the point
+    std::vector<uint8_t> bodies_;            // index into bodyNames_
+    std::vector<std::string> bodyNames_;
+
+    std::unordered_map<uint64_t, std::string> explicitText_;
+    std::unordered_map<uint64_t, double> explicitNumbers_;
+    std::vector<DecodeError> malformed_;
+};
+
+#endif // NEO_PROJECTION_H
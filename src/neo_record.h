@@ -0,0 +1,70 @@
+#ifndef NEO_RECORD_H
+#define NEO_RECORD_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "calendar.h"
+
+// One close approach of a NEO; the feed reports only the first, /neo/{id} the whole history
+struct CloseApproach {
+    Date date;                     // close_approach_date; 1970-01-01 when missing
+    std::string date_full;         // close_approach_date_full (YYYY-Mon-DD hh:mm)
+    int64_t epoch_ms = 0;          // epoch_date_close_approach
+    double velocity_km_s = 0.0;
+    double velocity_km_h = 0.0;
+    double miss_au = 0.0;
+    double miss_lunar = 0.0;
+    double miss_km = 0.0;
+    double miss_miles = 0.0;
+    std::string orbiting_body;
+};
+
+// Typed view of one entry of near_earth_objects[date]
+struct NeoRecord {
+    std::string feed_date;         // key of the near_earth_objects map the record came from
+    std::string id;
+    std::string name;
+    std::string nasa_jpl_url;
+    double absolute_magnitude_h = 0.0;
+    double diameter_km_min = 0.0;
+    double diameter_km_max = 0.0;
+    double diameter_m_min = 0.0;
+    double diameter_m_max = 0.0;
+    bool is_potentially_hazardous = false;
+    bool is_sentry_object = false;
+    CloseApproach approach;
+};
+
+// CloseApproach with its text fields viewing the document they were decoded from
+struct CloseApproachView {
+    Date date;
+    std::string_view date_full;
+    int64_t epoch_ms = 0;
+    double velocity_km_s = 0.0;
+    double velocity_km_h = 0.0;
+    double miss_au = 0.0;
+    double miss_lunar = 0.0;
+    double miss_km = 0.0;
+    double miss_miles = 0.0;
+    std::string_view orbiting_body;
+};
+
+// NeoRecord with its text fields viewing the document it was decoded from; valid only as long
+// as that document (see MappedFeed)
+struct NeoRecordView {
+    std::string_view feed_date;
+    std::string_view id;
+    std::string_view name;
+    std::string_view nasa_jpl_url;
+    double absolute_magnitude_h = 0.0;
+    double diameter_km_min = 0.0;
+    double diameter_km_max = 0.0;
+    double diameter_m_min = 0.0;
+    double diameter_m_max = 0.0;
+    bool is_potentially_hazardous = false;
+    bool is_sentry_object = false;
+    CloseApproachView approach;
+};
+
+#endif // NEO_RECORD_H
@@ -0,0 +1,152 @@
+#include <iomanip>
+#include <sstream>
+#include "prefetcher.h"
+#include "calendar.h"
+#include "get_data.h"
+
+using namespace std;
+
+namespace {
+
+// Days on either side of the chosen date; together with it they make one feed-sized window
+const long PREFETCH_RADIUS_DAYS = MAX_FEED_WINDOW_DAYS / 2;
+
+} // namespace
+
+Prefetcher::Prefetcher(NeoClient& client) : client_(client), worker_([this] { worker_loop(); }) {}
+
+Prefetcher::~Prefetcher() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cancel();
+    wake_.notify_all();
+    worker_.join();
+}
+
+void Prefetcher::prefetch_around(const string& date) {
+    cancel();
+    {
+        lock_guard<mutex> lock(mutex_);
+        pendingDate_ = date;
+    }
+    wake_.notify_all();
+}
+
+void Prefetcher::cancel() {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    pendingDate_.clear();
+    if (!inFlightUrl_.empty() && client_.scheduler().cancel(inFlightUrl_)) {
+        history_.back().cancelled = true;
+        ++stats_.cancelled;
+    }
+}
+
+void Prefetcher::record_lookup(const string& date) {
+    lock_guard<mutex> lock(mutex_);
+    auto found = unusedDays_.find(date);
+    if (found != unusedDays_.end()) {
+        ++history_[found->second].days_used;
+        ++stats_.days_used;
+        unusedDays_.erase(found);
+    }
+}
+
+PrefetchStats Prefetcher::stats() const {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+vector<PrefetchRecord> Prefetcher::history() const {
+    lock_guard<mutex> lock(mutex_);
+    return history_;
+}
+
+void Prefetcher::worker_loop() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !pendingDate_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        string date = pendingDate_;
+        uint64_t generation = generation_;
+        pendingDate_.clear();
+        lock.unlock();
+        run_prefetch(date, generation);
+        lock.lock();
+    }
+}
+
+// Function to fetch the uncached part of the window around date as one background request
+void Prefetcher::run_prefetch(const string& date, uint64_t generation) {
+    string endpoint = neo_feed_base_url();
+    vector<string> missing;
+    for (long offset = -PREFETCH_RADIUS_DAYS; offset <= PREFETCH_RADIUS_DAYS; ++offset) {
+        string day = add_days(date, offset);
+        if (!client_.cache().contains(endpoint, day)) {
+            missing.push_back(day);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    FeedWindow window{missing.front(), missing.back()};
+    NeoClient::WindowFetch pending;
+    size_t index = 0;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (generation != generation_) {
+            return;   // superseded before it was queued
+        }
+        pending = client_.fetch_window(window, RequestPriority::Background);
+        inFlightUrl_ = pending.url;
+        index = history_.size();
+        history_.push_back({date, window, 0, 0, false});
+        ++stats_.issued;
+    }
+
+    bool stored = false;
+    try {
+        pending.done.get();
+        stored = true;
+    } catch (const exception&) {
+        // Cancelled requests are already counted; anything else counts as a failure below
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    inFlightUrl_.clear();
+    if (stored) {
+        history_[index].days_fetched = missing.size();
+        stats_.days_fetched += missing.size();
+        for (const auto& day : missing) {
+            unusedDays_[day] = index;
+        }
+    } else if (!history_[index].cancelled) {
+        ++stats_.failed;
+    }
+}
+
+string format_prefetch_report(const PrefetchStats& stats, const vector<PrefetchRecord>& history, bool perPrefetch) {
+    ostringstream out;
+    double usedPercent = stats.days_fetched == 0 ? 0.0 : 100.0 * stats.days_used / stats.days_fetched;
+    out << "Prefetch: " << stats.issued << " requests (" << stats.cancelled << " cancelled, " << stats.failed
+        << " failed), " << stats.days_used << " of " << stats.days_fetched << " prefetched days used ("
+        << fixed << setprecision(1) << usedPercent << "%)." << endl;
+    if (perPrefetch) {
+        for (const auto& record : history) {
+            out << "  around " << record.anchor_date << ": " << record.window.start_date << " to "
+                << record.window.end_date << ", ";
+            if (record.cancelled) {
+                out << "cancelled";
+            } else {
+                out << record.days_used << "/" << record.days_fetched << " days used";
+            }
+            out << endl;
+        }
+    }
+    return out.str();
+}
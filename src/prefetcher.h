@@ -0,0 +1,77 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "neo_client.h"
+
+// One prefetch issued by a Prefetcher and how much of it was used
+struct PrefetchRecord {
+    std::string anchor_date;    // date the user chose
+    FeedWindow window;          // range actually requested
+    size_t days_fetched = 0;
+    size_t days_used = 0;       // fetched days later looked up
+    bool cancelled = false;
+};
+
+// Totals over every prefetch of a session
+struct PrefetchStats {
+    uint64_t issued = 0;
+    uint64_t cancelled = 0;
+    uint64_t failed = 0;
+    uint64_t days_fetched = 0;
+    uint64_t days_used = 0;
+};
+
+// Pulls the 7-day window around a chosen date into the cache while the user is busy with the
+// menus, so the next lookup of a nearby date is served locally. Requests are NeoClient window
+// fetches at background priority: they never eat into the interactive reserve of the rate limit,
+// and a lookup of a day still being prefetched waits for that request instead of sending another.
+// A new prefetch, or cancel(), drops a request that has not started yet.
+class Prefetcher {
+public:
+    explicit Prefetcher(NeoClient& client);
+    ~Prefetcher();
+
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+
+    // Starts fetching the uncached days of [date - 3, date + 3] in the background; returns at once
+    void prefetch_around(const std::string& date);
+
+    // Drops the queued prefetch, if any; a transfer already on the wire still completes
+    void cancel();
+
+    // Tells the prefetcher a date was looked up, so prefetched days are counted as used
+    void record_lookup(const std::string& date);
+
+    PrefetchStats stats() const;
+    std::vector<PrefetchRecord> history() const;
+
+private:
+    void worker_loop();
+    void run_prefetch(const std::string& date, uint64_t generation);
+
+    NeoClient& client_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::string pendingDate_;                 // next date to prefetch around ("" = none)
+    std::string inFlightUrl_;                 // queued request of the running prefetch
+    uint64_t generation_ = 0;                 // bumped by every prefetch_around and cancel
+    std::vector<PrefetchRecord> history_;
+    std::map<std::string, size_t> unusedDays_;   // prefetched date -> index into history_
+    PrefetchStats stats_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+// Renders a one-line usage summary and, when perPrefetch is set, one line per prefetch
+std::string format_prefetch_report(const PrefetchStats& stats, const std::vector<PrefetchRecord>& history,
+                                   bool perPrefetch);
+
+#endif // PREFETCHER_H
@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include "request_scheduler.h"
+#include "get_data.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+namespace {
+
+double elapsed_ms(Clock::time_point since) {
+    return chrono::duration<double, milli>(Clock::now() - since).count();
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TokenBucket
+
+TokenBucket::TokenBucket(double capacity, double refillPerSecond)
+    : capacity_(capacity), refillPerSecond_(refillPerSecond), tokens_(capacity), lastRefill_(Clock::now()) {}
+
+void TokenBucket::refill() {
+    Clock::time_point now = Clock::now();
+    double seconds = chrono::duration<double>(now - lastRefill_).count();
+    tokens_ = min(capacity_, tokens_ + seconds * refillPerSecond_);
+    lastRefill_ = now;
+}
+
+bool TokenBucket::try_take(double reserve) {
+    refill();
+    if (tokens_ - reserve >= 1.0) {
+        tokens_ -= 1.0;
+        return true;
+    }
+    return false;
+}
+
+Clock::duration TokenBucket::time_until_available(double reserve) {
+    refill();
+    double missing = reserve + 1.0 - tokens_;
+    if (missing <= 0.0) {
+        return Clock::duration::zero();
+    }
+    if (refillPerSecond_ <= 0.0) {
+        return chrono::hours(1);
+    }
+    return chrono::duration_cast<Clock::duration>(chrono::duration<double>(missing / refillPerSecond_));
+}
+
+void TokenBucket::sync(const RateLimitInfo& info) {
+    refill();
+    if (info.remaining >= 0) {
+        tokens_ = min(tokens_, static_cast<double>(info.remaining));
+    }
+}
+
+void TokenBucket::drain() {
+    refill();
+    tokens_ = 0.0;
+}
+
+double TokenBucket::tokens() {
+    refill();
+    return tokens_;
+}
+
+// ---------------------------------------------------------------------------
+// RequestScheduler
+
+RequestScheduler::RequestScheduler(NeoFetcher& fetcher, const SchedulerOptions& options)
+    : fetcher_(fetcher), options_(options) {
+    workers_.emplace_back(&RequestScheduler::worker_loop, this, true);
+    for (size_t i = 0; i < options_.background_workers; ++i) {
+        workers_.emplace_back(&RequestScheduler::worker_loop, this, false);
+    }
+}
+
+RequestScheduler::~RequestScheduler() {
+    deque<Job> pending;
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto* queue : {&interactive_, &background_}) {
+            for (auto& job : *queue) pending.push_back(std::move(job));
+            queue->clear();
+        }
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    for (auto& job : pending) {
+        job.settle(FetchResult(), make_exception_ptr(ApiRequestException("Request scheduler stopped")));
+    }
+}
+
+TokenBucket& RequestScheduler::bucket_for(const string& apiKey) {
+    auto found = buckets_.find(apiKey);
+    if (found == buckets_.end()) {
+        found = buckets_.emplace(apiKey, TokenBucket(options_.bucket_capacity, options_.refill_per_second)).first;
+    }
+    return found->second;
+}
+
+void RequestScheduler::record_wait(const Job& job) {
+    double waited = elapsed_ms(job.enqueued);
+    if (job.priority == RequestPriority::Interactive) {
+        metrics_.interactive_wait_ms_total += waited;
+        metrics_.interactive_wait_ms_max = max(metrics_.interactive_wait_ms_max, waited);
+    } else {
+        metrics_.background_wait_ms_total += waited;
+        metrics_.background_wait_ms_max = max(metrics_.background_wait_ms_max, waited);
+    }
+}
+
+void RequestScheduler::Job::settle(FetchResult result, exception_ptr error) {
+    if (error) {
+        promise.set_exception(error);
+    } else {
+        promise.set_value(std::move(result));
+    }
+    if (onDone) {
+        onDone();
+    }
+}
+
+future<FetchResult> RequestScheduler::submit(const string& url, const string& apiKey, RequestPriority priority,
+                                             ChunkSink onChunk, function<void()> onDone) {
+    Job job{url, apiKey, priority, Clock::now(), 0, promise<FetchResult>(), std::move(onChunk), std::move(onDone)};
+    future<FetchResult> result = job.promise.get_future();
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (stopping_) {
+            throw ApiRequestException("Request scheduler stopped");
+        }
+        (priority == RequestPriority::Interactive ? interactive_ : background_).push_back(std::move(job));
+    }
+    wake_.notify_all();
+    return result;
+}
+
+FetchResult RequestScheduler::fetch(const string& url, const string& apiKey, RequestPriority priority) {
+    return submit(url, apiKey, priority).get();
+}
+
+vector<FetchResult> RequestScheduler::fetch_batch(const vector<string>& urls, const string& apiKey,
+                                                  RequestPriority priority) {
+    vector<future<FetchResult>> pending;
+    pending.reserve(urls.size());
+    for (const auto& url : urls) {
+        pending.push_back(submit(url, apiKey, priority));
+    }
+    vector<FetchResult> results;
+    results.reserve(urls.size());
+    for (auto& result : pending) {
+        results.push_back(result.get());
+    }
+    return results;
+}
+
+// Function to take tokens for transfers that run outside the queues, waiting while the bucket is dry
+void RequestScheduler::take_tokens(const string& apiKey, RequestPriority priority, size_t count) {
+    double reserve = priority == RequestPriority::Interactive ? 0.0 : options_.interactive_reserve;
+    unique_lock<mutex> lock(mutex_);
+    TokenBucket& bucket = bucket_for(apiKey);
+    while (count > 0) {
+        if (stopping_) {
+            throw ApiRequestException("Request scheduler stopped");
+        }
+        if (bucket.try_take(reserve)) {
+            throttled_ = false;
+            --count;
+            continue;
+        }
+        if (!throttled_) {
+            throttled_ = true;
+            ++metrics_.throttle_events;
+        }
+        wake_.wait_until(lock, Clock::now() + bucket.time_until_available(reserve));
+    }
+}
+
+vector<FetchResult> RequestScheduler::fetch_all(const vector<string>& urls, const string& apiKey,
+                                                RequestPriority priority, int maxConcurrent) {
+    vector<FetchResult> results(urls.size());
+    vector<size_t> pending;
+    for (size_t i = 0; i < urls.size(); ++i) {
+        pending.push_back(i);
+    }
+
+    for (int attempt = 0; !pending.empty(); ++attempt) {
+        take_tokens(apiKey, priority, pending.size());
+        vector<string> batch;
+        for (size_t i : pending) {
+            batch.push_back(urls[i]);
+        }
+        vector<FetchResult> fetched = fetcher_.fetch_all(batch, maxConcurrent);
+
+        vector<size_t> retry;
+        lock_guard<mutex> lock(mutex_);
+        for (size_t k = 0; k < pending.size(); ++k) {
+            FetchResult& result = fetched[k];
+            bucket_for(apiKey).sync(result.rate_limit);
+            if (result.rate_limit.remaining >= 0) {
+                metrics_.last_remaining = result.rate_limit.remaining;
+            }
+            if (result.status == 429) {
+                ++metrics_.throttle_events;
+                bucket_for(apiKey).drain();
+                if (attempt < options_.max_retries) {
+                    retry.push_back(pending[k]);
+                    continue;
+                }
+            }
+            if (priority == RequestPriority::Interactive) {
+                ++metrics_.interactive_completed;
+            } else {
+                ++metrics_.background_completed;
+            }
+            results[pending[k]] = std::move(result);
+        }
+        pending.swap(retry);
+    }
+    return results;
+}
+
+size_t RequestScheduler::cancel_background() {
+    deque<Job> cancelled;
+    {
+        lock_guard<mutex> lock(mutex_);
+        cancelled.swap(background_);
+    }
+    for (auto& job : cancelled) {
+        job.settle(FetchResult(), make_exception_ptr(ApiRequestException("Request cancelled: " + job.url)));
+    }
+    return cancelled.size();
+}
+
+bool RequestScheduler::cancel(const string& url) {
+    Job job;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto found = find_if(background_.begin(), background_.end(), [&](const Job& queued) { return queued.url == url; });
+        if (found == background_.end()) {
+            return false;
+        }
+        job = std::move(*found);
+        background_.erase(found);
+    }
+    job.settle(FetchResult(), make_exception_ptr(ApiRequestException("Request cancelled: " + job.url)));
+    return true;
+}
+
+bool RequestScheduler::promote(const string& url) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto found = find_if(background_.begin(), background_.end(), [&](const Job& queued) { return queued.url == url; });
+        if (found == background_.end()) {
+            return false;
+        }
+        found->priority = RequestPriority::Interactive;
+        interactive_.push_back(std::move(*found));
+        background_.erase(found);
+    }
+    wake_.notify_all();
+    return true;
+}
+
+SchedulerMetrics RequestScheduler::metrics() const {
+    lock_guard<mutex> lock(mutex_);
+    SchedulerMetrics snapshot = metrics_;
+    snapshot.interactive_queue_depth = interactive_.size();
+    snapshot.background_queue_depth = background_.size();
+    return snapshot;
+}
+
+// Function run by every worker thread: pick the most urgent job the rate limit allows, run it
+void RequestScheduler::worker_loop(bool interactiveOnly) {
+    unique_lock<mutex> lock(mutex_);
+    while (!stopping_) {
+        Job job;
+        bool found = false;
+        bool throttled = false;
+        Clock::time_point retryAt = Clock::time_point::max();
+
+        for (auto* queue : {&interactive_, &background_}) {
+            if (queue == &background_ && interactiveOnly) break;
+            double reserve = queue == &interactive_ ? 0.0 : options_.interactive_reserve;
+            vector<const string*> blockedKeys;
+            for (auto it = queue->begin(); it != queue->end(); ++it) {
+                if (any_of(blockedKeys.begin(), blockedKeys.end(), [&](const string* key) { return *key == it->apiKey; })) {
+                    continue;
+                }
+                TokenBucket& bucket = bucket_for(it->apiKey);
+                if (bucket.try_take(reserve)) {
+                    job = std::move(*it);
+                    queue->erase(it);
+                    found = true;
+                    break;
+                }
+                blockedKeys.push_back(&it->apiKey);
+                retryAt = min(retryAt, Clock::now() + bucket.time_until_available(reserve));
+                throttled = true;
+            }
+            if (found) break;
+        }
+
+        if (!found) {
+            if (throttled) {
+                // Counted once as the bucket runs dry, not on every wakeup of every waiting worker
+                if (!throttled_) {
+                    throttled_ = true;
+                    ++metrics_.throttle_events;
+                }
+                wake_.wait_until(lock, retryAt);
+            } else {
+                wake_.wait(lock);
+            }
+            continue;
+        }
+
+        throttled_ = false;
+        record_wait(job);
+        lock.unlock();
+        FetchResult result;
+        exception_ptr error;
+        try {
+            if (job.onChunk) {
+                // Only a 200 body reaches the sink, so a 429 below can still be retried
+                StreamSink sink{job.onChunk, nullptr};
+                result = fetcher_.fetch_streaming(job.url, sink);
+            } else {
+                result = fetcher_.fetch(job.url);
+            }
+        } catch (...) {
+            error = current_exception();
+        }
+        lock.lock();
+
+        if (!error) {
+            bucket_for(job.apiKey).sync(result.rate_limit);
+            if (result.rate_limit.remaining >= 0) {
+                metrics_.last_remaining = result.rate_limit.remaining;
+            }
+            if (result.status == 429) {
+                ++metrics_.throttle_events;
+                bucket_for(job.apiKey).drain();
+                if (++job.attempts <= options_.max_retries) {
+                    // Back to the head of its queue; it runs again once the bucket refills
+                    job.enqueued = Clock::now();
+                    (job.priority == RequestPriority::Interactive ? interactive_ : background_).push_front(std::move(job));
+                    continue;
+                }
+            }
+        }
+        if (job.priority == RequestPriority::Interactive) {
+            ++metrics_.interactive_completed;
+        } else {
+            ++metrics_.background_completed;
+        }
+
+        lock.unlock();
+        job.settle(std::move(result), error);
+        lock.lock();
+    }
+}
+
+string format_metrics(const SchedulerMetrics& metrics) {
+    ostringstream out;
+    out << "neo_scheduler_queue_depth{priority=\"interactive\"} " << metrics.interactive_queue_depth << "\n"
+        << "neo_scheduler_queue_depth{priority=\"background\"} " << metrics.background_queue_depth << "\n"
+        << "neo_scheduler_completed_total{priority=\"interactive\"} " << metrics.interactive_completed << "\n"
+        << "neo_scheduler_completed_total{priority=\"background\"} " << metrics.background_completed << "\n"
+        << "neo_scheduler_wait_ms_sum{priority=\"interactive\"} " << metrics.interactive_wait_ms_total << "\n"
+        << "neo_scheduler_wait_ms_sum{priority=\"background\"} " << metrics.background_wait_ms_total << "\n"
+        << "neo_scheduler_wait_ms_max{priority=\"interactive\"} " << metrics.interactive_wait_ms_max << "\n"
+        << "neo_scheduler_wait_ms_max{priority=\"background\"} " << metrics.background_wait_ms_max << "\n"
+        << "neo_scheduler_throttle_events_total " << metrics.throttle_events << "\n"
+        << "neo_ratelimit_remaining " << metrics.last_remaining << "\n";
+    return out.str();
+}
+
+SchedulerOptions scheduler_options_from_env() {
+    SchedulerOptions options;
+    if (const char* workers = getenv("NEO_BACKGROUND_WORKERS")) {
+        long count = strtol(workers, nullptr, 10);
+        if (count > 0) options.background_workers = static_cast<size_t>(count);
+    }
+    return options;
+}
@@ -0,0 +1,157 @@
+#ifndef REQUEST_SCHEDULER_H
+#define REQUEST_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "neo_fetcher.h"
+
+// Receives a response body chunk by chunk while it downloads
+using ChunkSink = std::function<void(const char*, size_t)>;
+
+// Interactive lookups (a date typed by the user) always go ahead of background work (backfills)
+enum class RequestPriority { Interactive, Background };
+
+// Token bucket tracking how many requests an API key may still make. The server's
+// X-RateLimit-Remaining header is authoritative and pulls the local estimate down.
+class TokenBucket {
+public:
+    TokenBucket(double capacity, double refillPerSecond);
+
+    // Takes one token if more than `reserve` tokens are left
+    bool try_take(double reserve = 0.0);
+
+    // Time until a token above `reserve` becomes available
+    std::chrono::steady_clock::duration time_until_available(double reserve = 0.0);
+
+    // Applies the rate-limit headers of a response
+    void sync(const RateLimitInfo& info);
+
+    // Empties the bucket, e.g. after an HTTP 429
+    void drain();
+
+    double tokens();
+
+private:
+    void refill();
+
+    double capacity_;
+    double refillPerSecond_;
+    double tokens_;
+    std::chrono::steady_clock::time_point lastRefill_;
+};
+
+// Settings for a RequestScheduler. The defaults match NASA's standard key: 1000 requests per hour.
+struct SchedulerOptions {
+    double bucket_capacity = 1000.0;
+    double refill_per_second = 1000.0 / 3600.0;
+    double interactive_reserve = 10.0;   // tokens background work may never consume
+    size_t background_workers = 2;
+    int max_retries = 3;                 // retries of a request rejected with HTTP 429
+};
+
+// Snapshot of the scheduler's queue and throttling counters
+struct SchedulerMetrics {
+    size_t interactive_queue_depth = 0;
+    size_t background_queue_depth = 0;
+    uint64_t interactive_completed = 0;
+    uint64_t background_completed = 0;
+    double interactive_wait_ms_total = 0.0;
+    double background_wait_ms_total = 0.0;
+    double interactive_wait_ms_max = 0.0;
+    double background_wait_ms_max = 0.0;
+    uint64_t throttle_events = 0;        // times the bucket ran dry and requests had to wait, plus HTTP 429 responses
+    long last_remaining = -1;            // most recent X-RateLimit-Remaining seen
+};
+
+// Rate-limit-aware request queue in front of a NeoFetcher. Keeps one token bucket per API key
+// and two priority classes. A dedicated worker serves only interactive requests, so they never
+// wait behind bulk transfers, and background requests leave a reserve of tokens untouched.
+class RequestScheduler {
+public:
+    explicit RequestScheduler(NeoFetcher& fetcher, const SchedulerOptions& options = SchedulerOptions());
+    ~RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    // Queues a GET; the future carries the result or the transfer's exception. With onChunk set,
+    // a 200 body is handed to it as it downloads and the result's body stays empty. onDone runs
+    // right after the future becomes ready, however the request ended, so a caller can wait for
+    // the first of several requests without polling.
+    std::future<FetchResult> submit(const std::string& url, const std::string& apiKey, RequestPriority priority,
+                                    ChunkSink onChunk = nullptr, std::function<void()> onDone = nullptr);
+
+    // Queues a GET and waits for it
+    FetchResult fetch(const std::string& url, const std::string& apiKey, RequestPriority priority);
+
+    // Queues all URLs at once and waits for every result (in URL order)
+    std::vector<FetchResult> fetch_batch(const std::vector<std::string>& urls, const std::string& apiKey,
+                                         RequestPriority priority);
+
+    // Runs all URLs through the fetcher's curl_multi loop, at most maxConcurrent transfers at a
+    // time, for bulk range fetches. Each URL takes a token first, waiting while the bucket is dry as
+    // a queued request would, and a URL answered with HTTP 429 is sent again once it refills.
+    // Results come back in URL order with their HTTP status; transport errors throw.
+    std::vector<FetchResult> fetch_all(const std::vector<std::string>& urls, const std::string& apiKey,
+                                       RequestPriority priority, int maxConcurrent);
+
+    // Drops queued background requests; their futures fail with ApiRequestException
+    size_t cancel_background();
+
+    // Drops one queued background request for url; false when it already started or finished
+    bool cancel(const std::string& url);
+
+    // Moves a queued background request for url to the interactive queue, for when an interactive
+    // lookup is waiting on it; false when none is queued
+    bool promote(const std::string& url);
+
+    SchedulerMetrics metrics() const;
+
+private:
+    struct Job {
+        std::string url;
+        std::string apiKey;
+        RequestPriority priority;
+        std::chrono::steady_clock::time_point enqueued;
+        int attempts;
+        std::promise<FetchResult> promise;
+        ChunkSink onChunk;
+        std::function<void()> onDone;
+
+        void settle(FetchResult result, std::exception_ptr error);
+    };
+
+    void worker_loop(bool interactiveOnly);
+    TokenBucket& bucket_for(const std::string& apiKey);
+    void take_tokens(const std::string& apiKey, RequestPriority priority, size_t count);
+    void record_wait(const Job& job);
+
+    NeoFetcher& fetcher_;
+    SchedulerOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job> interactive_;
+    std::deque<Job> background_;
+    std::map<std::string, TokenBucket> buckets_;
+    SchedulerMetrics metrics_;
+    bool throttled_ = false;             // a worker is waiting for the bucket to refill
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+// Renders metrics in the Prometheus text exposition format
+std::string format_metrics(const SchedulerMetrics& metrics);
+
+// Scheduler options with the background worker count taken from NEO_BACKGROUND_WORKERS
+SchedulerOptions scheduler_options_from_env();
+
+#endif // REQUEST_SCHEDULER_H
@@ -0,0 +1,371 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "response_cache.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Version 2 entries hold a zlib stream; older uncompressed entries read as misses
+const char CACHE_MAGIC[] = "NEOCACHE2";
+const char NEGATIVE_MAGIC[] = "NEONONE1";
+const size_t INFLATE_CHUNK = 64 * 1024;
+
+int64_t now_seconds() {
+    return static_cast<int64_t>(time(nullptr));
+}
+
+// FNV-1a, 64 bit
+uint64_t fnv1a(const string& data, uint64_t hash = 1469598103934665603ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+string cache_key(const string& endpoint, const string& date) {
+    return endpoint + '\n' + date;
+}
+
+// Reads the entry header ("NEOCACHE2 <stored_at> <raw_size>", then the key line) and leaves the
+// stream at the start of the compressed body
+bool read_header(istream& file, const string& endpoint, const string& date, int64_t& storedAt, size_t& rawSize) {
+    string magic, storedKey;
+    return file >> magic >> storedAt >> rawSize && magic == CACHE_MAGIC && file.ignore() &&
+           getline(file, storedKey) && storedKey == endpoint + ' ' + date;
+}
+
+// Temporary name next to finalPath for the calling thread of this process, so concurrent writers
+// of the same entry never share one file before the rename. Thread ids repeat across processes
+// sharing the cache directory, so a random per-process token comes first.
+string temporary_path(const string& finalPath) {
+    static const uint64_t processToken = (static_cast<uint64_t>(random_device{}()) << 32) ^ random_device{}();
+    ostringstream name;
+    name << finalPath << ".tmp." << hex << processToken << dec << '.' << this_thread::get_id();
+    return name.str();
+}
+
+string deflate_body(const string& body) {
+    uLongf size = compressBound(static_cast<uLong>(body.size()));
+    string compressed(size, '\0');
+    int rc = compress2(reinterpret_cast<Bytef*>(&compressed[0]), &size,
+                       reinterpret_cast<const Bytef*>(body.data()), static_cast<uLong>(body.size()), Z_DEFAULT_COMPRESSION);
+    if (rc != Z_OK) {
+        throw runtime_error("zlib compression failed");
+    }
+    compressed.resize(size);
+    return compressed;
+}
+
+// Function to inflate the rest of a file chunk by chunk; returns false on a corrupt stream
+bool inflate_stream(istream& in, const function<void(const char*, size_t)>& onChunk) {
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    vector<char> input(INFLATE_CHUNK);
+    vector<char> output(INFLATE_CHUNK);
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END) {
+        in.read(input.data(), static_cast<streamsize>(input.size()));
+        stream.avail_in = static_cast<uInt>(in.gcount());
+        if (stream.avail_in == 0) break;
+        stream.next_in = reinterpret_cast<Bytef*>(input.data());
+        do {
+            stream.avail_out = static_cast<uInt>(output.size());
+            stream.next_out = reinterpret_cast<Bytef*>(output.data());
+            rc = inflate(&stream, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+                inflateEnd(&stream);
+                return false;
+            }
+            size_t produced = output.size() - stream.avail_out;
+            if (produced > 0) {
+                onChunk(output.data(), produced);
+            }
+        } while (stream.avail_out == 0 && rc != Z_STREAM_END);
+    }
+    inflateEnd(&stream);
+    return rc == Z_STREAM_END;
+}
+
+} // namespace
+
+ResponseCache::ResponseCache(const CacheOptions& options) : options_(options) {
+    error_code ec;
+    fs::create_directories(options_.directory, ec);
+    if (ec) {
+        cerr << "Could not create cache directory " << options_.directory << ": " << ec.message() << endl;
+    }
+}
+
+string ResponseCache::key_digest(const string& endpoint, const string& date) {
+    // Two independent 64-bit hashes keep accidental collisions out of reach; the key is
+    // also stored in the entry header and checked on read
+    string key = cache_key(endpoint, date);
+    char buffer[33];
+    snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+             static_cast<unsigned long long>(fnv1a(key)),
+             static_cast<unsigned long long>(fnv1a(key, 0x84222325cbf29ce4ULL)));
+    return buffer;
+}
+
+string ResponseCache::path_for(const string& digest) const {
+    return (fs::path(options_.directory) / (digest + ".json")).string();
+}
+
+string ResponseCache::negative_path_for(const string& digest) const {
+    return (fs::path(options_.directory) / (digest + ".none")).string();
+}
+
+bool ResponseCache::is_fresh(int64_t storedAt, bool permanent) const {
+    return permanent || now_seconds() - storedAt < options_.ttl.count();
+}
+
+// Function to insert an entry at the front of the LRU, evicting the oldest ones
+void ResponseCache::remember(const string& key, string body, int64_t storedAt, bool permanent) {
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        lru_.erase(found->second);
+        index_.erase(found);
+    }
+    lru_.push_front({key, std::move(body), storedAt, permanent});
+    index_[key] = lru_.begin();
+    while (lru_.size() > options_.memory_entries) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
+
+// Function to find an entry in either tier and hand its verified body to onChunk
+bool ResponseCache::lookup(const string& endpoint, const string& date,
+                           const function<void(const char*, size_t)>& onChunk, bool allowStale) {
+    string key = cache_key(endpoint, date);
+    bool permanent = is_past_date(date);
+    {
+        unique_lock<mutex> lock(mutex_);
+        auto found = index_.find(key);
+        if (found != index_.end()) {
+            bool fresh = is_fresh(found->second->stored_at, permanent);
+            if (fresh || allowStale) {
+                lru_.splice(lru_.begin(), lru_, found->second);
+                ++(fresh ? stats_.memory_hits : stats_.stale_hits);
+                string body = found->second->body;
+                lock.unlock();
+                onChunk(body.data(), body.size());
+                return true;
+            }
+            lru_.erase(found->second);
+            index_.erase(found);
+        }
+    }
+
+    ifstream file(path_for(key_digest(endpoint, date)), ios::binary);
+    int64_t storedAt = 0;
+    size_t rawSize = 0;
+    if (read_header(file, endpoint, date, storedAt, rawSize)) {
+        bool fresh = is_fresh(storedAt, permanent);
+        if (!fresh && !allowStale) {
+            lock_guard<mutex> lock(mutex_);
+            ++stats_.expired;
+            ++stats_.misses;
+            return false;
+        }
+        // The whole entry is inflated and checked before any of it reaches onChunk, so a consumer
+        // never sees part of a body that turns out to be corrupt
+        string body;
+        body.reserve(rawSize);
+        bool intact = inflate_stream(file, [&](const char* data, size_t size) { body.append(data, size); });
+        if (intact && body.size() == rawSize) {
+            {
+                lock_guard<mutex> lock(mutex_);
+                ++(fresh ? stats_.disk_hits : stats_.stale_hits);
+                remember(key, body, storedAt, permanent);
+            }
+            onChunk(body.data(), body.size());
+            return true;
+        }
+        lock_guard<mutex> lock(mutex_);
+        cerr << "Ignoring corrupt cache entry for " << date << endl;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    ++stats_.misses;
+    return false;
+}
+
+optional<string> ResponseCache::get(const string& endpoint, const string& date) {
+    string body;
+    bool found = lookup(endpoint, date, [&](const char* data, size_t size) { body.append(data, size); });
+    if (!found) {
+        return nullopt;
+    }
+    return body;
+}
+
+optional<string> ResponseCache::get_stale(const string& endpoint, const string& date) {
+    string body;
+    bool found = lookup(endpoint, date, [&](const char* data, size_t size) { body.append(data, size); }, true);
+    if (!found) {
+        return nullopt;
+    }
+    return body;
+}
+
+bool ResponseCache::stream(const string& endpoint, const string& date,
+                           const function<void(const char*, size_t)>& onChunk) {
+    return lookup(endpoint, date, onChunk);
+}
+
+bool ResponseCache::contains(const string& endpoint, const string& date) {
+    bool permanent = is_past_date(date);
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto found = index_.find(cache_key(endpoint, date));
+        if (found != index_.end() && is_fresh(found->second->stored_at, permanent)) {
+            return true;
+        }
+    }
+    ifstream file(path_for(key_digest(endpoint, date)), ios::binary);
+    int64_t storedAt = 0;
+    size_t rawSize = 0;
+    return read_header(file, endpoint, date, storedAt, rawSize) && is_fresh(storedAt, permanent);
+}
+
+size_t ResponseCache::put(const string& endpoint, const string& date, const string& body) {
+    int64_t storedAt = now_seconds();
+    string digest = key_digest(endpoint, date);
+    string finalPath = path_for(digest);
+    string compressed = deflate_body(body);
+
+    // Write next to the final location and rename into place so readers never see a partial file
+    string tmpName = temporary_path(finalPath);
+    ostringstream header;
+    header << CACHE_MAGIC << ' ' << storedAt << ' ' << body.size() << '\n' << endpoint << ' ' << date << '\n';
+    size_t diskSize = header.str().size() + compressed.size();
+    {
+        ofstream file(tmpName, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cerr << "Could not write cache entry " << tmpName << endl;
+            return 0;
+        }
+        file << header.str();
+        file.write(compressed.data(), static_cast<streamsize>(compressed.size()));
+        if (!file) {
+            cerr << "Could not write cache entry " << tmpName << endl;
+            return 0;
+        }
+    }
+    error_code ec;
+    fs::rename(tmpName, finalPath, ec);
+    if (ec) {
+        fs::remove(tmpName, ec);
+        return 0;
+    }
+
+    // Fresh data supersedes a remembered empty result
+    fs::remove(negative_path_for(digest), ec);
+
+    lock_guard<mutex> lock(mutex_);
+    negatives_.erase(cache_key(endpoint, date));
+    ++stats_.stores;
+    stats_.raw_bytes_stored += body.size();
+    stats_.disk_bytes_stored += diskSize;
+    remember(cache_key(endpoint, date), body, storedAt, is_past_date(date));
+    return diskSize;
+}
+
+// Function to record an empty result in memory and in a small marker file next to the entries
+void ResponseCache::put_negative(const string& endpoint, const string& date) {
+    int64_t storedAt = now_seconds();
+    string finalPath = negative_path_for(key_digest(endpoint, date));
+    string tmpPath = temporary_path(finalPath);
+    {
+        ofstream file(tmpPath, ios::trunc);
+        if (file.is_open()) {
+            file << NEGATIVE_MAGIC << ' ' << storedAt << '\n' << endpoint << ' ' << date << '\n';
+        }
+    }
+    error_code ec;
+    fs::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    negatives_[cache_key(endpoint, date)] = storedAt;
+}
+
+bool ResponseCache::is_negative(const string& endpoint, const string& date) {
+    string key = cache_key(endpoint, date);
+    int64_t storedAt = -1;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto found = negatives_.find(key);
+        if (found != negatives_.end()) {
+            storedAt = found->second;
+        }
+    }
+    if (storedAt < 0) {
+        ifstream file(negative_path_for(key_digest(endpoint, date)));
+        string magic, storedKey;
+        if (!(file >> magic >> storedAt) || magic != NEGATIVE_MAGIC || !file.ignore() || !getline(file, storedKey) ||
+            storedKey != endpoint + ' ' + date) {
+            return false;
+        }
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    if (now_seconds() - storedAt >= options_.negative_ttl.count()) {
+        negatives_.erase(key);
+        return false;
+    }
+    negatives_[key] = storedAt;
+    ++stats_.negative_hits;
+    return true;
+}
+
+CacheStats ResponseCache::stats() const {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+CacheOptions cache_options_from_env() {
+    CacheOptions options;
+    if (const char* dir = getenv("NEO_CACHE_DIR")) {
+        if (*dir) options.directory = dir;
+    }
+    if (const char* ttl = getenv("NEO_CACHE_TTL_SECONDS")) {
+        options.ttl = chrono::seconds(strtoll(ttl, nullptr, 10));
+    }
+    if (const char* ttl = getenv("NEO_NEGATIVE_TTL_SECONDS")) {
+        options.negative_ttl = chrono::seconds(strtoll(ttl, nullptr, 10));
+    }
+    return options;
+}
+
+bool is_past_date(const string& date) {
+    time_t now = time(nullptr);
+    tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char today[16];
+    strftime(today, sizeof(today), "%Y-%m-%d", &utc);
+    // YYYY-MM-DD strings order the same way as the dates they spell
+    return date < today;
+}
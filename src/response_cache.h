@@ -0,0 +1,102 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Settings for a ResponseCache
+struct CacheOptions {
+    std::string directory = ".neo_cache";
+    std::chrono::seconds ttl{3600};   // freshness of today's and future dates; past dates never expire
+    size_t memory_entries = 64;       // size of the in-memory LRU tier
+    std::chrono::seconds negative_ttl{900};   // how long a "no NEO data" result is remembered
+};
+
+// Hit/miss counters for a ResponseCache
+struct CacheStats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;
+    uint64_t misses = 0;
+    uint64_t expired = 0;
+    uint64_t stores = 0;
+    uint64_t raw_bytes_stored = 0;    // response bytes written to disk before compression
+    uint64_t disk_bytes_stored = 0;   // bytes the compressed entries occupy on disk
+    uint64_t negative_hits = 0;       // lookups answered by a remembered "no NEO data" result
+    uint64_t stale_hits = 0;          // expired entries handed out by get_stale
+};
+
+// Two-tier cache of API responses keyed by (endpoint, date): an in-memory LRU in front of
+// content-addressed, zlib-compressed files on disk. Files are written atomically (rename into
+// place), so an interrupted run never leaves a truncated entry behind. Safe to use from several
+// threads.
+class ResponseCache {
+public:
+    explicit ResponseCache(const CacheOptions& options = CacheOptions());
+
+    // Returns the cached body, or nothing when the entry is missing or expired
+    std::optional<std::string> get(const std::string& endpoint, const std::string& date);
+
+    // Returns the cached body even when it has expired; for answering while a refresh is running
+    std::optional<std::string> get_stale(const std::string& endpoint, const std::string& date);
+
+    // Hands the cached body to onChunk, e.g. a streaming parser, without returning a copy. A disk
+    // entry is inflated and verified before any of it is passed on. Returns false when the entry
+    // is missing, expired or corrupt.
+    bool stream(const std::string& endpoint, const std::string& date,
+                const std::function<void(const char*, size_t)>& onChunk);
+
+    // True when a fresh entry exists; does not load the body or touch the counters
+    bool contains(const std::string& endpoint, const std::string& date);
+
+    // Stores a body in both tiers; returns the size of the compressed file on disk
+    size_t put(const std::string& endpoint, const std::string& date, const std::string& body);
+
+    // Remembers that the key has no NEO data, for CacheOptions::negative_ttl
+    void put_negative(const std::string& endpoint, const std::string& date);
+
+    // True while a "no NEO data" result for the key is remembered
+    bool is_negative(const std::string& endpoint, const std::string& date);
+
+    CacheStats stats() const;
+    const CacheOptions& options() const { return options_; }
+
+    // Hex digest naming the on-disk entry for a key
+    static std::string key_digest(const std::string& endpoint, const std::string& date);
+
+private:
+    struct Entry {
+        std::string key;
+        std::string body;
+        int64_t stored_at;   // unix seconds
+        bool permanent;
+    };
+
+    bool is_fresh(int64_t storedAt, bool permanent) const;
+    bool lookup(const std::string& endpoint, const std::string& date,
+                const std::function<void(const char*, size_t)>& onChunk, bool allowStale = false);
+    std::string path_for(const std::string& digest) const;
+    std::string negative_path_for(const std::string& digest) const;
+    void remember(const std::string& key, std::string body, int64_t storedAt, bool permanent);
+
+    CacheOptions options_;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::unordered_map<std::string, int64_t> negatives_;   // key -> stored_at
+    CacheStats stats_;
+};
+
+// Builds cache options from NEO_CACHE_DIR, NEO_CACHE_TTL_SECONDS and NEO_NEGATIVE_TTL_SECONDS,
+// falling back to the defaults
+CacheOptions cache_options_from_env();
+
+// True when the date (YYYY-MM-DD) lies before today (UTC); such feed days never change
+bool is_past_date(const std::string& date);
+
+#endif // RESPONSE_CACHE_H
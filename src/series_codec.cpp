@@ -0,0 +1,234 @@
+#include <cstring>
+#include <numeric>
+#include "series_codec.h"
+
+using namespace std;
+
+namespace {
+
+// Delta-of-delta buckets: a prefix, then the zigzagged change in this many bits
+const unsigned SMALL_CHANGE_BITS = 16;
+const unsigned MEDIUM_CHANGE_BITS = 32;
+const unsigned LARGE_CHANGE_BITS = 64;
+
+// XOR window fields: leading zeros (capped) and meaningful bits - 1
+const unsigned LEADING_BITS = 5;
+const unsigned LEADING_CAP = 31;
+const unsigned LENGTH_BITS = 6;
+
+class BitWriter {
+public:
+    explicit BitWriter(vector<uint64_t>& words) : words_(words) {}
+
+    uint64_t position() const { return position_; }
+
+    // Appends the low `bits` bits of value (1-64), most significant first
+    void write(uint64_t value, unsigned bits) {
+        if (bits < 64) value &= (uint64_t(1) << bits) - 1;
+        unsigned used = static_cast<unsigned>(position_ % 64);
+        if (used == 0) words_.push_back(0);
+        unsigned room = 64 - used;
+        if (bits <= room) {
+            words_.back() |= value << (room - bits);
+        } else {
+            words_.back() |= value >> (bits - room);
+            words_.push_back(value << (64 - (bits - room)));
+        }
+        position_ += bits;
+    }
+
+private:
+    vector<uint64_t>& words_;
+    uint64_t position_ = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const vector<uint64_t>& words, uint64_t position) : words_(words.data()), position_(position) {}
+
+    // Next `bits` bits (1-64)
+    uint64_t read(unsigned bits) {
+        size_t word = static_cast<size_t>(position_ / 64);
+        unsigned used = static_cast<unsigned>(position_ % 64);
+        uint64_t value = words_[word] << used;
+        if (used + bits > 64) value |= words_[word + 1] >> (64 - used);
+        position_ += bits;
+        return value >> (64 - bits);
+    }
+
+    bool bit() { return read(1) != 0; }
+
+private:
+    const uint64_t* words_;
+    uint64_t position_;
+};
+
+uint64_t zigzag(uint64_t value) {
+    return (value << 1) ^ (0 - (value >> 63));
+}
+
+uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+uint64_t magnitude(int64_t value) {
+    return value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+}
+
+uint64_t bits_of(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double double_of(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+unsigned leading_zeros(uint64_t value) {
+    unsigned count = 0;
+    while (count < 64 && !(value & (uint64_t(1) << (63 - count)))) ++count;
+    return count;
+}
+
+unsigned trailing_zeros(uint64_t value) {
+    unsigned count = 0;
+    while (count < 64 && !(value & (uint64_t(1) << count))) ++count;
+    return count;
+}
+
+// Function to code one block of timestamps. Arithmetic wraps modulo 2^64 on both sides, so any
+// int64 values round-trip.
+void encode_timestamp_block(BitWriter& out, const int64_t* values, size_t count) {
+    out.write(static_cast<uint64_t>(values[0]), 64);
+    // The largest step dividing every delta, so minute-rounded epochs code in minutes
+    uint64_t step = 0;
+    for (size_t i = 1; i < count; ++i) {
+        step = gcd(step, magnitude(static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]))));
+    }
+    if (step == 0 || step > static_cast<uint64_t>(INT64_MAX)) step = 1;
+    out.write(step, 64);
+    int64_t previous = 0;
+    for (size_t i = 1; i < count; ++i) {
+        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1])) /
+                        static_cast<int64_t>(step);
+        uint64_t change = zigzag(static_cast<uint64_t>(delta) - static_cast<uint64_t>(previous));
+        if (change == 0) {
+            out.write(0, 1);
+        } else if (change >> SMALL_CHANGE_BITS == 0) {
+            out.write(0b10, 2);
+            out.write(change, SMALL_CHANGE_BITS);
+        } else if (change >> MEDIUM_CHANGE_BITS == 0) {
+            out.write(0b110, 3);
+            out.write(change, MEDIUM_CHANGE_BITS);
+        } else {
+            out.write(0b111, 3);
+            out.write(change, LARGE_CHANGE_BITS);
+        }
+        previous = delta;
+    }
+}
+
+void encode_double_block(BitWriter& out, const double* values, size_t count) {
+    uint64_t previous = bits_of(values[0]);
+    out.write(previous, 64);
+    unsigned windowLeading = 64, windowTrailing = 0;   // no window yet
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t current = bits_of(values[i]);
+        uint64_t x = current ^ previous;
+        previous = current;
+        if (x == 0) {
+            out.write(0, 1);
+            continue;
+        }
+        unsigned leading = min(leading_zeros(x), LEADING_CAP);
+        unsigned trailing = trailing_zeros(x);
+        if (windowLeading < 64 && leading >= windowLeading && trailing >= windowTrailing) {
+            out.write(0b10, 2);
+            out.write(x >> windowTrailing, 64 - windowLeading - windowTrailing);
+        } else {
+            unsigned meaningful = 64 - leading - trailing;
+            out.write(0b11, 2);
+            out.write(leading, LEADING_BITS);
+            out.write(meaningful - 1, LENGTH_BITS);
+            out.write(x >> trailing, meaningful);
+            windowLeading = leading;
+            windowTrailing = trailing;
+        }
+    }
+}
+
+// Function to code every block of a column with encodeBlock
+template <typename T, typename EncodeBlock>
+EncodedSeries encode_blocks(const T* values, size_t count, EncodeBlock encodeBlock) {
+    EncodedSeries series;
+    series.count = count;
+    BitWriter out(series.bits);
+    for (size_t first = 0; first < count; first += SERIES_BLOCK) {
+        series.block_starts.push_back(out.position());
+        encodeBlock(out, values + first, min(SERIES_BLOCK, count - first));
+    }
+    return series;
+}
+
+} // namespace
+
+EncodedSeries encode_timestamps(const int64_t* values, size_t count) {
+    return encode_blocks(values, count, encode_timestamp_block);
+}
+
+EncodedSeries encode_doubles(const double* values, size_t count) {
+    return encode_blocks(values, count, encode_double_block);
+}
+
+size_t decode_timestamp_block(const EncodedSeries& series, size_t block, int64_t* out) {
+    size_t count = series.block_size(block);
+    BitReader in(series.bits, series.block_starts[block]);
+    uint64_t value = in.read(64);
+    uint64_t step = in.read(64);
+    uint64_t delta = 0;
+    out[0] = static_cast<int64_t>(value);
+    for (size_t i = 1; i < count; ++i) {
+        if (in.bit()) {
+            unsigned bits = !in.bit() ? SMALL_CHANGE_BITS : !in.bit() ? MEDIUM_CHANGE_BITS : LARGE_CHANGE_BITS;
+            delta += unzigzag(in.read(bits));
+        }
+        value += delta * step;
+        out[i] = static_cast<int64_t>(value);
+    }
+    return count;
+}
+
+size_t decode_double_block(const EncodedSeries& series, size_t block, double* out) {
+    size_t count = series.block_size(block);
+    BitReader in(series.bits, series.block_starts[block]);
+    uint64_t value = in.read(64);
+    unsigned windowLeading = 64, windowTrailing = 0;
+    out[0] = double_of(value);
+    for (size_t i = 1; i < count; ++i) {
+        if (in.bit()) {
+            if (in.bit()) {
+                windowLeading = static_cast<unsigned>(in.read(LEADING_BITS));
+                unsigned meaningful = static_cast<unsigned>(in.read(LENGTH_BITS)) + 1;
+                windowTrailing = 64 - windowLeading - meaningful;
+            }
+            value ^= in.read(64 - windowLeading - windowTrailing) << windowTrailing;
+        }
+        out[i] = double_of(value);
+    }
+    return count;
+}
+
+void decode_timestamps(const EncodedSeries& series, int64_t* out) {
+    for (size_t block = 0; block < series.block_count(); ++block) {
+        decode_timestamp_block(series, block, out + block * SERIES_BLOCK);
+    }
+}
+
+void decode_doubles(const EncodedSeries& series, double* out) {
+    for (size_t block = 0; block < series.block_count(); ++block) {
+        decode_double_block(series, block, out + block * SERIES_BLOCK);
+    }
+}
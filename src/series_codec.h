@@ -0,0 +1,41 @@
+#ifndef SERIES_CODEC_H
+#define SERIES_CODEC_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Values per block of an EncodedSeries
+const size_t SERIES_BLOCK = 1024;
+
+// A column of numbers compressed in blocks of SERIES_BLOCK values. Every block starts from a raw
+// value, so blocks decode independently: a scan decodes one block into a small buffer, runs its
+// loop over the buffer and moves on, and never holds the whole column decoded.
+//   - timestamps: delta-of-delta. Each block records the largest step that divides all of its
+//     deltas (60000 for epochs rounded to the minute), then codes each change of delta, in
+//     steps, in 1 bit when it is 0 and otherwise in 18, 35 or 67 bits by size
+//   - doubles: XOR with the previous value (Gorilla). An equal value costs 1 bit, otherwise
+//     the meaningful bits of the XOR are written, reusing the previous window when they fit
+struct EncodedSeries {
+    std::vector<uint64_t> bits;             // the bit stream, most significant bit first
+    std::vector<uint64_t> block_starts;     // bit position of each block
+    size_t count = 0;
+
+    size_t block_count() const { return block_starts.size(); }
+    size_t block_size(size_t block) const { return std::min(SERIES_BLOCK, count - block * SERIES_BLOCK); }
+    size_t bytes() const { return (bits.size() + block_starts.size()) * sizeof(uint64_t); }
+};
+
+EncodedSeries encode_timestamps(const int64_t* values, size_t count);
+EncodedSeries encode_doubles(const double* values, size_t count);
+
+// Decode one block into out, which must have room for block_size(block) values; return that size
+size_t decode_timestamp_block(const EncodedSeries& series, size_t block, int64_t* out);
+size_t decode_double_block(const EncodedSeries& series, size_t block, double* out);
+
+// Decode the whole series into out, which must have room for series.count values
+void decode_timestamps(const EncodedSeries& series, int64_t* out);
+void decode_doubles(const EncodedSeries& series, double* out);
+
+#endif // SERIES_CODEC_H
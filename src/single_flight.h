@@ -0,0 +1,61 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+
+// Coalesces concurrent calls for the same key: the first caller runs the work, and callers that
+// arrive while it is in flight wait for and share its result (or its exception). Once the work
+// finishes the key is forgotten, so later calls run it again.
+template <typename Key, typename Value>
+class SingleFlight {
+public:
+    // Runs work() for key unless a call for the same key is already in flight
+    template <typename Work>
+    Value run(const Key& key, Work work) {
+        std::promise<Value> promise;
+        std::shared_future<Value> pending;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = inFlight_.find(key);
+            if (found != inFlight_.end()) {
+                pending = found->second;
+                ++coalesced_;
+            } else {
+                pending = promise.get_future().share();
+                inFlight_.emplace(key, pending);
+                leader = true;
+            }
+        }
+        if (!leader) {
+            return pending.get();
+        }
+
+        try {
+            promise.set_value(work());
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inFlight_.erase(key);
+        }
+        return pending.get();
+    }
+
+    // Number of calls that were served by another caller's request
+    uint64_t coalesced() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return coalesced_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::map<Key, std::shared_future<Value>> inFlight_;
+    uint64_t coalesced_ = 0;
+};
+
+#endif // SINGLE_FLIGHT_H